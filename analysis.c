@@ -48,6 +48,7 @@ When analyzing in the background, various menus are disabled so the user does no
 #include <stdlib.h>
 
 #include "backgammon.h"
+#include "book.h"
 #include "drawboard.h"
 #include "eval.h"
 #if defined(USE_GTK)
@@ -106,155 +107,227 @@ GetRating(const float rError)
     return RAT_UNDEFINED;
 }
 
-static float
-LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, const evalcontext * pec)
-{
-
-    TanBoard anBoardTemp;
-    int i, j;
-    float aar[6][6], ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
-    cubeinfo ciOpp;
-    movelist ml;
+/*
+ * The analysis memo.
+ *
+ * Luck analysis finds the best move for all 21 rolls before every move,
+ * and the same positions come up again and again in a match: every game
+ * starts from the same position, the openings repeat, and so on.  While a
+ * game or match is analysed the value of each roll is kept here, keyed
+ * by everything it depends on.  The memo is only used by LuckAnalysis(),
+ * which AnalyzeMove() calls with the exclusive lock held.
+ */
 
-    /* first with player pci->fMove on roll */
+typedef struct {
+    positionkey key;
+    cubeinfo ci;
+    int anDice[2];
+    int anEval[4];              /* fCubeful, nPlies, fUsePrune, fDeterministic */
+    float rNoise;
+} memokey;
 
-    memcpy(&ciOpp, pci, sizeof(cubeinfo));
-    ciOpp.fMove = !pci->fMove;
+typedef struct {
+    memokey k;
+    float r;
+} memoitem;
 
-    for (i = 0; i < 6; i++)
-        for (j = 0; j < i; j++) {
-            memcpy(&anBoardTemp[0][0], &anBoard[0][0], 2 * 25 * sizeof(int));
+/* enough for the positions that come up in many games */
+#define MAX_MEMO_ITEMS 65536
 
-            /* Find the best move for each roll at ply 0 only. */
-            if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
-                                   pci, pec, defaultFilters) < 0) {
-                g_free(ml.amMoves);
-                return ERR_VAL;
-            }
+static GHashTable *phMemo;
 
-            if (!ml.cMoves) {
+static guint
+HashMemoKey(gconstpointer p)
+{
+    const guint32 *pn = p;
+    guint h = 0;
+    unsigned int i;
 
-                SwapSides(anBoardTemp);
+    for (i = 0; i < sizeof(memokey) / sizeof(guint32); i++)
+        h = h * 31 + pn[i];
 
-                if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ciOpp, pec) < 0)
-                    return ERR_VAL;
+    return h;
+}
 
-                if (pec->fCubeful) {
-                    if (pci->nMatchTo)
-                        aar[i][j] = -mwc2eq(ar[OUTPUT_CUBEFUL_EQUITY], &ciOpp);
-                    else
-                        aar[i][j] = -ar[OUTPUT_CUBEFUL_EQUITY];
-                } else
-                    aar[i][j] = -ar[OUTPUT_EQUITY];
+static gboolean
+EqualMemoKey(gconstpointer p0, gconstpointer p1)
+{
+    return !memcmp(p0, p1, sizeof(memokey));
+}
 
-            } else {
-                aar[i][j] = ml.amMoves[0].rScore;
-                g_free(ml.amMoves);
-            }
+static void
+StartAnalysisMemo(void)
+{
+    phMemo = g_hash_table_new_full(HashMemoKey, EqualMemoKey, NULL, g_free);
+}
 
-            rMean += aar[i][j];
+static void
+EndAnalysisMemo(void)
+{
+    g_hash_table_destroy(phMemo);
+    phMemo = NULL;
+}
 
-        }
+static void
+MemoKey(memokey * pk, const TanBoard anBoard, int n0, int n1, const cubeinfo * pci, const evalcontext * pec)
+{
+    memset(pk, 0, sizeof(*pk));
+    PositionKey(anBoard, &pk->key);
+    memcpy(&pk->ci, pci, sizeof(cubeinfo));
+    pk->anDice[0] = MAX(n0, n1);
+    pk->anDice[1] = MIN(n0, n1);
+    pk->anEval[0] = pec->fCubeful;
+    pk->anEval[1] = pec->nPlies;
+    pk->anEval[2] = pec->fUsePrune;
+    pk->anEval[3] = pec->fDeterministic;
+    pk->rNoise = pec->rNoise;
+}
+
+/* The equity for the player on roll after the best move for n0-n1.  If
+ * pmlKeep is given, the memo is bypassed and the moves found are handed
+ * back in it. */
+static int
+BestMoveValue(float *pr, const TanBoard anBoard, int n0, int n1, const cubeinfo * pci, const evalcontext * pec,
+              movelist * pmlKeep)
+{
+    memokey k;
+    movelist ml;
 
-    /* with other player on roll */
+    if (phMemo && !pmlKeep) {
+        const memoitem *pmi;
 
-    for (i = 0; i < 6; i++)
-        for (j = i + 1; j < 6; j++) {
-            memcpy(&anBoardTemp[0][0], &anBoard[0][0], 2 * 25 * sizeof(int));
-            SwapSides(anBoardTemp);
+        MemoKey(&k, anBoard, n0, n1, pci, pec);
+        if ((pmi = g_hash_table_lookup(phMemo, &k)) != NULL) {
+            *pr = pmi->r;
+            return 0;
+        }
+    }
 
-            /* Find the best move for each roll at ply 0 only. */
-            if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
-                                   &ciOpp, pec, defaultFilters) < 0) {
-                g_free(ml.amMoves);
-                return ERR_VAL;
-            }
+    /* Find the best move for each roll at ply 0 only. */
+    if (FindnSaveBestMoves(&ml, n0, n1, anBoard, NULL, 0.0f, pci, pec, defaultFilters) < 0) {
+        g_free(ml.amMoves);
+        return -1;
+    }
 
-            if (!ml.cMoves) {
+    if (!ml.cMoves) {
+        TanBoard anBoardTemp;
+        float ar[NUM_ROLLOUT_OUTPUTS];
+        cubeinfo ciOpp;
 
-                SwapSides(anBoardTemp);
+        memcpy(&ciOpp, pci, sizeof(cubeinfo));
+        ciOpp.fMove = !pci->fMove;
 
-                if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, pci, pec) < 0)
-                    return ERR_VAL;
+        memcpy(anBoardTemp, anBoard, sizeof(TanBoard));
+        SwapSides(anBoardTemp);
 
-                if (pec->fCubeful) {
-                    if (pci->nMatchTo)
-                        aar[i][j] = mwc2eq(ar[OUTPUT_CUBEFUL_EQUITY], pci);
-                    else
-                        aar[i][j] = ar[OUTPUT_CUBEFUL_EQUITY];
-                } else
-                    aar[i][j] = ar[OUTPUT_EQUITY];
+        if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ciOpp, pec) < 0)
+            return -1;
 
-            } else {
-                aar[i][j] = -ml.amMoves[0].rScore;
-                g_free(ml.amMoves);
-            }
+        if (pec->fCubeful) {
+            if (pci->nMatchTo)
+                *pr = -mwc2eq(ar[OUTPUT_CUBEFUL_EQUITY], &ciOpp);
+            else
+                *pr = -ar[OUTPUT_CUBEFUL_EQUITY];
+        } else
+            *pr = -ar[OUTPUT_EQUITY];
 
-            rMean += aar[i][j];
+    } else {
+        *pr = ml.amMoves[0].rScore;
+        if (pmlKeep)
+            *pmlKeep = ml;
+        else
+            g_free(ml.amMoves);
+    }
 
-        }
+    if (phMemo && !pmlKeep && g_hash_table_size(phMemo) < MAX_MEMO_ITEMS) {
+        memoitem *pmi = g_new(memoitem, 1);
 
-    if (n0 > n1)
-        return aar[n0][n1] - rMean / 30.0f;
-    else
-        return aar[n1][n0] - rMean / 30.0f;
+        pmi->k = k;
+        pmi->r = *pr;
+        g_hash_table_insert(phMemo, &pmi->k, pmi);
+    }
 
+    return 0;
 }
 
 static float
-LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo * pci, const evalcontext * pec)
+LuckFirst(const TanBoard anBoard, const int n0, const int n1, cubeinfo * pci, const evalcontext * pec,
+          movelist * pmlPlayed)
 {
 
     TanBoard anBoardTemp;
     int i, j;
-    float aar[6][6], ar[NUM_ROLLOUT_OUTPUTS], rMean = 0.0f;
+    float aar[6][6], rMean = 0.0f;
     cubeinfo ciOpp;
-    movelist ml;
+
+    /* first with player pci->fMove on roll */
 
     memcpy(&ciOpp, pci, sizeof(cubeinfo));
     ciOpp.fMove = !pci->fMove;
 
     for (i = 0; i < 6; i++)
-        for (j = 0; j <= i; j++) {
-            memcpy(&anBoardTemp[0][0], &anBoard[0][0], 2 * 25 * sizeof(int));
+        for (j = 0; j < i; j++) {
+            if (BestMoveValue(&aar[i][j], anBoard, i + 1, j + 1, pci, pec,
+                              (i == n0 && j == n1) ? pmlPlayed : NULL) < 0)
+                return ERR_VAL;
 
-            /* Find the best move for each roll at ply 0 only. */
-            if (FindnSaveBestMoves(&ml, i + 1, j + 1, (ConstTanBoard) anBoardTemp, NULL, 0.0f,
-                                   pci, pec, defaultFilters) < 0) {
-                g_free(ml.amMoves);
+            rMean += aar[i][j];
+        }
+
+    /* with other player on roll */
+
+    memcpy(&anBoardTemp[0][0], &anBoard[0][0], 2 * 25 * sizeof(int));
+    SwapSides(anBoardTemp);
+
+    for (i = 0; i < 6; i++)
+        for (j = i + 1; j < 6; j++) {
+            if (BestMoveValue(&aar[i][j], (ConstTanBoard) anBoardTemp, i + 1, j + 1, &ciOpp, pec, NULL) < 0)
                 return ERR_VAL;
-            }
 
-            if (!ml.cMoves) {
+            aar[i][j] = -aar[i][j];
+            rMean += aar[i][j];
+        }
+
+    if (n0 > n1)
+        return aar[n0][n1] - rMean / 30.0f;
+    else
+        return aar[n1][n0] - rMean / 30.0f;
 
-                SwapSides(anBoardTemp);
+}
 
-                if (GeneralEvaluationE(ar, (ConstTanBoard) anBoardTemp, &ciOpp, pec) < 0)
-                    return ERR_VAL;
+static float
+LuckNormal(const TanBoard anBoard, const int n0, const int n1, const cubeinfo * pci, const evalcontext * pec,
+           movelist * pmlPlayed)
+{
 
-                if (pec->fCubeful) {
-                    if (pci->nMatchTo)
-                        aar[i][j] = -mwc2eq(ar[OUTPUT_CUBEFUL_EQUITY], &ciOpp);
-                    else
-                        aar[i][j] = -ar[OUTPUT_CUBEFUL_EQUITY];
-                } else
-                    aar[i][j] = -ar[OUTPUT_EQUITY];
+    int i, j;
+    float aar[6][6], rMean = 0.0f;
 
-            } else {
-                aar[i][j] = ml.amMoves[0].rScore;
-                g_free(ml.amMoves);
-            }
+    for (i = 0; i < 6; i++)
+        for (j = 0; j <= i; j++) {
+            if (BestMoveValue(&aar[i][j], anBoard, i + 1, j + 1, pci, pec,
+                              (i == n0 && j == n1) ? pmlPlayed : NULL) < 0)
+                return ERR_VAL;
 
             rMean += (i == j) ? aar[i][j] : aar[i][j] * 2.0f;
-
         }
 
     return aar[n0][n1] - rMean / 36.0f;
 
 }
 
-extern float
-LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
+/* Whether the chequer play analysis with pesChequer would repeat the
+ * luck analysis search for the roll played.  At 0-ply the move filters
+ * and the move played make no difference to the search. */
+static int
+ShareLuckSearch(const evalsetup * pesChequer)
+{
+    return fAnalyseDice && pesChequer->et == EVAL_EVAL && pesChequer->ec.nPlies == 0
+        && !cmp_evalcontext(&pesChequer->ec, &ecLuck) && !fBook;
+}
+
+static float
+LuckAnalysisMove(const TanBoard anBoard, int n0, int n1, matchstate * pms, movelist * pmlPlayed)
 {
     cubeinfo ci;
     int is_init_board;
@@ -268,9 +341,15 @@ LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
         swap(&n0, &n1);
 
     if (is_init_board && n0 != n1)      /* FIXME: this fails if we return to the initial position after a few moves */
-        return LuckFirst(anBoard, n0, n1, &ci, &ecLuck);
+        return LuckFirst(anBoard, n0, n1, &ci, &ecLuck, pmlPlayed);
     else
-        return LuckNormal(anBoard, n0, n1, &ci, &ecLuck);
+        return LuckNormal(anBoard, n0, n1, &ci, &ecLuck, pmlPlayed);
+}
+
+extern float
+LuckAnalysis(const TanBoard anBoard, int n0, int n1, matchstate * pms)
+{
+    return LuckAnalysisMove(anBoard, n0, n1, pms, NULL);
 }
 
 extern lucktype
@@ -620,6 +699,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
     taketype tt;
     const xmovegameinfo *pmgi = &((moverecord *) plParentGame->plNext->p)->g;
     int is_initial_position = 1;
+    movelist mlLuck = { 0, 0, 0, 0, 0.0f, NULL };
 
     /* analyze this move */
 
@@ -683,7 +763,15 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         /* luck analysis */
 
         if (fAnalyseDice) {
-            pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
+            /* luck is stored without its settings; keep it if asked to */
+            if (!fAnalyseIncremental || pmr->rLuck == ERR_VAL) {
+                /* the chequer play analysis below may reuse the search for the roll played */
+                int fShare = fAnalyseMove && ShareLuckSearch(pesChequer)
+                    && cmp_evalsetup(pesChequer, &pmr->esChequer) > 0;
+
+                pmr->rLuck = LuckAnalysisMove((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms,
+                                              fShare ? &mlLuck : NULL);
+            }
             pmr->lt = Luck(pmr->rLuck);
         }
 
@@ -709,21 +797,28 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
                 {
                     movelist ml;
-                    MT_Release();
-                    if (FindnSaveBestMoves(&ml, pmr->anDice[0],
-                                           pmr->anDice[1],
-                                           (ConstTanBoard) pms->anBoard, &key,
-                                           arSkillLevel[SKILL_DOUBTFUL], &ci, &pesChequer->ec, aamf) < 0) {
-                        g_free(ml.amMoves);
-                        return -1;
+
+                    if (mlLuck.amMoves) {
+                        ml = mlLuck;
+                        mlLuck.amMoves = NULL;
+                    } else {
+                        MT_Release();
+                        if (FindnSaveBestMoves(&ml, pmr->anDice[0],
+                                               pmr->anDice[1],
+                                               (ConstTanBoard) pms->anBoard, &key,
+                                               arSkillLevel[SKILL_DOUBTFUL], &ci, &pesChequer->ec, aamf) < 0) {
+                            g_free(ml.amMoves);
+                            return -1;
+                        }
+                        MT_Exclusive();
                     }
-                    MT_Exclusive();
                     CopyMoveList(&pmr->ml, &ml);
                     if (ml.cMoves) {
                         g_free(ml.amMoves);
                     }
                 }
 
+                pmr->esChequer = *pesChequer;
             }
 
             for (pmr->n.iMove = 0; pmr->n.iMove < pmr->ml.cMoves; pmr->n.iMove++)
@@ -734,9 +829,10 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
                 }
 
             pmr->n.stMove = Skill(rChequerSkill);
-            pmr->esChequer = *pesChequer;
         }
 
+        g_free(mlLuck.amMoves);
+
         if (psc)
             updateStatcontext(psc, pmr, pms, plParentGame);
 
@@ -856,12 +952,11 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
                 getResignation(pmr->r.arResign, pms->anBoard, &ci, pesCube);
 
+                pmr->r.esResign = *pesCube;
             }
 
             getResignEquities(pmr->r.arResign, &ci, pmr->r.nResigned, &rBefore, &rAfter);
 
-            pmr->r.esResign = *pesCube;
-
             pmr->r.stResign = pmr->r.stAccept = SKILL_NONE;
 
             if (rAfter < rBefore) {
@@ -894,7 +989,9 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         GetMatchStateCubeInfo(&ci, pms);
 
         if (fAnalyseDice) {
-            pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
+            /* luck is stored without its settings; keep it if asked to */
+            if (!fAnalyseIncremental || pmr->rLuck == ERR_VAL)
+                pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
             pmr->lt = Luck(pmr->rLuck);
         }
 
@@ -1037,6 +1134,7 @@ AnalyzeGame(listOLD * plGame, int wait)
 
         multi_debug("wait for all task: analysis");
         result = MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis);
+        MT_WriteTrace("analysis");
 
         if (result == -1)
             IniStatcontext(psc);
@@ -1200,7 +1298,9 @@ CommandAnalyseGame(char *UNUSED(sz))
 #endif
         ProgressStartValue(_("Analysing game"), nMoves);
 
+    StartAnalysisMemo();
     AnalyzeGame(plGame, TRUE);
+    EndAnalysisMemo();
 
     ProgressEnd();
 
@@ -1262,6 +1362,7 @@ CommandAnalyseMatch(char *UNUSED(sz))
     }
 
     IniStatcontext(&scMatch);
+    StartAnalysisMemo();
 
     for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
 
@@ -1278,6 +1379,8 @@ CommandAnalyseMatch(char *UNUSED(sz))
 
     multi_debug("wait for all task: analysis");
     MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis);
+    MT_WriteTrace("analysis");
+    EndAnalysisMemo();
 
     ProgressEnd();
 
@@ -2715,3 +2818,99 @@ CommandAnalyseRolloutMatch(char *UNUSED(sz))
 
     cmark_match_rollout(&lMatch);
 }
+
+/*
+ * Add the analysed cube decisions and moves of the current match to a
+ * position book, optionally only for the first moves of each game.
+ */
+
+extern void
+CommandBookAdd(char *sz)
+{
+    char *szFile, *pch;
+    int nMoves = 0;
+    int cCube = 0, cMoveList = 0;
+    bookbuilder *pbb;
+    GError *error = NULL;
+    listOLD *pl;
+    int fReopen;
+
+    if (!(szFile = NextToken(&sz)) || !*szFile) {
+        outputl(_("You must specify a position book file (see `help book add')."));
+        return;
+    }
+
+    if ((pch = NextToken(&sz)) && (nMoves = ParseNumber(&pch)) < 1) {
+        outputl(_("The number of moves per game must be a positive number."));
+        return;
+    }
+
+    if (ListEmpty(&lMatch)) {
+        outputl(_("No match is being played."));
+        return;
+    }
+
+    if (!(pbb = BookBuilderNew(szFile, &error))) {
+        outputerrf("%s", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+        listOLD *plGame = pl->p;
+        listOLD *plm;
+        matchstate msBook;
+        int cMoves = 0;
+
+        for (plm = plGame->plNext; plm != plGame; plm = plm->plNext) {
+            moverecord *pmr = plm->p;
+            cubeinfo ci;
+
+            FixMatchState(&msBook, pmr);
+
+            if (pmr->mt == MOVE_NORMAL || pmr->mt == MOVE_DOUBLE) {
+                if (nMoves && cMoves >= nMoves)
+                    break;
+
+                if (pmr->fPlayer != msBook.fMove) {
+                    SwapSides(msBook.anBoard);
+                    msBook.fMove = pmr->fPlayer;
+                }
+
+                GetMatchStateCubeInfo(&ci, &msBook);
+
+                if (pmr->CubeDecPtr->esDouble.et != EVAL_NONE)
+                    cCube += BookBuilderAddCube(pbb, (ConstTanBoard) msBook.anBoard, &ci,
+                                                pmr->CubeDecPtr->aarOutput,
+                                                BookQuality(pmr->CubeDecPtr->esDouble.et,
+                                                            &pmr->CubeDecPtr->esDouble.ec));
+
+                if (pmr->mt == MOVE_NORMAL) {
+                    cMoveList += BookBuilderAddMoves(pbb, (ConstTanBoard) msBook.anBoard, (int) pmr->anDice[0],
+                                                     (int) pmr->anDice[1], &ci, &pmr->ml);
+                    cMoves++;
+                }
+            }
+
+            ApplyMoveRecord(&msBook, plGame, pmr);
+        }
+    }
+
+    /* the book may be the one in use, which must not be mapped while replaced */
+    fReopen = BookGetFile() && !strcmp(BookGetFile(), szFile);
+    if (fReopen)
+        BookClose();
+
+    if (!BookBuilderWrite(pbb, &error)) {
+        outputerrf("%s", error->message);
+        g_clear_error(&error);
+    } else
+        outputf(_("%d cube decisions and %d move lists added to %s.\n"), cCube, cMoveList, szFile);
+
+    if (fReopen && BookOpen(szFile, &error) < 0) {
+        outputerrf("%s", error->message);
+        g_error_free(error);
+    }
+
+    BookBuilderFree(pbb);
+}
@@ -337,6 +337,7 @@ extern const char szDefaultPrompt[];
 extern char *szLang;
 extern const char *szPrompt;
 extern const char *szHomeDirectory;
+extern char *szProgramPath;
 extern evalcontext ecLuck;
 extern evalsetup esAnalysisChequer;
 extern evalsetup esAnalysisCube;
@@ -374,6 +375,7 @@ extern int fCubeUse;
 extern int fDisplay;
 extern int fFullScreen;
 extern int fGotoFirstGame;
+extern int fSGFIndex;
 extern int fInvertMET;
 extern int fJacoby;
 extern int fNextTurn;
@@ -390,6 +392,7 @@ extern int nThreadPriority;
 extern int nToolbarStyle;
 extern int nTutorSkillCurrent;
 extern int fBackgroundAnalysis; /* define whether to analyze in the background */
+extern int fAnalyseIncremental; /* keep stored luck when reanalysing */
 extern int fAnalysisRunning; /* when analyzing a match in background */
 #if defined(USE_BOARD3D)
 extern int fSync;
@@ -562,8 +565,10 @@ extern void CommandAnnotateUnlucky(char *);
 extern void CommandAnnotateVeryBad(char *);
 extern void CommandAnnotateVeryLucky(char *);
 extern void CommandAnnotateVeryUnlucky(char *);
+extern void CommandBookAdd(char *);
 extern void CommandCalibrate(char *);
 extern void CommandClearCache(char *);
+extern void CommandClearEngineStats(char *);
 extern void CommandClearHint(char *);
 extern void CommandClearTurn(char *);
 extern void CommandCMarkCubeSetNone(char *);
@@ -585,11 +590,17 @@ extern void CommandDrop(char *);
 extern void CommandEndGame(char *);
 extern void CommandEq2MWC(char *);
 extern void CommandEval(char *);
+extern void CommandExportArchiveHtml(char *);
+extern void CommandExportArchiveLaTeX(char *);
+extern void CommandExportArchivePDF(char *);
+extern void CommandExportArchivePS(char *);
+extern void CommandExportArchiveText(char *);
 extern void CommandExportGameGam(char *);
 extern void CommandExportGameSnowieTxt(char *);
 extern void CommandExportGameHtml(char *);
 extern void CommandExportGameLaTeX(char *);
 extern void CommandExportGamePDF(char *);
+extern void CommandExportGamePNG(char *);
 extern void CommandExportGamePS(char *);
 extern void CommandExportGameText(char *);
 extern void CommandExportHTMLImages(char *);
@@ -598,6 +609,7 @@ extern void CommandExportMatchLaTeX(char *);
 extern void CommandExportMatchMat(char *);
 extern void CommandExportMatchSnowieTxt(char *);
 extern void CommandExportMatchPDF(char *);
+extern void CommandExportMatchPNG(char *);
 extern void CommandExportMatchPS(char *);
 extern void CommandExportMatchText(char *);
 extern void CommandExportPositionGammOnLine(char *);
@@ -628,8 +640,10 @@ extern void CommandImportSnowieTxt(char *);
 extern void CommandImportTMG(char *);
 extern void CommandListGame(char *);
 extern void CommandListMatch(char *);
+extern void CommandLoadBenchmark(char *);
 extern void CommandLoadCommands(char *);
 extern void CommandLoadGame(char *);
+extern void CommandLoadGames(char *);
 extern void CommandLoadMatch(char *);
 extern void CommandLoadPosition(char *);
 extern void CommandLoadPython(char *);
@@ -645,6 +659,7 @@ extern void CommandPrevious(char *);
 extern void CommandQuit(char *);
 extern void CommandRedouble(char *);
 extern void CommandReject(char *);
+extern void CommandRelationalAddDirectory(char *);
 extern void CommandRelationalAddMatch(char *);
 extern void CommandRelationalEraseAll(char *);
 extern void CommandRelationalErase(char *);
@@ -660,11 +675,13 @@ extern void CommandSaveGame(char *);
 extern void CommandSaveMatch(char *);
 extern void CommandSavePosition(char *);
 extern void CommandSaveSettings(char *);
+extern void CommandSelfPlay(char *);
 extern void CommandSetAnalysisChequerplay(char *);
 extern void CommandSetAnalysisCube(char *);
 extern void CommandSetAnalysisCubedecision(char *);
 extern void CommandSetAnalysisFileSetting(char*);
 extern void CommandSetAnalysisBackground(char *);
+extern void CommandSetAnalysisIncremental(char *);
 extern void CommandSetAnalysisLimit(char *);
 extern void CommandSetAnalysisLuckAnalysis(char *);
 extern void CommandSetAnalysisLuck(char *);
@@ -695,8 +712,10 @@ extern void CommandSetAutoSaveRollout(char *sz);
 extern void CommandSetAutoSaveTime(char *sz);
 extern void CommandSetBeavers(char *);
 extern void CommandSetBoard(char *);
+extern void CommandSetBook(char *);
 extern void CommandSetBrowser(char *);
 extern void CommandSetCache(char *);
+extern void CommandSetEngineStatsLog(char *);
 extern void CommandSetCalibration(char *);
 extern void CommandSetCheatEnable(char *);
 extern void CommandSetCheatPlayer(char *);
@@ -854,6 +873,7 @@ extern void CommandSetRNGIsaac(char *);
 extern void CommandSetRNGManual(char *);
 extern void CommandSetRNGMD5(char *);
 extern void CommandSetRNGMersenne(char *);
+extern void CommandSetRNGPhilox(char *);
 extern void CommandSetRNGRandomDotOrg(char *);
 extern void CommandSetRolloutBearoffTruncationExact(char *);
 extern void CommandSetRolloutBearoffTruncationOS(char *);
@@ -891,6 +911,8 @@ extern void CommandSetRolloutPlayerMoveFilter(char *);
 extern void CommandSetRolloutPlayersAreSame(char *);
 extern void CommandSetRolloutRNG(char *);
 extern void CommandSetRolloutRotate(char *);
+extern void CommandSetRolloutShardCommand(char *);
+extern void CommandSetRolloutShards(char *);
 extern void CommandSetRolloutSeed(char *);
 extern void CommandSetRolloutTrials(char *);
 extern void CommandSetRolloutTruncation(char *);
@@ -911,6 +933,7 @@ extern void CommandSetScoreMapColour(char*);
 extern void CommandSetScoreMapLayout(char*);
 extern void CommandSetSeed(char *);
 extern void CommandSetSGFFolder(char *);
+extern void CommandSetSGFIndex(char *);
 extern void CommandSetSoundEnable(char *);
 extern void CommandSetSoundSoundAgree(char *);
 extern void CommandSetSoundSoundAnalysisFinished(char *);
@@ -934,7 +957,9 @@ extern void CommandSetSoundSystemCommand(char *);
 extern void CommandSetStyledGameList(char *);
 extern void CommandSetMarkedSamePlayer(char *);
 extern void CommandSetTheoryWindow(char *);
+extern void CommandSetNuma(char *);
 extern void CommandSetThreads(char *);
+extern void CommandSetThreadTrace(char *);
 extern void CommandSetToolbar(char *);
 extern void CommandSetTurn(char *);
 extern void CommandSetTutorChequer(char *);
@@ -957,6 +982,7 @@ extern void CommandShowAutomatic(char *);
 extern void CommandShowBearoff(char *);
 extern void CommandShowBeavers(char *);
 extern void CommandShowBoard(char *);
+extern void CommandShowBook(char *);
 extern void CommandShowBrowser(char *);
 extern void CommandShowBuildInfo(char *);
 extern void CommandShowCache(char *);
@@ -978,6 +1004,7 @@ extern void CommandShowEvaluation(char *);
 extern void CommandShowExport(char *);
 extern void CommandShowFullBoard(char *);
 extern void CommandShowGammonValues(char *);
+extern void CommandShowGames(char *);
 extern void CommandShowGeometry(char *);
 extern void CommandShowHistory(char *);
 extern void CommandShowJacoby(char *);
@@ -1007,12 +1034,14 @@ extern void CommandShowScore(char *);
 extern void CommandShowScoreSheet(char *);
 extern void CommandShowSeed(char *);
 extern void CommandShowSound(char *);
+extern void CommandShowStartup(char *);
 extern void CommandShowStatisticsGame(char *);
 extern void CommandShowStatisticsMatch(char *);
 extern void CommandShowStatisticsSession(char *);
 extern void CommandShowTemperatureMap(char *);
 extern void CommandShowScoreMap(char *);
 extern void CommandShowThorp(char *);
+extern void CommandShowNuma(char *);
 extern void CommandShowThreads(char *);
 extern void CommandShowTurn(char *);
 extern void CommandShowTutor(char *);
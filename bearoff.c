@@ -232,7 +232,7 @@ GenerateBearoff(unsigned char *p, unsigned int nId)
 }
 
 static unsigned char *
-HeuristicDatabase(void (*pfProgress) (unsigned int))
+HeuristicDatabase(void)
 {
     unsigned char *pm = malloc(40 + 54264 * 64);
     unsigned char *p;
@@ -246,19 +246,52 @@ HeuristicDatabase(void (*pfProgress) (unsigned int))
     for (i = 2; i < 64; i++)
         p[i] = 0;
 
-    for (i = 1; i < 54264; i++) {
+    for (i = 1; i < 54264; i++)
         GenerateBearoff(p, i);
-        if (pfProgress && !(i % 1000))
-            pfProgress(i);
-    }
 
     return pm;
 }
 
+/* The heuristic database is only used when no one-sided database is
+ * installed, and generating it takes a noticeable time, so it is
+ * built by whichever thread first needs it and shared from then on. */
+
+static unsigned char *pHeuristic = NULL;
+G_LOCK_DEFINE_STATIC(heuristic);
+
+static const unsigned char *
+HeuristicData(void)
+{
+    unsigned char *p;
+
+    G_LOCK(heuristic);
+    if (!(p = pHeuristic)) {
+        p = HeuristicDatabase();
+        g_atomic_pointer_set(&pHeuristic, p);
+    }
+    G_UNLOCK(heuristic);
+
+    return p;
+}
+
+static inline const unsigned char *
+BearoffData(const bearoffcontext * pbc)
+{
+    if (pbc->fHeuristic) {
+        const unsigned char *p = g_atomic_pointer_get(&pHeuristic);
+
+        return p ? p : HeuristicData();
+    }
+
+    return pbc->p;
+}
+
 
 static void
 ReadBearoffFile(const bearoffcontext * pbc, unsigned int offset, unsigned char *buf, unsigned int nBytes)
 {
+    ++MT_Get_engineStats()->cBearoffDisk;
+
     MT_Exclusive();
 
     if ((fseek(pbc->pf, (long) offset, SEEK_SET) < 0) || (fread(buf, 1, nBytes, pbc->pf) < nBytes)) {
@@ -282,6 +315,8 @@ ReadTwoSidedBearoff(const bearoffcontext * pbc, const unsigned int iPos, float a
     unsigned char ac[8];
     unsigned char *pc = NULL;
 
+    ++MT_Get_engineStats()->cBearoffRead;
+
     if (pbc->p)
         pc = pbc->p + 40 + 2 * iPos * k;
     else {
@@ -341,6 +376,8 @@ ReadHypergammon(const bearoffcontext * pbc, const unsigned int iPos, float arOut
     int i;
     const int x = 28;
 
+    ++MT_Get_engineStats()->cBearoffRead;
+
     if (pbc->p)
         pc = pbc->p + 40 + x * iPos;
     else {
@@ -501,6 +538,11 @@ BearoffStatus(const bearoffcontext * pbc, char *sz)
         else
             sprintf(buf, _("On disk 2-sided exact %u-chequer Hypergammon database evaluator"), pbc->nChequers);
 
+    } else if (pbc->fHeuristic) {
+        if (g_atomic_pointer_get(&pHeuristic))
+            sprintf(buf, _("In memory heuristic %u-sided bearoff database evaluator"), pbc->bt);
+        else
+            sprintf(buf, _("Heuristic %u-sided bearoff database evaluator (built when first used)"), pbc->bt);
     } else {
         if (pbc->p)
             sprintf(buf, _("In memory %u-sided bearoff database evaluator"), pbc->bt);
@@ -733,6 +775,13 @@ BearoffClose(bearoffcontext * pbc)
     if (pbc->p)
         free(pbc->p);
 
+    if (pbc->fHeuristic) {
+        G_LOCK(heuristic);
+        free(pHeuristic);
+        g_atomic_pointer_set(&pHeuristic, NULL);
+        G_UNLOCK(heuristic);
+    }
+
     if (pbc->szFilename)
         g_free(pbc->szFilename);
 
@@ -791,7 +840,7 @@ InvalidDb(bearoffcontext * pbc)
  *
  */
 extern bearoffcontext *
-BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned int))
+BearoffInit(const char *szFilename, const unsigned int bo)
 {
     bearoffcontext *pbc;
     char sz[41];
@@ -803,7 +852,7 @@ BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned i
         pbc->nPoints = HEURISTIC_P;
         pbc->nChequers = HEURISTIC_C;
         pbc->fHeuristic = TRUE;
-        pbc->p = HeuristicDatabase(p);
+        /* the data are generated on first use; see BearoffData() */
         return pbc;
     }
 
@@ -1130,16 +1179,17 @@ static unsigned short int *
 GetDistUncompressed(unsigned short int aus[64], const bearoffcontext * pbc, const unsigned int nPosID)
 {
     unsigned char ac[128];
-    unsigned char *puch;
+    const unsigned char *p = BearoffData(pbc);
+    const unsigned char *puch;
     unsigned int iOffset;
 
     /* read from file */
 
     iOffset = 40 + 64 * nPosID * (pbc->fGammon ? 2 : 1);
 
-    if (pbc->p)
+    if (p)
         /* from memory */
-        puch = pbc->p + iOffset;
+        puch = p + iOffset;
     else {
         /* from disk */
 
@@ -1185,6 +1235,9 @@ BearoffDist(const bearoffcontext * pbc, const unsigned int nPosID,
 {
     g_return_val_if_fail(pbc, -1);
     g_return_val_if_fail(pbc->bt == BEAROFF_ONESIDED, -1);
+
+    ++MT_Get_engineStats()->cBearoffRead;
+
     if (pbc->fND)
         return ReadBearoffOneSidedND(pbc, nPosID, arProb, arGammonProb, ar, ausProb, ausGammonProb);
     else
@@ -57,7 +57,7 @@ enum bearoffoptions {
     BO_HEURISTIC = 8
 };
 
-extern bearoffcontext *BearoffInit(const char *szFilename, const unsigned int bo, void (*p) (unsigned int));
+extern bearoffcontext *BearoffInit(const char *szFilename, const unsigned int bo);
 
 extern int
  BearoffEval(const bearoffcontext * pbc, const TanBoard anBoard, float arOutput[]);
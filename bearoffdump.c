@@ -96,7 +96,7 @@ main(int argc, char **argv)
     /* This is needed since we call ReadBearoffFile() from bearoff.c */
     MT_InitThreads();
 
-    if (!(pbc = BearoffInit(filename, BO_NONE, NULL))) {
+    if (!(pbc = BearoffInit(filename, BO_NONE))) {
         g_print(_("Failed to initialise bearoff database %s\n"), filename);
         exit(-1);
     }
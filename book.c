@@ -0,0 +1,613 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Position book.
+ *
+ * The file holds a header, the entries sorted by key, then the rows the
+ * entries point to. A cube entry has two rows: the no double and the
+ * double, take evaluations as returned by GeneralCubeDecisionE(). A move
+ * entry has one row per book move: the key of the position after the
+ * move and its evaluation, as stored in move.arEvalMove.
+ *
+ * Integers and floats are in native byte order; a book written on a
+ * machine of the other endianness is refused.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n.h>
+
+#include "book.h"
+#include "positionid.h"
+#include "multithread.h"
+
+#define BOOK_MAGIC "GNUbg book\n"
+#define BOOK_VERSION 1
+#define BOOK_ORDER 0x01020304
+#define BOOK_MAX_MOVES 16
+
+typedef struct {
+    char szMagic[16];
+    guint32 nVersion;
+    guint32 cEntries;
+    guint32 cRows;
+    guint32 nOrder;
+} bookheader;
+
+/* everything that affects the evaluation besides the board */
+typedef struct {
+    guint8 nMatchTo;
+    guint8 anScore[2];          /* player on roll first */
+    guint8 nCubeLog;
+    guint8 fCubeOwner;          /* 0 centred, 1 player on roll, 2 opponent */
+    guint8 fFlags;              /* Crawford, Jacoby, beavers, variation */
+    guint8 anDice[2];           /* (0, 0) for a cube decision */
+} bookcontext;
+
+typedef struct {
+    positionkey key;
+    bookcontext bc;
+} bookkey;
+
+typedef struct {
+    bookkey k;
+    guint32 iRow;
+    guint16 cRows;
+    guint8 nQuality;
+    guint8 unused;
+} bookentry;
+
+typedef struct {
+    positionkey key;
+    float ar[NUM_ROLLOUT_OUTPUTS];
+} bookrow;
+
+/* builder entries */
+typedef struct {
+    bookkey k;
+    unsigned int nQuality;
+    unsigned int cRows;
+    bookrow arow[BOOK_MAX_MOVES];
+} bookitem;
+
+struct _bookbuilder {
+    char *szFile;
+    GHashTable *ph;
+};
+
+int fBook = FALSE;
+
+static GMappedFile *pmfBook = NULL;
+static char *szBookFile = NULL;
+static const bookentry *aEntries;
+static const bookrow *aRows;
+static guint32 cEntries;
+
+/* Check that the entries only refer to rows of the book, so that
+ * lookups need not */
+static int
+ValidEntries(const bookentry * ae, guint32 cEntries, guint32 cRows)
+{
+    guint32 i;
+
+    for (i = 0; i < cEntries; i++) {
+        const bookentry *pe = &ae[i];
+
+        if (!pe->nQuality || !pe->cRows || (guint64) pe->iRow + pe->cRows > cRows
+            || (!pe->k.bc.anDice[0] && pe->cRows != 2))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static GMappedFile *
+MapBook(const char *szFile, const bookentry ** ppe, const bookrow ** ppr, guint32 * pcEntries, GError ** ppError)
+{
+    GMappedFile *pmf;
+    const bookheader *ph;
+    gsize cb;
+
+    if (!(pmf = g_mapped_file_new(szFile, FALSE, ppError)))
+        return NULL;
+
+    cb = g_mapped_file_get_length(pmf);
+    ph = (const bookheader *) g_mapped_file_get_contents(pmf);
+
+    if (cb < sizeof(bookheader) || memcmp(ph->szMagic, BOOK_MAGIC, sizeof(BOOK_MAGIC))
+        || ph->nVersion != BOOK_VERSION || ph->nOrder != BOOK_ORDER
+        || cb != sizeof(bookheader) + (guint64) ph->cEntries * sizeof(bookentry)
+        + (guint64) ph->cRows * sizeof(bookrow)) {
+        g_set_error(ppError, G_FILE_ERROR, G_FILE_ERROR_INVAL, _("%s: not a position book for this machine"),
+                    szFile);
+        g_mapped_file_unref(pmf);
+        return NULL;
+    }
+
+    *ppe = (const bookentry *) (ph + 1);
+    *ppr = (const bookrow *) (*ppe + ph->cEntries);
+    *pcEntries = ph->cEntries;
+
+    if (!ValidEntries(*ppe, ph->cEntries, ph->cRows)) {
+        g_set_error(ppError, G_FILE_ERROR, G_FILE_ERROR_INVAL, _("%s: corrupt position book"), szFile);
+        g_mapped_file_unref(pmf);
+        return NULL;
+    }
+
+    return pmf;
+}
+
+extern int
+BookOpen(const char *szFile, GError ** ppError)
+{
+    GMappedFile *pmf;
+    const bookentry *pe;
+    const bookrow *pr;
+    guint32 c;
+
+    if (!(pmf = MapBook(szFile, &pe, &pr, &c, ppError)))
+        return -1;
+
+    BookClose();
+
+    pmfBook = pmf;
+    szBookFile = g_strdup(szFile);
+    aEntries = pe;
+    aRows = pr;
+    cEntries = c;
+    fBook = TRUE;
+
+    return 0;
+}
+
+extern void
+BookClose(void)
+{
+    fBook = FALSE;
+
+    if (pmfBook) {
+        g_mapped_file_unref(pmfBook);
+        pmfBook = NULL;
+    }
+    g_free(szBookFile);
+    szBookFile = NULL;
+    cEntries = 0;
+}
+
+extern const char *
+BookGetFile(void)
+{
+    return szBookFile;
+}
+
+extern void
+BookCounts(unsigned int *pcCube, unsigned int *pcMove)
+{
+    guint32 i;
+
+    *pcCube = *pcMove = 0;
+
+    for (i = 0; i < cEntries; i++)
+        if (aEntries[i].k.bc.anDice[0])
+            ++*pcMove;
+        else
+            ++*pcCube;
+}
+
+static int
+MakeKey(bookkey * pk, const TanBoard anBoard, const cubeinfo * pci, int nDice0, int nDice1)
+{
+    int nCubeLog = 0;
+
+    if (pci->nMatchTo > 255 || pci->anScore[0] > 255 || pci->anScore[1] > 255)
+        return FALSE;
+
+    while ((1 << nCubeLog) < pci->nCube && nCubeLog < 15)
+        nCubeLog++;
+    if ((1 << nCubeLog) != pci->nCube)
+        return FALSE;
+
+    /* the key is compared bytewise, so clear any padding */
+    memset(pk, 0, sizeof(bookkey));
+    PositionKey(anBoard, &pk->key);
+
+    pk->bc.nMatchTo = (guint8) pci->nMatchTo;
+    if (pci->nMatchTo) {
+        pk->bc.anScore[0] = (guint8) pci->anScore[pci->fMove];
+        pk->bc.anScore[1] = (guint8) pci->anScore[!pci->fMove];
+        pk->bc.fFlags = pci->fCrawford ? 1 : 0;
+    } else
+        pk->bc.fFlags = (pci->fJacoby ? 2 : 0) | (pci->fBeavers ? 4 : 0);
+    pk->bc.fFlags |= (guint8) (pci->bgv << 3);
+
+    pk->bc.nCubeLog = (guint8) nCubeLog;
+    if (pci->fCubeOwner == -1)
+        pk->bc.fCubeOwner = 0;
+    else
+        pk->bc.fCubeOwner = pci->fCubeOwner == pci->fMove ? 1 : 2;
+
+    pk->bc.anDice[0] = (guint8) MAX(nDice0, nDice1);
+    pk->bc.anDice[1] = (guint8) MIN(nDice0, nDice1);
+
+    return TRUE;
+}
+
+static const bookentry *
+FindEntry(const bookkey * pk)
+{
+    guint32 lo = 0, hi = cEntries;
+
+    while (lo < hi) {
+        guint32 mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(&aEntries[mid].k, pk, sizeof(bookkey));
+
+        if (!cmp)
+            return &aEntries[mid];
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
+/*
+ * Look up the cube decision for the player on roll in anBoard.
+ *
+ * Returns TRUE and fills aarOutput as GeneralCubeDecisionE() would if
+ * the position is in the book with an evaluation at least as deep as
+ * pec asks for.
+ */
+
+extern int
+BookLookupCube(const TanBoard anBoard, const cubeinfo * pci, const evalcontext * pec,
+               float aarOutput[2][NUM_ROLLOUT_OUTPUTS])
+{
+    bookkey k;
+    const bookentry *pe;
+
+    ++MT_Get_engineStats()->cBookLookup;
+
+    if (!MakeKey(&k, anBoard, pci, 0, 0) || !(pe = FindEntry(&k)) || pe->cRows != 2
+        || pe->nQuality < BookQuality(EVAL_EVAL, pec))
+        return FALSE;
+
+    memcpy(aarOutput[0], aRows[pe->iRow].ar, sizeof(aRows[pe->iRow].ar));
+    memcpy(aarOutput[1], aRows[pe->iRow + 1].ar, sizeof(aRows[pe->iRow + 1].ar));
+
+    ++MT_Get_engineStats()->cBookHit;
+    return TRUE;
+}
+
+/*
+ * Look up the moves in pml, the legal moves for nDice0 and nDice1 in
+ * anBoard. The book moves get their book evaluation, marked with the
+ * quality of the book entry, and are moved to the front of the list.
+ * For code that only looks at the evaluation type and context, they are
+ * labelled as evaluated with pec at the ply the entry came from, or at
+ * pec's ply for rolled out entries.  Entries evaluated at fewer plies
+ * than pec asks for are not used.
+ *
+ * Returns the number of book moves, not sorted.
+ */
+
+extern unsigned int
+BookLookupMoves(movelist * pml, const TanBoard anBoard, int nDice0, int nDice1, const cubeinfo * pci,
+                const evalcontext * pec)
+{
+    bookkey k;
+    const bookentry *pe;
+    unsigned int i, j, cFound = 0;
+
+    ++MT_Get_engineStats()->cBookLookup;
+
+    if (!MakeKey(&k, anBoard, pci, nDice0, nDice1) || !(pe = FindEntry(&k))
+        || pe->nQuality < BookQuality(EVAL_EVAL, pec))
+        return 0;
+
+    for (i = 0; i < pml->cMoves && cFound < pe->cRows; i++)
+        for (j = 0; j < pe->cRows; j++) {
+            const bookrow *pr = &aRows[pe->iRow + j];
+
+            if (EqualKeys(pr->key, pml->amMoves[i].key)) {
+                move *pm = &pml->amMoves[i];
+                move m;
+
+                memcpy(pm->arEvalMove, pr->ar, sizeof(pr->ar));
+                memset(pm->arEvalStdDev, 0, sizeof(pm->arEvalStdDev));
+                pm->esMove.et = EVAL_EVAL;
+                pm->esMove.ec = *pec;
+                if (pe->nQuality < BookQuality(EVAL_ROLLOUT, NULL))
+                    pm->esMove.ec.nPlies = pe->nQuality - 1U;
+                pm->esMove.prc = NULL;
+                pm->esMove.nBook = pe->nQuality;
+                pm->rScore = pec->fCubeful ? pr->ar[OUTPUT_CUBEFUL_EQUITY] : pr->ar[OUTPUT_EQUITY];
+                pm->rScore2 = pr->ar[OUTPUT_EQUITY];
+
+                m = *pm;
+                *pm = pml->amMoves[cFound];
+                pml->amMoves[cFound++] = m;
+                break;
+            }
+        }
+
+    if (cFound)
+        ++MT_Get_engineStats()->cBookHit;
+
+    return cFound;
+}
+
+/* How much an evaluation can be trusted; 0 for none */
+extern int
+BookQuality(evaltype et, const evalcontext * pec)
+{
+    switch (et) {
+    case EVAL_ROLLOUT:
+        return 255;
+    case EVAL_EVAL:
+        return MIN((int) pec->nPlies, 250) + 1;
+    default:
+        return 0;
+    }
+}
+
+/* The quality of the evaluation of a move; book moves keep the quality
+ * of the entry they were taken from */
+extern int
+BookMoveQuality(const moveevalsetup * pmes)
+{
+    return pmes->nBook ? pmes->nBook : BookQuality(pmes->et, &pmes->ec);
+}
+
+static guint
+HashKey(gconstpointer p)
+{
+    const guint32 *pn = p;
+    guint h = 0;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(bookkey) / sizeof(guint32); i++)
+        h = h * 31 + pn[i];
+
+    return h;
+}
+
+static gboolean
+EqualKey(gconstpointer p0, gconstpointer p1)
+{
+    return !memcmp(p0, p1, sizeof(bookkey));
+}
+
+/* Store pbi unless a better evaluation is already present */
+static int
+AddItem(bookbuilder * pbb, bookitem * pbi)
+{
+    const bookitem *pbiOld = g_hash_table_lookup(pbb->ph, &pbi->k);
+
+    if (pbiOld && pbiOld->nQuality > pbi->nQuality) {
+        g_free(pbi);
+        return FALSE;
+    }
+
+    g_hash_table_replace(pbb->ph, &pbi->k, pbi);
+    return TRUE;
+}
+
+/*
+ * Start building a book; the entries of szFile, if it exists, are
+ * kept unless replaced by better evaluations.
+ */
+
+extern bookbuilder *
+BookBuilderNew(const char *szFile, GError ** ppError)
+{
+    bookbuilder *pbb = g_new(bookbuilder, 1);
+
+    pbb->szFile = g_strdup(szFile);
+    pbb->ph = g_hash_table_new_full(HashKey, EqualKey, NULL, g_free);
+
+    if (g_file_test(szFile, G_FILE_TEST_EXISTS)) {
+        GMappedFile *pmf;
+        const bookentry *ae;
+        const bookrow *ar;
+        guint32 c, i;
+
+        if (!(pmf = MapBook(szFile, &ae, &ar, &c, ppError))) {
+            BookBuilderFree(pbb);
+            return NULL;
+        }
+
+        for (i = 0; i < c; i++) {
+            bookitem *pbi = g_new(bookitem, 1);
+
+            pbi->k = ae[i].k;
+            pbi->nQuality = ae[i].nQuality;
+            pbi->cRows = MIN(ae[i].cRows, BOOK_MAX_MOVES);
+            memcpy(pbi->arow, ar + ae[i].iRow, pbi->cRows * sizeof(bookrow));
+            g_hash_table_replace(pbb->ph, &pbi->k, pbi);
+        }
+
+        g_mapped_file_unref(pmf);
+    }
+
+    return pbb;
+}
+
+extern int
+BookBuilderAddCube(bookbuilder * pbb, const TanBoard anBoard, const cubeinfo * pci,
+                   float aarOutput[2][NUM_ROLLOUT_OUTPUTS], int nQuality)
+{
+    bookitem *pbi;
+
+    if (nQuality <= 0)
+        return FALSE;
+
+    pbi = g_new0(bookitem, 1);
+    if (!MakeKey(&pbi->k, anBoard, pci, 0, 0)) {
+        g_free(pbi);
+        return FALSE;
+    }
+
+    pbi->nQuality = (unsigned int) nQuality;
+    pbi->cRows = 2;
+    memcpy(pbi->arow[0].ar, aarOutput[0], sizeof(pbi->arow[0].ar));
+    memcpy(pbi->arow[1].ar, aarOutput[1], sizeof(pbi->arow[1].ar));
+
+    return AddItem(pbb, pbi);
+}
+
+/*
+ * Add the evaluated moves of pml, which must be sorted best first.
+ * Only the moves evaluated at least as well as the best move are kept.
+ */
+
+extern int
+BookBuilderAddMoves(bookbuilder * pbb, const TanBoard anBoard, int nDice0, int nDice1, const cubeinfo * pci,
+                    const movelist * pml)
+{
+    bookitem *pbi;
+    int nQuality;
+    unsigned int i;
+
+    if (!pml->cMoves || (nQuality = BookMoveQuality(&pml->amMoves[0].esMove)) <= 0)
+        return FALSE;
+
+    pbi = g_new0(bookitem, 1);
+    if (!MakeKey(&pbi->k, anBoard, pci, nDice0, nDice1)) {
+        g_free(pbi);
+        return FALSE;
+    }
+
+    pbi->nQuality = (unsigned int) nQuality;
+    for (i = 0; i < pml->cMoves && pbi->cRows < BOOK_MAX_MOVES; i++)
+        if (BookMoveQuality(&pml->amMoves[i].esMove) >= nQuality) {
+            bookrow *pr = &pbi->arow[pbi->cRows++];
+
+            pr->key = pml->amMoves[i].key;
+            memcpy(pr->ar, pml->amMoves[i].arEvalMove, sizeof(pr->ar));
+        }
+
+    return AddItem(pbb, pbi);
+}
+
+static gint
+CompareItems(gconstpointer p0, gconstpointer p1)
+{
+    const bookitem *pbi0 = *(const bookitem * const *) p0;
+    const bookitem *pbi1 = *(const bookitem * const *) p1;
+
+    return memcmp(&pbi0->k, &pbi1->k, sizeof(bookkey));
+}
+
+static void
+CollectItem(gpointer UNUSED(key), gpointer value, gpointer data)
+{
+    g_ptr_array_add(data, value);
+}
+
+/*
+ * Write the book. It is written to a temporary file first, so the
+ * book being replaced must not be open on systems that cannot rename
+ * over a mapped file.
+ */
+
+extern int
+BookBuilderWrite(bookbuilder * pbb, GError ** ppError)
+{
+    GPtrArray *pa = g_ptr_array_new();
+    char *szTmp = g_strdup_printf("%s.tmp", pbb->szFile);
+    bookheader bh;
+    FILE *pf;
+    guint32 i, iRow = 0;
+    int fOK;
+
+    g_hash_table_foreach(pbb->ph, CollectItem, pa);
+    g_ptr_array_sort(pa, CompareItems);
+
+    memset(&bh, 0, sizeof(bh));
+    memcpy(bh.szMagic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    bh.nVersion = BOOK_VERSION;
+    bh.nOrder = BOOK_ORDER;
+    bh.cEntries = pa->len;
+    for (i = 0; i < pa->len; i++)
+        bh.cRows += ((bookitem *) g_ptr_array_index(pa, i))->cRows;
+
+    if (!(pf = g_fopen(szTmp, "wb"))) {
+        g_set_error(ppError, G_FILE_ERROR, g_file_error_from_errno(errno), "%s: %s", szTmp, g_strerror(errno));
+        g_ptr_array_free(pa, TRUE);
+        g_free(szTmp);
+        return FALSE;
+    }
+
+    fwrite(&bh, sizeof(bh), 1, pf);
+
+    for (i = 0; i < pa->len; i++) {
+        const bookitem *pbi = g_ptr_array_index(pa, i);
+        bookentry be;
+
+        memset(&be, 0, sizeof(be));
+        be.k = pbi->k;
+        be.iRow = iRow;
+        be.cRows = (guint16) pbi->cRows;
+        be.nQuality = (guint8) pbi->nQuality;
+        fwrite(&be, sizeof(be), 1, pf);
+        iRow += pbi->cRows;
+    }
+
+    for (i = 0; i < pa->len; i++) {
+        const bookitem *pbi = g_ptr_array_index(pa, i);
+
+        fwrite(pbi->arow, sizeof(bookrow), pbi->cRows, pf);
+    }
+
+    fOK = !ferror(pf);
+    if (fclose(pf))
+        fOK = FALSE;
+
+    if (fOK) {
+        /* rename() does not replace an existing file on Windows */
+        g_unlink(pbb->szFile);
+        fOK = !g_rename(szTmp, pbb->szFile);
+    }
+
+    if (!fOK) {
+        g_set_error(ppError, G_FILE_ERROR, g_file_error_from_errno(errno), "%s: %s", pbb->szFile,
+                    g_strerror(errno));
+        g_unlink(szTmp);
+    }
+
+    g_ptr_array_free(pa, TRUE);
+    g_free(szTmp);
+
+    return fOK;
+}
+
+extern void
+BookBuilderFree(bookbuilder * pbb)
+{
+    g_hash_table_destroy(pbb->ph);
+    g_free(pbb->szFile);
+    g_free(pbb);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <glib.h>
+
+#include "eval.h"
+
+/*
+ * Position book.
+ *
+ * A book is a sorted file of positions, each with the cube and score
+ * context it applies to, holding either the cube decision equities or
+ * the best moves for one roll. It is memory mapped and searched by
+ * bisection, so it can be consulted before any evaluation.
+ */
+
+typedef struct _bookbuilder bookbuilder;
+
+extern int fBook;
+
+extern int BookOpen(const char *szFile, GError ** ppError);
+extern void BookClose(void);
+extern const char *BookGetFile(void);
+extern void BookCounts(unsigned int *pcCube, unsigned int *pcMove);
+
+extern int BookLookupCube(const TanBoard anBoard, const cubeinfo * pci, const evalcontext * pec,
+                          float aarOutput[2][NUM_ROLLOUT_OUTPUTS]);
+extern unsigned int BookLookupMoves(movelist * pml, const TanBoard anBoard, int nDice0, int nDice1,
+                                    const cubeinfo * pci, const evalcontext * pec);
+
+extern int BookQuality(evaltype et, const evalcontext * pec);
+extern int BookMoveQuality(const moveevalsetup * pmes);
+extern bookbuilder *BookBuilderNew(const char *szFile, GError ** ppError);
+extern int BookBuilderAddCube(bookbuilder * pbb, const TanBoard anBoard, const cubeinfo * pci,
+                              float aarOutput[2][NUM_ROLLOUT_OUTPUTS], int nQuality);
+extern int BookBuilderAddMoves(bookbuilder * pbb, const TanBoard anBoard, int nDice0, int nDice1,
+                               const cubeinfo * pci, const movelist * pml);
+extern int BookBuilderWrite(bookbuilder * pbb, GError ** ppError);
+extern void BookBuilderFree(bookbuilder * pbb);
+
+#endif
@@ -42,6 +42,12 @@ static void PyDisconnect(void);
 static RowSet *PySelect(const char *str);
 static int PyUpdateCommand(const char *str);
 static void PyCommit(void);
+static int PyBegin(void);
+static void *PyPrepare(const char *str);
+static int PyExecute(void *stmt, const DBValue * av, int cValues);
+static int PyBuffered(void *stmt);
+static void PyTruncate(void *stmt, int cRows);
+static int PyFinalize(void *stmt);
 static int PyPostgreConnect(const char *dbfilename, const char *user, const char *password, const char *hostname);
 static GList *PyPostgreGetDatabaseList(const char *user, const char *password, const char *hostname);
 static int PyPostgreDeleteDatabase(const char *dbfilename, const char *user, const char *password,
@@ -55,6 +61,10 @@ static void SQLiteDisconnect(void);
 static RowSet *SQLiteSelect(const char *str);
 static int SQLiteUpdateCommand(const char *str);
 static void SQLiteCommit(void);
+static int SQLiteBegin(void);
+static void *SQLitePrepare(const char *str);
+static int SQLiteExecute(void *stmt, const DBValue * av, int cValues);
+static int SQLiteFinalize(void *stmt);
 #endif
 
 #if NUM_PROVIDERS
@@ -68,6 +78,12 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Select = SQLiteSelect,
 	.UpdateCommand = SQLiteUpdateCommand,
 	.Commit = SQLiteCommit,
+	.Begin = SQLiteBegin,
+	.Prepare = SQLitePrepare,
+	.Execute = SQLiteExecute,
+	.Finalize = SQLiteFinalize,
+	.Buffered = NULL,
+	.Truncate = NULL,
 	.GetDatabaseList = SQLiteGetDatabaseList,
 	.DeleteDatabase = SQLiteDeleteDatabase,
 	.name = "SQLite",
@@ -89,6 +105,12 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
 	.Commit = PyCommit,
+	.Begin = PyBegin,
+	.Prepare = PyPrepare,
+	.Execute = PyExecute,
+	.Finalize = PyFinalize,
+	.Buffered = PyBuffered,
+	.Truncate = PyTruncate,
 	.GetDatabaseList = SQLiteGetDatabaseList,
 	.DeleteDatabase = SQLiteDeleteDatabase,
 	.name = "SQLite (Python)",
@@ -108,6 +130,12 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
 	.Commit = PyCommit,
+	.Begin = PyBegin,
+	.Prepare = PyPrepare,
+	.Execute = PyExecute,
+	.Finalize = PyFinalize,
+	.Buffered = PyBuffered,
+	.Truncate = PyTruncate,
 	.GetDatabaseList = PyMySQLGetDatabaseList,
 	.DeleteDatabase = PyMySQLDeleteDatabase,
 	.name = "MySQL (Python)",
@@ -126,6 +154,12 @@ static DBProvider providers[NUM_PROVIDERS] = {
 	.Select = PySelect,
 	.UpdateCommand = PyUpdateCommand,
 	.Commit = PyCommit,
+	.Begin = PyBegin,
+	.Prepare = PyPrepare,
+	.Execute = PyExecute,
+	.Finalize = PyFinalize,
+	.Buffered = PyBuffered,
+	.Truncate = PyTruncate,
 	.GetDatabaseList = PyPostgreGetDatabaseList,
 	.DeleteDatabase = PyPostgreDeleteDatabase,
 	.name = "PostgreSQL (Python)",
@@ -148,6 +182,12 @@ DBProvider providers[1] = {
 	.Select = NULL,
 	.UpdateCommand = NULL,
 	.Commit = NULL,
+	.Begin = NULL,
+	.Prepare = NULL,
+	.Execute = NULL,
+	.Finalize = NULL,
+	.Buffered = NULL,
+	.Truncate = NULL,
 	.GetDatabaseList = NULL,
 	.DeleteDatabase = NULL,
 	.name = "No Providers",
@@ -521,6 +561,102 @@ PyCommit(void)
         PyErr_Print();
 }
 
+static int
+PyBegin(void)
+{                               /* DB-API connections open transactions implicitly */
+    return TRUE;
+}
+
+/* rows are collected and sent with a single executemany() when finalised */
+typedef struct {
+    char *sz;
+    PyObject *pyRows;
+} PyStatement;
+
+static void *
+PyPrepare(const char *str)
+{
+    PyStatement *pst = g_new(PyStatement, 1);
+
+    pst->sz = g_strdup(str);
+    pst->pyRows = PyList_New(0);
+
+    return pst;
+}
+
+static int
+PyExecute(void *stmt, const DBValue * av, int cValues)
+{
+    PyStatement *pst = (PyStatement *) stmt;
+    PyObject *pyRow = PyTuple_New(cValues);
+    int i, ret;
+
+    for (i = 0; i < cValues; i++) {
+        PyObject *pyValue;
+
+        switch (av[i].type) {
+        case DBVAL_INT:
+            pyValue = PyInt_FromLong(av[i].v.i);
+            break;
+        case DBVAL_DOUBLE:
+            pyValue = PyFloat_FromDouble(av[i].v.d);
+            break;
+        case DBVAL_TEXT:
+            pyValue = PyUnicode_FromString(av[i].v.sz);
+            break;
+        default:
+            Py_INCREF(Py_None);
+            pyValue = Py_None;
+            break;
+        }
+        PyTuple_SET_ITEM(pyRow, i, pyValue);
+    }
+
+    ret = PyList_Append(pst->pyRows, pyRow);
+    Py_DECREF(pyRow);
+
+    return ret == 0;
+}
+
+static int
+PyBuffered(void *stmt)
+{
+    return (int) PyList_Size(((PyStatement *) stmt)->pyRows);
+}
+
+static void
+PyTruncate(void *stmt, int cRows)
+{
+    PyStatement *pst = (PyStatement *) stmt;
+
+    if (PyList_SetSlice(pst->pyRows, cRows, PyList_Size(pst->pyRows), NULL) < 0)
+        PyErr_Print();
+}
+
+static int
+PyFinalize(void *stmt)
+{
+    PyStatement *pst = (PyStatement *) stmt;
+    int ret = TRUE;
+
+    if (PyList_Size(pst->pyRows) > 0) {
+        PyObject *pyFunc = PyDict_GetItemString(pdict, "PyExecuteMany");
+        PyObject *pyRet = pyFunc ? PyObject_CallFunction(pyFunc, "sO", pst->sz, pst->pyRows) : NULL;
+
+        if (!pyRet) {
+            PyErr_Print();
+            ret = FALSE;
+        }
+        Py_XDECREF(pyRet);
+    }
+
+    Py_DECREF(pst->pyRows);
+    g_free(pst->sz);
+    g_free(pst);
+
+    return ret;
+}
+
 static RowSet *
 ConvertPythonToRowset(PyObject * v)
 {
@@ -773,6 +909,74 @@ SQLiteUpdateCommand(const char *str)
 static void
 SQLiteCommit(void)
 {                               /* No transaction in sqlite by default */
+    if (!sqlite3_get_autocommit(connection))
+        SQLiteUpdateCommand("COMMIT");
+}
+
+static int
+SQLiteBegin(void)
+{
+    return SQLiteUpdateCommand("BEGIN");
+}
+
+static void *
+SQLitePrepare(const char *str)
+{
+    sqlite3_stmt *pStmt;
+    int ret;
+
+#if SQLITE_VERSION_NUMBER >= 3003011
+    ret = sqlite3_prepare_v2(connection, str, -1, &pStmt, NULL);
+#else
+    ret = sqlite3_prepare(connection, str, -1, &pStmt, NULL);
+#endif
+    if (ret != SQLITE_OK) {
+        outputerrf("SQL error: %s in sqlite3_prepare()\nfrom '%s'", sqlite3_errmsg(connection), str);
+        return NULL;
+    }
+
+    return pStmt;
+}
+
+static int
+SQLiteExecute(void *stmt, const DBValue * av, int cValues)
+{
+    sqlite3_stmt *pStmt = (sqlite3_stmt *) stmt;
+    int i, ret = SQLITE_OK;
+
+    for (i = 0; i < cValues && ret == SQLITE_OK; i++) {
+        switch (av[i].type) {
+        case DBVAL_INT:
+            ret = sqlite3_bind_int(pStmt, i + 1, av[i].v.i);
+            break;
+        case DBVAL_DOUBLE:
+            ret = sqlite3_bind_double(pStmt, i + 1, av[i].v.d);
+            break;
+        case DBVAL_TEXT:
+            ret = sqlite3_bind_text(pStmt, i + 1, av[i].v.sz, -1, SQLITE_TRANSIENT);
+            break;
+        default:
+            ret = sqlite3_bind_null(pStmt, i + 1);
+            break;
+        }
+    }
+
+    if (ret == SQLITE_OK && (ret = sqlite3_step(pStmt)) == SQLITE_DONE)
+        ret = SQLITE_OK;
+
+    if (ret != SQLITE_OK)
+        outputerrf("SQL error: %s in sqlite3_step()\nfrom '%s'", sqlite3_errmsg(connection), sqlite3_sql(pStmt));
+
+    sqlite3_reset(pStmt);
+    sqlite3_clear_bindings(pStmt);
+
+    return (ret == SQLITE_OK);
+}
+
+static int
+SQLiteFinalize(void *stmt)
+{
+    return (sqlite3_finalize((sqlite3_stmt *) stmt) == SQLITE_OK);
 }
 #endif
 
@@ -31,12 +31,42 @@ typedef struct {
     size_t *widths;
 } RowSet;
 
+/* a value bound to a ? placeholder of a prepared statement */
+typedef enum {
+    DBVAL_NULL,
+    DBVAL_INT,
+    DBVAL_DOUBLE,
+    DBVAL_TEXT
+} DBValueType;
+
+typedef struct {
+    DBValueType type;
+    union {
+        int i;
+        double d;
+        const char *sz;
+    } v;
+} DBValue;
+
 typedef struct {
     int (*Connect) (const char *database, const char *user, const char *password, const char *hostname);
     void (*Disconnect) (void);
     RowSet *(*Select) (const char *str);
     int (*UpdateCommand) (const char *str);
     void (*Commit) (void);
+    /* Bulk loading. Begin starts a transaction, ended by Commit.
+     * Execute may buffer its rows until the statement is finalised,
+     * so statements must be finalised in dependency order. */
+    int (*Begin) (void);
+    void *(*Prepare) (const char *str);
+    int (*Execute) (void *stmt, const DBValue * av, int cValues);
+    int (*Finalize) (void *stmt);
+    /* The number of rows Execute has buffered for a statement, and a
+     * way to drop all but the first cRows of them, so that a rollback to
+     * a savepoint can discard them too.  NULL if Execute sends each row
+     * at once. */
+    int (*Buffered) (void *stmt);
+    void (*Truncate) (void *stmt, int cRows);
     GList *(*GetDatabaseList) (const char *user, const char *password, const char *hostname);
     int (*DeleteDatabase) (const char *database, const char *user, const char *password, const char *hostname);
 
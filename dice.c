@@ -50,6 +50,7 @@
 #include "md5.h"
 #include "SFMT.h"
 #include "isaac.h"
+#include "philox.h"
 #include <glib/gstdio.h>
 #include "glib-ext.h"
 
@@ -62,6 +63,7 @@ const char *aszRNG[NUM_RNGS] = {
     "ISAAC",
     "MD5",
     N_("Mersenne Twister"),
+    "Philox",
     N_("manual dice"),
     "www.random.org",
     N_("read from file")
@@ -72,6 +74,7 @@ const char *aszRNGTip[NUM_RNGS] = {
     N_("Bob Jenkins' Indirection, Shift, Accumulate, Add and Count " "cryptographic generator"),
     N_("A generator based on the Message Digest 5 algorithm"),
     N_("Makoto Matsumoto and Mutsuo Saito's generator"),
+    N_("A counter-based generator; every roll of a rollout is computed " "directly from the seed, trial and turn"),
     N_("Enter each dice roll by hand"),
     N_("The online non-deterministic generator from random.org"),
     N_("Dice loaded from a file"),
@@ -95,6 +98,9 @@ struct rngcontext {
     /* RNG_MERSENNE */
     sfmt_t sfmt;
 
+    /* RNG_PHILOX */
+    philoxkey keyPhilox;
+
     /* RNG_BBS */
 
 #if defined(HAVE_LIBGMP)
@@ -353,6 +359,7 @@ PrintRNGCounter(const rng rngx, rngcontext * rngctx)
     case RNG_BBS:
     case RNG_ISAAC:
     case RNG_MD5:
+    case RNG_PHILOX:
         g_print(_("Number of calls since last seed: %lu."), rngctx->c);
         g_print("\n");
 
@@ -440,6 +447,7 @@ PrintRNGSeed(const rng rngx, rngcontext * rngctx)
 
     case RNG_ISAAC:
     case RNG_MERSENNE:
+    case RNG_PHILOX:
 #if defined(HAVE_LIBGMP)
         PrintRNGSeedMP(rngctx->nz);
 #else
@@ -492,6 +500,11 @@ InitRNGSeed(unsigned int n, const rng rngx, rngcontext * rngctx)
         sfmt_init_gen_rand(&rngctx->sfmt, n);
         break;
 
+    case RNG_PHILOX:
+        rngctx->keyPhilox.an[0] = n;
+        rngctx->keyPhilox.an[1] = 0;
+        break;
+
     case RNG_MANUAL:
     case RNG_RANDOM_DOT_ORG:
     case RNG_FILE:
@@ -540,6 +553,21 @@ InitRNGSeedMP(mpz_t n, rng rng, rngcontext * rngctx)
         InitRNGSeed((unsigned int) (mpz_get_ui(n) % UINT_MAX), rng, rngctx);
         break;
 
+    case RNG_PHILOX:{
+            /* the key is the low 64 bits of the seed */
+            mpz_t z;
+
+            mpz_init(z);
+            mpz_tdiv_r_2exp(z, n, 32);
+            rngctx->keyPhilox.an[0] = (uint32_t) mpz_get_ui(z);
+            mpz_tdiv_q_2exp(z, n, 32);
+            mpz_tdiv_r_2exp(z, z, 32);
+            rngctx->keyPhilox.an[1] = (uint32_t) mpz_get_ui(z);
+            mpz_clear(z);
+
+            break;
+        }
+
     case RNG_BBS:
         g_assert(rngctx->fZInit);
         mpz_set(rngctx->zSeed, n);
@@ -758,6 +786,45 @@ InitRNG(unsigned long *pnSeed, int *pfInitFrom, const int fSet, const rng rngx)
     return rngctx;
 }
 
+/* The counter of a Philox block: the two words of the roll's address, a
+ * draw number for rolls that had to be redrawn, and the kind of address. */
+enum {
+    PHILOX_SEQUENTIAL, PHILOX_ROLLOUT
+};
+
+static void
+PhiloxDice(unsigned int anDice[2], const rngcontext * rngctx, unsigned int i0, unsigned int i1, unsigned int iDraw,
+           unsigned int iKind)
+{
+    const uint32_t exp232_q = 715827882;
+    const uint32_t exp232_l = 4294967292U;
+    philoxblock ctr, r;
+    unsigned int i, c;
+
+    ctr.an[0] = i0;
+    ctr.an[1] = i1;
+    ctr.an[3] = iKind;
+
+    /* one block holds two spare words; a block with fewer than two
+     * usable words (probability about 1e-17) is replaced by the next */
+    for (ctr.an[2] = iDraw << 8;; ctr.an[2]++) {
+        philox4x32(&ctr, &rngctx->keyPhilox, &r);
+
+        for (i = c = 0; i < PHILOX_N && c < 2; i++)
+            if (r.an[i] < exp232_l)
+                anDice[c++] = 1 + r.an[i] / exp232_q;
+
+        if (c == 2)
+            return;
+    }
+}
+
+extern void
+RollDiceAt(unsigned int anDice[2], rngcontext * rngctx, unsigned int iGame, unsigned int iTurn, unsigned int iDraw)
+{
+    PhiloxDice(anDice, rngctx, iGame, iTurn, iDraw, PHILOX_ROLLOUT);
+}
+
 extern int
 RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
 {
@@ -823,6 +890,12 @@ RollDice(unsigned int anDice[2], rng * prng, rngcontext * rngctx)
         rngctx->c += 2;
         break;
 
+    case RNG_PHILOX:
+        /* outside rollouts, simply count the rolls */
+        PhiloxDice(anDice, rngctx, (unsigned int) (rngctx->c >> 1), 0, 0, PHILOX_SEQUENTIAL);
+        rngctx->c += 2;
+        break;
+
     case RNG_RANDOM_DOT_ORG:
 #if defined(LIBCURL_PROTOCOL_HTTPS)
         anDice[0] = getDiceRandomDotOrg();
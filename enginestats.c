@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Counters for the evaluation engine hot paths.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "backgammon.h"
+#include "enginestats.h"
+#include "multithread.h"
+
+/* slot 0 is used by the main thread (id -1), slot n+1 by worker n and
+ * the last slot by foreign threads (id MT_FOREIGN_THREAD_ID) */
+static enginestats aesThread[MAX_NUMTHREADS + 2];
+
+/* seconds between log lines during long operations; 0 means no logging */
+unsigned int nEngineStatsLog = 0;
+
+static gint64 tLastLog = 0;
+static enginestats esLastLog;
+
+static const char *aszClass[N_CLASSES] = {
+    N_("Over"),
+    N_("Hypergammon-1"),
+    N_("Hypergammon-2"),
+    N_("Hypergammon-3"),
+    N_("Bearoff2"),
+    N_("Bearoff-TS"),
+    N_("Bearoff1"),
+    N_("Bearoff-OS"),
+    N_("Race"),
+    N_("Crashed"),
+    N_("Contact")
+};
+
+extern enginestats *
+EngineStatsSlot(int id)
+{
+    g_assert(id >= -1 && id <= MAX_NUMTHREADS);
+
+    return &aesThread[id + 1];
+}
+
+extern void
+EngineStatsSum(enginestats * pes)
+{
+    unsigned int i, j;
+
+    memset(pes, 0, sizeof(*pes));
+
+    for (i = 0; i < G_N_ELEMENTS(aesThread); i++) {
+        const enginestats *p = &aesThread[i];
+
+        for (j = 0; j < N_CLASSES; j++)
+            pes->acEval[j] += p->acEval[j];
+        pes->cNeuralNet += p->cNeuralNet;
+        pes->cPruneNet += p->cPruneNet;
+        pes->cMoveGen += p->cMoveGen;
+        pes->cMovesGenerated += p->cMovesGenerated;
+        pes->cMaxMoves = MAX(pes->cMaxMoves, p->cMaxMoves);
+        pes->cCacheLookup += p->cCacheLookup;
+        pes->cCacheHit += p->cCacheHit;
+        pes->cCacheEvict += p->cCacheEvict;
+        pes->cBearoffRead += p->cBearoffRead;
+        pes->cBearoffDisk += p->cBearoffDisk;
+        pes->cBookLookup += p->cBookLookup;
+        pes->cBookHit += p->cBookHit;
+        for (j = 0; j < ENGINESTATS_PLIES; j++) {
+            pes->acPly[j] += p->acPly[j];
+            pes->anPlyTime[j] += p->anPlyTime[j];
+        }
+    }
+}
+
+extern void
+EngineStatsReset(void)
+{
+    memset(aesThread, 0, sizeof(aesThread));
+    memset(&esLastLog, 0, sizeof(esLastLog));
+    tLastLog = g_get_monotonic_time();
+}
+
+static double
+Percent(guint64 n, guint64 d)
+{
+    return d ? 100.0 * (double) n / (double) d : 0.0;
+}
+
+/*
+ * Format the counters in pes for display.
+ *
+ * Garbage collect:
+ *   caller must g_free the returned string.
+ */
+
+extern char *
+EngineStatsFormat(const enginestats * pes)
+{
+    GString *gs = g_string_new(NULL);
+    guint64 cEvals = 0;
+    unsigned int i;
+
+    for (i = 0; i < N_CLASSES; i++)
+        cEvals += pes->acEval[i];
+
+    g_string_append_printf(gs, "%s\n", _("Static evaluations:"));
+    for (i = 0; i < N_CLASSES; i++)
+        if (pes->acEval[i])
+            g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT " (%5.1f%%)\n",
+                                   gettext(aszClass[i]), pes->acEval[i], Percent(pes->acEval[i], cEvals));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Total"), cEvals);
+
+    g_string_append_printf(gs, "%s\n", _("Neural nets:"));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Full"), pes->cNeuralNet);
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Pruning"), pes->cPruneNet);
+
+    g_string_append_printf(gs, "%s\n", _("Move generation:"));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Calls"), pes->cMoveGen);
+    g_string_append_printf(gs, "  %-16s %14.1f\n", _("Average moves"),
+                           pes->cMoveGen ? (double) pes->cMovesGenerated / (double) pes->cMoveGen : 0.0);
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Largest list"), pes->cMaxMoves);
+
+    g_string_append_printf(gs, "%s\n", _("Evaluation cache:"));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Lookups"), pes->cCacheLookup);
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT " (%5.1f%%)\n", _("Hits"), pes->cCacheHit,
+                           Percent(pes->cCacheHit, pes->cCacheLookup));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Evictions"), pes->cCacheEvict);
+
+    g_string_append_printf(gs, "%s\n", _("Bearoff databases:"));
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Reads"), pes->cBearoffRead);
+    g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("From disk"), pes->cBearoffDisk);
+
+    if (pes->cBookLookup) {
+        g_string_append_printf(gs, "%s\n", _("Position book:"));
+        g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT "\n", _("Lookups"), pes->cBookLookup);
+        g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT " (%5.1f%%)\n", _("Hits"), pes->cBookHit,
+                               Percent(pes->cBookHit, pes->cBookLookup));
+    }
+
+    g_string_append_printf(gs, "%s\n", _("Move lists scored (time includes deeper plies):"));
+    for (i = 0; i < ENGINESTATS_PLIES; i++)
+        if (pes->acPly[i]) {
+            char sz[32];
+
+            sprintf(sz, (i == ENGINESTATS_PLIES - 1) ? _("%u+ ply") : _("%u ply"), i);
+            g_string_append_printf(gs, "  %-16s %14" G_GUINT64_FORMAT " %10.3f s\n", sz, pes->acPly[i],
+                                   (double) pes->anPlyTime[i] / G_TIME_SPAN_SECOND);
+        }
+
+    return g_string_free(gs, FALSE);
+}
+
+/*
+ * Called regularly while waiting for long running tasks. Prints a
+ * one line summary of the engine activity since the previous line
+ * every nEngineStatsLog seconds.
+ */
+
+extern void
+EngineStatsLogTick(void)
+{
+    enginestats es;
+    gint64 t;
+    double rElapsed;
+    guint64 cEvals = 0, cLookup, cHit;
+    unsigned int i;
+
+    if (!nEngineStatsLog)
+        return;
+
+    t = g_get_monotonic_time();
+    if (!tLastLog) {
+        tLastLog = t;
+        return;
+    }
+    if (t - tLastLog < (gint64) nEngineStatsLog * G_TIME_SPAN_SECOND)
+        return;
+
+    EngineStatsSum(&es);
+
+    for (i = 0; i < N_CLASSES; i++)
+        cEvals += es.acEval[i] - esLastLog.acEval[i];
+    cLookup = es.cCacheLookup - esLastLog.cCacheLookup;
+    cHit = es.cCacheHit - esLastLog.cCacheHit;
+    rElapsed = (double) (t - tLastLog) / G_TIME_SPAN_SECOND;
+
+    g_printerr(_("engine: %.0f evals/s, %.0f nets/s, %.0f movegens/s, "
+                 "cache %.1f%% hits, %" G_GUINT64_FORMAT " evictions, %" G_GUINT64_FORMAT " bearoff reads\n"),
+               (double) cEvals / rElapsed,
+               (double) (es.cNeuralNet + es.cPruneNet - esLastLog.cNeuralNet - esLastLog.cPruneNet) / rElapsed,
+               (double) (es.cMoveGen - esLastLog.cMoveGen) / rElapsed,
+               Percent(cHit, cLookup), es.cCacheEvict - esLastLog.cCacheEvict, es.cBearoffRead - esLastLog.cBearoffRead);
+
+    esLastLog = es;
+    tLastLog = t;
+}
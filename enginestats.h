@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENGINESTATS_H
+#define ENGINESTATS_H
+
+#include <glib.h>
+
+#include "eval.h"
+
+/* ply levels beyond this are accounted to the last slot */
+#define ENGINESTATS_PLIES 5
+
+/*
+ * Per-thread evaluation engine counters.
+ *
+ * Each thread only ever writes its own slot, so the counters are
+ * plain (non atomic) integers. The sum over all slots is computed on
+ * demand and may be slightly stale while threads are running.
+ */
+
+typedef struct {
+    guint64 acEval[N_CLASSES];  /* static evaluations per position class */
+    guint64 cNeuralNet;         /* main neural net evaluations */
+    guint64 cPruneNet;          /* pruning neural net evaluations */
+    guint64 cMoveGen;           /* calls to GenerateMoves() */
+    guint64 cMovesGenerated;    /* sum of the sizes of the move lists */
+    guint64 cMaxMoves;          /* largest move list generated */
+    guint64 cCacheLookup;       /* evaluation cache lookups */
+    guint64 cCacheHit;          /* ... found in the cache */
+    guint64 cCacheEvict;        /* valid entries pushed out of the cache */
+    guint64 cBearoffRead;       /* bearoff and hypergammon database reads */
+    guint64 cBearoffDisk;       /* ... that were not served from memory */
+    guint64 cBookLookup;        /* position book lookups */
+    guint64 cBookHit;           /* ... found in the book */
+    guint64 acPly[ENGINESTATS_PLIES];   /* move lists scored at each ply */
+    gint64 anPlyTime[ENGINESTATS_PLIES];        /* time spent scoring them (us) */
+    char pad[64];               /* keep threads off each other's cache lines */
+} enginestats;
+
+extern unsigned int nEngineStatsLog;
+
+extern enginestats *EngineStatsSlot(int id);
+extern void EngineStatsSum(enginestats * pes);
+extern void EngineStatsReset(void);
+extern char *EngineStatsFormat(const enginestats * pes);
+extern void EngineStatsLogTick(void);
+
+#endif
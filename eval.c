@@ -27,14 +27,17 @@
 #include "isaac.h"
 #include "md5.h"
 #include "bearoffgammon.h"
+#include "book.h"
 #include "positionid.h"
 #include "matchid.h"
 #include "matchequity.h"
 #include "format.h"
 #include "simd.h"
 #include "multithread.h"
+#include "numa.h"
 #include "util.h"
 #include "lib/simd.h"
+#include "packedboard.h"
 
 typedef void (*classstatusfunc) (char *szOutput);
 typedef int (*cfunc) (const void *, const void *);
@@ -194,33 +197,6 @@ enum {
 #define NUM_PRUNING_INPUTS (25 * MINPPERPOINT * 2)
 
 
-#if !defined(LOCKING_VERSION)
-
-f_FindnSaveBestMoves FindnSaveBestMoves = FindnSaveBestMovesNoLocking;
-f_FindBestMove FindBestMove = FindBestMoveNoLocking;
-f_EvaluatePosition EvaluatePosition = EvaluatePositionNoLocking;
-f_ScoreMove ScoreMove = ScoreMoveNoLocking;
-f_GeneralCubeDecisionE GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
-f_GeneralEvaluationE GeneralEvaluationE = GeneralEvaluationENoLocking;
-
-#define FindnSaveBestMoves FindnSaveBestMovesNoLocking
-#define FindBestMove FindBestMoveNoLocking
-#define EvaluatePosition EvaluatePositionNoLocking
-#define ScoreMove ScoreMoveNoLocking
-#define GeneralCubeDecisionE GeneralCubeDecisionENoLocking
-#define GeneralEvaluationE GeneralEvaluationENoLocking
-#define EvaluatePositionCache EvaluatePositionCacheNoLocking
-#define FindBestMovePlied FindBestMovePliedNoLocking
-#define GeneralEvaluationEPlied GeneralEvaluationEPliedNoLocking
-#define EvaluatePositionCubeful3 EvaluatePositionCubeful3NoLocking
-#define ScoreMoves ScoreMovesNoLocking
-#define ScoreMovesPruned ScoreMovesPrunedNoLocking
-#define FindBestMoveInEval FindBestMoveInEvalNoLocking
-#define GeneralEvaluationEPliedCubeful GeneralEvaluationEPliedCubefulNoLocking
-#define EvaluatePositionCubeful4 EvaluatePositionCubeful4NoLocking
-#define CacheAdd CacheAddNoLocking
-#define CacheLookup CacheLookupNoLocking
-
 static int EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput[],
                                  cubeinfo * const pci, const evalcontext * pecx, int nPlies, positionclass pc);
 
@@ -231,8 +207,6 @@ static int FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
 static int anEscapes[0x1000];
 static int anEscapes1[0x1000];
 
-static int anPoint[16] = { 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
-
 neuralnet nnContact, nnRace, nnCrashed;
 
 neuralnet nnpContact, nnpRace, nnpCrashed;
@@ -241,7 +215,11 @@ bearoffcontext *pbcOS = NULL;
 bearoffcontext *pbcTS = NULL;
 bearoffcontext *pbc1 = NULL;
 bearoffcontext *pbc2 = NULL;
-bearoffcontext *apbcHyper[3] = { NULL, NULL, NULL };
+
+/* The hypergammon databases are only opened when a hypergammon
+ * position is first evaluated; see HyperDatabase() */
+static int fHyperDatabases = FALSE;
+static GOnce aHyperOnce[3] = { G_ONCE_INIT, G_ONCE_INIT, G_ONCE_INIT };
 
 evalCache cEval;
 evalCache cpEval;
@@ -395,6 +373,23 @@ msb32(int n)
 }
 #endif
 
+static inline int
+nbits(unsigned int n)
+#ifdef HAVE___BUILTIN_POPCOUNT
+{
+    return __builtin_popcount(n);
+}
+#else
+{
+    int c = 0;
+
+    for (; n; n &= n - 1)
+        c++;
+
+    return c;
+}
+#endif
+
 static void
 ComputeTable0(void)
 {
@@ -412,18 +407,22 @@ ComputeTable0(void)
     }
 }
 
-static int
-Escapes(const unsigned int anBoard[25], int n)
-{
-
-    int i, af = 0, m;
+/* The escape tables are indexed by the points made on 24-n up to
+ * 24-n+11; fMade has bit i set for every point i with two or more
+ * chequers (see pointMasks()). */
 
-    m = (n < 12) ? n : 12;
+static inline unsigned int
+EscapeMask(unsigned int fMade, int n)
+{
+    int m = (n < 12) ? n : 12;
 
-    for (i = 0; i < m; i++)
-        af |= (anPoint[anBoard[24 + i - n]] << i);
+    return (fMade >> (24 - n)) & ((1u << m) - 1);
+}
 
-    return anEscapes[af];
+static inline int
+Escapes(unsigned int fMade, int n)
+{
+    return anEscapes[EscapeMask(fMade, n)];
 }
 
 static void
@@ -453,18 +452,10 @@ ComputeTable1(void)
     }
 }
 
-static int
-Escapes1(const unsigned int anBoard[25], int n)
+static inline int
+Escapes1(unsigned int fMade, int n)
 {
-
-    int i, af = 0, m;
-
-    m = (n < 12) ? n : 12;
-
-    for (i = 0; i < m; i++)
-        af |= (anPoint[anBoard[24 + i - n]] << i);
-
-    return anEscapes1[af];
+    return anEscapes1[EscapeMask(fMade, n)];
 }
 
 
@@ -475,6 +466,9 @@ ComputeTable(void)
     ComputeTable1();
 }
 
+/* mapping of a weights image the nets point into, if any */
+static GMappedFile *pmfWeights = NULL;
+
 static void
 DestroyWeights(void)
 {
@@ -485,6 +479,11 @@ DestroyWeights(void)
     NeuralNetDestroy(&nnpContact);
     NeuralNetDestroy(&nnpCrashed);
     NeuralNetDestroy(&nnpRace);
+
+    if (pmfWeights) {
+        g_mapped_file_unref(pmfWeights);
+        pmfWeights = NULL;
+    }
 }
 
 extern int
@@ -500,7 +499,8 @@ EvalShutdown(void)
     BearoffClose(pbcOS);
     BearoffClose(pbcTS);
     for (i = 0; i < 3; ++i)
-        BearoffClose(apbcHyper[i]);
+        if (aHyperOnce[i].status == G_ONCE_STATUS_READY)
+            BearoffClose(aHyperOnce[i].retval);
 
     /* destroy neural nets */
 
@@ -515,6 +515,62 @@ EvalShutdown(void)
 
 }
 
+/*
+ * Use the nets of a weights image (see makeweights -i) in place, from
+ * a read-only mapping: every process using the same file shares one
+ * copy in the page cache and nothing is read at startup.
+ *
+ * Returns TRUE on success, FALSE if the file is not a weights image
+ * (e.g. binary weights in the older format) or is invalid.
+ */
+
+static int
+MapWeightsImage(const char *szFile)
+{
+    neuralnet *apnn[] = { &nnContact, &nnRace, &nnCrashed, &nnpContact, &nnpCrashed, &nnpRace };
+    GMappedFile *pmf;
+    const char *p;
+    const float *ar;
+    size_t cb, cbNet, offset = NN_IMAGE_ALIGN;
+    unsigned int i;
+
+    if (!(pmf = g_mapped_file_new(szFile, FALSE, NULL)))
+        return FALSE;
+
+    p = g_mapped_file_get_contents(pmf);
+    cb = g_mapped_file_get_length(pmf);
+    ar = (const float *) p;
+
+    if (cb < NN_IMAGE_ALIGN || ar[0] != WEIGHTS_MAGIC_IMAGE) {
+        g_mapped_file_unref(pmf);
+        return FALSE;
+    }
+
+    if (ar[1] != WEIGHTS_VERSION_BINARY) {
+        char buf[20];
+        sprintf(buf, "%.2f", ar[1]);
+        g_print(_("weights file %s, has incorrect version (%s), expected (%s)"), szFile, buf, WEIGHTS_VERSION);
+        g_print("\n");
+        g_mapped_file_unref(pmf);
+        return FALSE;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(apnn); i++) {
+        if (!(cbNet = NeuralNetFromImage(apnn[i], p + offset, cb - offset))) {
+            g_print(_("%s is not a valid weights image"), szFile);
+            g_print("\n");
+            while (i--)
+                NeuralNetDestroy(apnn[i]);
+            g_mapped_file_unref(pmf);
+            return FALSE;
+        }
+        offset += cbNet;
+    }
+
+    pmfWeights = pmf;
+    return TRUE;
+}
+
 static int
 binary_weights_failed(char *filename, FILE * weights)
 {
@@ -575,9 +631,71 @@ weights_failed(char *filename, FILE * weights)
     return 0;
 }
 
+static gpointer
+OpenHyperDatabase(gpointer p)
+{
+    char *fn;
+    char sz[10];
+    bearoffcontext *pbc;
+
+    sprintf(sz, "hyper%c.bd", GPOINTER_TO_INT(p) + '1');
+    fn = BuildFilename(sz);
+    pbc = BearoffInit(fn, BO_IN_MEMORY);
+    g_free(fn);
+
+    return pbc;
+}
+
+/* Hypergammon database for i + 1 chequers, or NULL if it is not
+ * installed.  Safe to call from any thread. */
+
+extern bearoffcontext *
+HyperDatabase(int i)
+{
+    g_return_val_if_fail(i >= 0 && i < 3, NULL);
+
+    if (!fHyperDatabases)
+        return NULL;
+
+    return g_once(&aHyperOnce[i], OpenHyperDatabase, GINT_TO_POINTER(i));
+}
+
+/* Whether the hypergammon database for i + 1 chequers is installed,
+ * without opening it. */
+
+extern int
+HyperDatabaseInstalled(int i)
+{
+    char sz[10];
+    char *fn;
+    int f;
+
+    g_return_val_if_fail(i >= 0 && i < 3, FALSE);
+
+    if (!fHyperDatabases)
+        return FALSE;
+
+    sprintf(sz, "hyper%c.bd", i + '1');
+    fn = BuildFilename(sz);
+    f = g_file_test(fn, G_FILE_TEST_IS_REGULAR);
+    g_free(fn);
+
+    return f;
+}
+
+/* As HyperDatabase(), but NULL unless the database has been opened
+ * already. */
+
+static bearoffcontext *
+OpenedHyperDatabase(int i)
+{
+    return aHyperOnce[i].status == G_ONCE_STATUS_READY ? aHyperOnce[i].retval : NULL;
+}
+
 extern void
-EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pfProgress) (unsigned int))
+EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff)
 {
+    gint64 usStart;
     FILE *pfWeights = NULL;
     int i, fReadWeights = FALSE;
     static int fInitialised = FALSE;
@@ -638,21 +756,23 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
         fInitialised = TRUE;
     }
 
+    usStart = g_get_monotonic_time();
+
     if (!fNoBearoff) {
         char *gnubg_bearoff;
         char *gnubg_bearoff_os;
 
         gnubg_bearoff_os = BuildFilename("gnubg_os0.bd");
         if (!pbc1)
-            pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+            pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED);
         g_free(gnubg_bearoff_os);
 
         if (!pbc1)
-            pbc1 = BearoffInit(NULL, BO_HEURISTIC, pfProgress);
+            pbc1 = BearoffInit(NULL, BO_HEURISTIC);
 
         /* read two-sided db from gnubg.bd */
         gnubg_bearoff = BuildFilename("gnubg_ts0.bd");
-        pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
+        pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED);
         g_free(gnubg_bearoff);
 
         if (!pbc2)
@@ -666,28 +786,27 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
 
         gnubg_bearoff_os = BuildFilename("gnubg_os.bd");
         /* init one-sided db */
-        pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+        pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED);
         g_free(gnubg_bearoff_os);
 
         gnubg_bearoff = BuildFilename("gnubg_ts.bd");
         /* init two-sided db */
-        pbcTS = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
+        pbcTS = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED);
         g_free(gnubg_bearoff);
 
-        /* hyper-gammon databases */
+        /* hyper-gammon databases are opened on first use */
 
-        for (i = 0; i < 3; ++i) {
-            char *fn;
-            char sz[10];
-            sprintf(sz, "hyper%c.bd", i + '1');
-            fn = BuildFilename(sz);
-            apbcHyper[i] = BearoffInit(fn, BO_IN_MEMORY, NULL);
-            g_free(fn);
-        }
+        fHyperDatabases = TRUE;
 
+        StartupPhase(N_("bearoff databases"), usStart);
     }
 
-    if (szWeightsBinary) {
+    usStart = g_get_monotonic_time();
+
+    if (szWeightsBinary)
+        fReadWeights = pmfWeights || MapWeightsImage(szWeightsBinary);
+
+    if (!fReadWeights && szWeightsBinary) {
         pfWeights = g_fopen(szWeightsBinary, "rb");
         if (!binary_weights_failed(szWeightsBinary, pfWeights)) {
             if (!fReadWeights && !(fReadWeights =
@@ -739,14 +858,21 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
         exit(EXIT_FAILURE);
     }
 
+    StartupPhase(N_("neural net weights"), usStart);
 }
 
-/* Calculates inputs for any contact position, for one player only. */
+/* Calculates inputs for any contact position, for one player only.
+ * fOccupied/fMade and fOppOccupied/fOppMade are the point masks of
+ * anBoard and anBoardOpp from pointMasks(); most scans over the board
+ * below are done on them instead of on the chequer counts. */
 
 static void
-CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOpp[25], float afInput[])
+CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOpp[25],
+                    unsigned int fOccupied, unsigned int fMade,
+                    unsigned int fOppOccupied, unsigned int fOppMade, float afInput[])
 {
     int i, j, k, l, nOppBack, n, aHit[39], nBoard;
+    unsigned int fHitters;
 
     /* aanCombination[n] -
      * How many ways to hit from a distance of n pips.
@@ -883,11 +1009,7 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
     {
         int np = 0;
 
-        for (nOppBack = 24; nOppBack >= 0; --nOppBack) {
-            if (anBoardOpp[nOppBack]) {
-                break;
-            }
-        }
+        nOppBack = fOppOccupied ? msb32(fOppOccupied) : -1;
 
         nOppBack = 23 - nOppBack;
 
@@ -954,43 +1076,29 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
 
     {
         int nBack;
+        unsigned int f;
 
-        for (nBack = 24; nBack >= 0; --nBack) {
-            if (anBoard[nBack]) {
-                break;
-            }
-        }
+        nBack = fOccupied ? msb32(fOccupied) : -1;
 
         afInput[I_BACK_CHEQUER] = (float) nBack / 24.0f;
 
         /* Back anchor */
 
-        for (i = ((nBack == 24) ? 23 : nBack); i >= 0; --i) {
-            if (anBoard[i] >= 2) {
-                break;
-            }
-        }
+        i = (nBack == 24) ? 23 : nBack;
+        f = (i >= 0) ? fMade & ((2u << i) - 1) : 0;
+        i = f ? msb32(f) : -1;
 
         afInput[I_BACK_ANCHOR] = (float) i / 24.0f;
 
-        /* Forward anchor */
+        /* Forward anchor: the lowest anchor from 18 up to the back
+         * anchor, else the highest one on 12 to 17 */
 
         n = 0;
-        for (j = 18; j <= i; ++j) {
-            if (anBoard[j] >= 2) {
-                n = 24 - j;
-                break;
-            }
-        }
-
-        if (n == 0) {
-            for (j = 17; j >= 12; --j) {
-                if (anBoard[j] >= 2) {
-                    n = 24 - j;
-                    break;
-                }
-            }
-        }
+        f = (i >= 18) ? fMade & ((2u << i) - 1) & ~((1u << 18) - 1) : 0;
+        if (f)
+            n = 24 - msb32(f & (0u - f));
+        else if ((f = fMade & (0x3fu << 12)))
+            n = 24 - msb32(f);
 
         afInput[I_FORWARD_ANCHOR] = n == 0 ? 2.0f : (float) n / 6.0f;
     }
@@ -998,60 +1106,66 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
 
     /* Piploss */
 
-    nBoard = 0;
+    nBoard = nbits(fMade & 0x3f);
+
+    /* points we have a hitter on and are willing to hit from */
+
+    fHitters = fOccupied;
     for (i = 0; i < 6; i++)
-        if (anBoard[i] >= 2)
-            nBoard++;
+        if (anBoard[i] == 2)
+            fHitters &= ~(1u << i);
 
     memset(aHit, 0, sizeof(aHit));
 
-    /* for every point we'd consider hitting a blot on, */
+    /* for every blot on a point we'd consider hitting on, */
 
-    for (i = (nBoard > 2) ? 23 : 21; i >= 0; i--)
-        /* if there's a blot there, then */
+    for (l = (int) (fOppOccupied & ~fOppMade & ((nBoard > 2) ? 0xffffffu : 0x3fffffu)); l; l &= ~(1 << i)) {
+        unsigned int f;
 
-        if (unlikely(anBoardOpp[i] == 1))
-            /* for every point beyond */
+        i = msb32(l);
 
-            for (j = 24 - i; j < 25; j++)
-                /* if we have a hitter and are willing to hit */
+        /* for every hitter beyond */
 
-                if (anBoard[j] && !(j < 6 && anBoard[j] == 2))
-                    /* for every roll that can hit from that point */
+        for (f = fHitters >> (24 - i); f; f &= f - 1) {
+            j = msb32(f & (0u - f)) + 24 - i;
 
-                    for (n = 0; n < 5; n++) {
-                        if (aanCombination[j - 24 + i][n] == -1)
-                            break;
+            /* for every roll that can hit from that point */
 
-                        /* find the intermediate points required to play */
+            for (n = 0; n < 5; n++) {
+                if (aanCombination[j - 24 + i][n] == -1)
+                    break;
 
-                        pi = aIntermediate + aanCombination[j - 24 + i][n];
+                /* find the intermediate points required to play */
 
-                        if (pi->fAll) {
-                            /* if nFaces is 1, there are no intermediate points */
+                pi = aIntermediate + aanCombination[j - 24 + i][n];
 
-                            if (pi->nFaces > 1) {
-                                /* all the intermediate points are required */
+                if (pi->fAll) {
+                    /* if nFaces is 1, there are no intermediate points */
 
-                                for (k = 0; k < 3 && pi->anIntermediate[k] > 0; k++)
-                                    if (anBoardOpp[i - pi->anIntermediate[k]] > 1)
-                                        /* point is blocked; look for other hits */
-                                        goto cannot_hit;
-                            }
-                        } else {
-                            /* either of two points are required */
+                    if (pi->nFaces > 1) {
+                        /* all the intermediate points are required */
 
-                            if (anBoardOpp[i - pi->anIntermediate[0]] > 1 && anBoardOpp[i - pi->anIntermediate[1]] > 1) {
-                                /* both are blocked; look for other hits */
+                        for (k = 0; k < 3 && pi->anIntermediate[k] > 0; k++)
+                            if (anBoardOpp[i - pi->anIntermediate[k]] > 1)
+                                /* point is blocked; look for other hits */
                                 goto cannot_hit;
-                            }
-                        }
-
-                        /* enter this shot as available */
+                    }
+                } else {
+                    /* either of two points are required */
 
-                        aHit[aanCombination[j - 24 + i][n]] |= 1 << j;
-                    cannot_hit:;
+                    if (anBoardOpp[i - pi->anIntermediate[0]] > 1 && anBoardOpp[i - pi->anIntermediate[1]] > 1) {
+                        /* both are blocked; look for other hits */
+                        goto cannot_hit;
                     }
+                }
+
+                /* enter this shot as available */
+
+                aHit[aanCombination[j - 24 + i][n]] |= 1 << j;
+            cannot_hit:;
+            }
+        }
+    }
 
     memset(aRoll, 0, sizeof(aRoll));
 
@@ -1257,12 +1371,12 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
         afInput[I_P2] = (float) n2 / 36.0f;
     }
 
-    afInput[I_BACKESCAPES] = (float) Escapes(anBoard, 23 - nOppBack) / 36.0f;
+    afInput[I_BACKESCAPES] = (float) Escapes(fMade, 23 - nOppBack) / 36.0f;
 
-    afInput[I_BACKRESCAPES] = (float) Escapes1(anBoard, 23 - nOppBack) / 36.0f;
+    afInput[I_BACKRESCAPES] = (float) Escapes1(fMade, 23 - nOppBack) / 36.0f;
 
     for (n = 36, i = 15; i < 24 - nOppBack; i++)
-        if ((j = Escapes(anBoard, i)) < n)
+        if ((j = Escapes(fMade, i)) < n)
             n = j;
 
     afInput[I_ACONTAIN] = (float) (36 - n) / 36.0f;
@@ -1275,16 +1389,17 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
     }
 
     for (; i < 24; i++)
-        if ((j = Escapes(anBoard, i)) < n)
+        if ((j = Escapes(fMade, i)) < n)
             n = j;
 
 
     afInput[I_CONTAIN] = (float) (36 - n) / 36.0f;
     afInput[I_CONTAIN2] = afInput[I_CONTAIN] * afInput[I_CONTAIN];
 
-    for (n = 0, i = 6; i < 25; i++)
-        if (anBoard[i])
-            n += (i - 5) * anBoard[i] * Escapes(anBoardOpp, i);
+    for (n = 0, l = (int) (fOccupied & ~0x3fu); l; l &= ~(1 << i)) {
+        i = msb32(l);
+        n += (i - 5) * anBoard[i] * Escapes(fOppMade, i);
+    }
 
     afInput[I_MOBILITY] = (float) n / 3600.0f;
 
@@ -1353,10 +1468,7 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
         afInput[I_ENTER] = 0.0f;
     }
 
-    n = 0;
-    for (i = 0; i < 6; i++) {
-        n += anBoardOpp[i] > 1;
-    }
+    n = nbits(fOppMade & 0x3f);
 
     afInput[I_ENTER2] = (float) (36 - (n - 6) * (n - 6)) / 36.0f;
 
@@ -1395,13 +1507,7 @@ CalculateHalfInputs(const unsigned int anBoard[25], const unsigned int anBoardOp
     }
 
     {
-        unsigned int nAc = 0;
-
-        for (i = 18; i < 24; ++i) {
-            if (anBoard[i] > 1) {
-                ++nAc;
-            }
-        }
+        unsigned int nAc = nbits(fMade & (0x3fu << 18));
 
         afInput[I_BACKG] = 0.0;
         afInput[I_BACKG1] = 0.0;
@@ -1540,7 +1646,10 @@ menOffNonCrashed(const unsigned int *anBoard, float *afInput)
 static void
 CalculateContactInputs(const TanBoard anBoard, float arInput[])
 {
+    unsigned int afOccupied[2], afMade[2];
+
     baseInputs(anBoard, arInput);
+    pointMasks(anBoard, afOccupied, afMade);
 
     {
         float *b = arInput + MINPPERPOINT * 25 * 2;
@@ -1548,7 +1657,7 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
         /* I accidentally switched sides (0 and 1) when I trained the net */
         menOffNonCrashed(anBoard[0], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[1], anBoard[0], b);
+        CalculateHalfInputs(anBoard[1], anBoard[0], afOccupied[1], afMade[1], afOccupied[0], afMade[0], b);
     }
 
     {
@@ -1556,7 +1665,7 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
 
         menOffNonCrashed(anBoard[1], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[0], anBoard[1], b);
+        CalculateHalfInputs(anBoard[0], anBoard[1], afOccupied[0], afMade[0], afOccupied[1], afMade[1], b);
     }
 }
 
@@ -1565,14 +1674,17 @@ CalculateContactInputs(const TanBoard anBoard, float arInput[])
 static void
 CalculateCrashedInputs(const TanBoard anBoard, float arInput[])
 {
+    unsigned int afOccupied[2], afMade[2];
+
     baseInputs(anBoard, arInput);
+    pointMasks(anBoard, afOccupied, afMade);
 
     {
         float *b = arInput + MINPPERPOINT * 25 * 2;
 
         menOffAll(anBoard[1], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[1], anBoard[0], b);
+        CalculateHalfInputs(anBoard[1], anBoard[0], afOccupied[1], afMade[1], afOccupied[0], afMade[0], b);
     }
 
     {
@@ -1580,7 +1692,31 @@ CalculateCrashedInputs(const TanBoard anBoard, float arInput[])
 
         menOffAll(anBoard[0], b + I_OFF1);
 
-        CalculateHalfInputs(anBoard[0], anBoard[1], b);
+        CalculateHalfInputs(anBoard[0], anBoard[1], afOccupied[0], afMade[0], afOccupied[1], afMade[1], b);
+    }
+}
+
+/* Calculates the inputs of the net for positions of class pc, or of
+ * its pruning net, and returns their number. */
+
+extern unsigned int
+NetInputs(const TanBoard anBoard, positionclass pc, int fPrune, float arInput[])
+{
+    if (fPrune) {
+        baseInputs(anBoard, arInput);
+        return NUM_PRUNING_INPUTS;
+    }
+
+    switch (pc) {
+    case CLASS_RACE:
+        CalculateRaceInputs(anBoard, arInput);
+        return NUM_RACE_INPUTS;
+    case CLASS_CRASHED:
+        CalculateCrashedInputs(anBoard, arInput);
+        return NUM_INPUTS;
+    default:
+        CalculateContactInputs(anBoard, arInput);
+        return NUM_INPUTS;
     }
 }
 
@@ -1901,7 +2037,7 @@ static int
 EvalHypergammon1(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[0], anBoard, arOutput);
+    return BearoffEval(HyperDatabase(0), anBoard, arOutput);
 
 }
 
@@ -1909,7 +2045,7 @@ static int
 EvalHypergammon2(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[1], anBoard, arOutput);
+    return BearoffEval(HyperDatabase(1), anBoard, arOutput);
 
 }
 
@@ -1917,7 +2053,7 @@ static int
 EvalHypergammon3(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[2], anBoard, arOutput);
+    return BearoffEval(HyperDatabase(2), anBoard, arOutput);
 
 }
 
@@ -2099,19 +2235,29 @@ EvalRaceBG(const TanBoard anBoard, float arOutput[], const bgvariation bgv)
     }
 }
 
+/* The copy of pnn on the calling thread's NUMA node, if there is one */
+static inline const neuralnet *
+ThreadNet(const neuralnet * pnn, int iNet)
+{
+    const neuralnet *pnnNode = MT_GetTLD()->pnnNode;
+
+    return pnnNode ? pnnNode + iNet : pnn;
+}
+
 static int
 EvalRace(const TanBoard anBoard, float arOutput[], const bgvariation bgv, NNState * nnStates)
 {
     SSE_ALIGN(float arInput[NUM_RACE_INPUTS]);
 
     CalculateRaceInputs(anBoard, arInput);
+    ++MT_Get_engineStats()->cNeuralNet;
 
 #if defined(USE_SIMD_INSTRUCTIONS)
     // cppcheck-suppress duplicateExpression
-    if (NeuralNetEvaluateSSE(&nnRace, arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
+    if (NeuralNetEvaluateSSE(ThreadNet(&nnRace, NUMA_NET_RACE), arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
 #else
     // cppcheck-suppress duplicateExpression
-    if (NeuralNetEvaluate(&nnRace, arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
+    if (NeuralNetEvaluate(ThreadNet(&nnRace, NUMA_NET_RACE), arInput, arOutput, nnStates ? nnStates + (CLASS_RACE - CLASS_RACE) : NULL))
 #endif
         return -1;
 
@@ -2130,12 +2276,13 @@ EvalContact(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(b
     SSE_ALIGN(float arInput[NUM_INPUTS]);
 
     CalculateContactInputs(anBoard, arInput);
+    ++MT_Get_engineStats()->cNeuralNet;
 
 #if defined(USE_SIMD_INSTRUCTIONS)
-    return NeuralNetEvaluateSSE(&nnContact, arInput, arOutput,
+    return NeuralNetEvaluateSSE(ThreadNet(&nnContact, NUMA_NET_CONTACT), arInput, arOutput,
                                 nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
 #else
-    return NeuralNetEvaluate(&nnContact, arInput, arOutput, nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
+    return NeuralNetEvaluate(ThreadNet(&nnContact, NUMA_NET_CONTACT), arInput, arOutput, nnStates ? nnStates + (CLASS_CONTACT - CLASS_RACE) : NULL);
 #endif
 }
 
@@ -2145,12 +2292,13 @@ EvalCrashed(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(b
     SSE_ALIGN(float arInput[NUM_INPUTS]);
 
     CalculateCrashedInputs(anBoard, arInput);
+    ++MT_Get_engineStats()->cNeuralNet;
 
 #if defined(USE_SIMD_INSTRUCTIONS)
-    return NeuralNetEvaluateSSE(&nnCrashed, arInput, arOutput,
+    return NeuralNetEvaluateSSE(ThreadNet(&nnCrashed, NUMA_NET_CRASHED), arInput, arOutput,
                                 nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
 #else
-    return NeuralNetEvaluate(&nnCrashed, arInput, arOutput, nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
+    return NeuralNetEvaluate(ThreadNet(&nnCrashed, NUMA_NET_CRASHED), arInput, arOutput, nnStates ? nnStates + (CLASS_CRASHED - CLASS_RACE) : NULL);
 #endif
 }
 
@@ -2664,8 +2812,11 @@ ApplyMove(TanBoard anBoard, const int anMove[8], const int fCheckLegal)
     return 0;
 }
 
+/* Move generation works on packedboard: the recursion copies a board per
+ * chequer moved, and the key of every result is taken from it. */
+
 static void
-SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[], const TanBoard anBoard, int fPartial)
+SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[], const packedboard * ppb, int fPartial)
 {
     unsigned int i, j;
     move *pm;
@@ -2692,7 +2843,7 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
         pml->cMaxPips = cPip;
     }
 
-    PositionKey(anBoard, &key);
+    PackedPositionKey(ppb, &key);
 
     for (i = 0; i < pml->cMoves; i++) {
 
@@ -2737,68 +2888,83 @@ SaveMoves(movelist * pml, unsigned int cMoves, unsigned int cPip, int anMoves[],
 }
 
 static int
-LegalMove(const TanBoard anBoard, int iSrc, int nPips)
+LegalMove(const packedboard * ppb, int iSrc, int nPips)
 {
 
     int nBack;
     const int iDest = iSrc - nPips;
 
     if (iDest >= 0) {           /* Here we can do the Chris rule check */
-        return (anBoard[0][23 - iDest] < 2);
+        return (ppb->an[0][23 - iDest] < 2);
     }
     /* otherwise, attempting to bear off */
 
     for (nBack = 24; nBack > 0; nBack--)
-        if (anBoard[1][nBack] > 0)
+        if (ppb->an[1][nBack] > 0)
             break;
 
     return (nBack <= 5 && (iSrc == nBack || iDest == -1));
 }
 
+/* ApplySubMove() for a move LegalMove() has accepted */
+static inline void
+ApplyPackedSubMove(packedboard * ppb, const int iSrc, const int nRoll)
+{
+    const int iDest = iSrc - nRoll;
+
+    ppb->an[1][iSrc]--;
+
+    if (iDest < 0)
+        return;
+
+    if (ppb->an[0][23 - iDest]) {
+        ppb->an[1][iDest] = 1;
+        ppb->an[0][23 - iDest] = 0;
+        ppb->an[0][24]++;
+    } else
+        ppb->an[1][iDest]++;
+}
+
 static int
 GenerateMovesSub(movelist * pml, int anRoll[], int nMoveDepth,
-                 int iPip, int cPip, const TanBoard anBoard, int anMoves[], int fPartial)
+                 int iPip, int cPip, const packedboard * ppb, int anMoves[], int fPartial)
 {
     int i, fUsed = 0;
-    TanBoard anBoardNew;
+    packedboard pbNew;
 
     if (nMoveDepth > 3 || !anRoll[nMoveDepth])
         return TRUE;
 
-    if (anBoard[1][24]) {       /* on bar */
-        if (anBoard[0][anRoll[nMoveDepth] - 1] >= 2)
+    if (ppb->an[1][24]) {       /* on bar */
+        if (ppb->an[0][anRoll[nMoveDepth] - 1] >= 2)
             return TRUE;
 
         anMoves[nMoveDepth * 2] = 24;
         anMoves[nMoveDepth * 2 + 1] = 24 - anRoll[nMoveDepth];
 
-        for (i = 0; i < 25; i++) {
-            anBoardNew[0][i] = anBoard[0][i];
-            anBoardNew[1][i] = anBoard[1][i];
-        }
+        pbNew = *ppb;
 
-        ApplySubMove(anBoardNew, 24, anRoll[nMoveDepth], TRUE);
+        ApplyPackedSubMove(&pbNew, 24, anRoll[nMoveDepth]);
 
         if (GenerateMovesSub(pml, anRoll, nMoveDepth + 1, 23, cPip +
-                             anRoll[nMoveDepth], (ConstTanBoard) anBoardNew, anMoves, fPartial))
-            SaveMoves(pml, nMoveDepth + 1, cPip + anRoll[nMoveDepth], anMoves, (ConstTanBoard) anBoardNew, fPartial);
+                             anRoll[nMoveDepth], &pbNew, anMoves, fPartial))
+            SaveMoves(pml, nMoveDepth + 1, cPip + anRoll[nMoveDepth], anMoves, &pbNew, fPartial);
 
         return fPartial;
     } else {
         for (i = iPip; i >= 0; i--)
-            if (anBoard[1][i] && LegalMove(anBoard, i, anRoll[nMoveDepth])) {
+            if (ppb->an[1][i] && LegalMove(ppb, i, anRoll[nMoveDepth])) {
                 anMoves[nMoveDepth * 2] = i;
                 anMoves[nMoveDepth * 2 + 1] = i - anRoll[nMoveDepth];
 
-                memcpy(anBoardNew, anBoard, sizeof(anBoardNew));
+                pbNew = *ppb;
 
-                ApplySubMove(anBoardNew, i, anRoll[nMoveDepth], TRUE);
+                ApplyPackedSubMove(&pbNew, i, anRoll[nMoveDepth]);
 
                 if (GenerateMovesSub(pml, anRoll, nMoveDepth + 1,
                                      anRoll[0] == anRoll[1] ? i : 23,
-                                     cPip + anRoll[nMoveDepth], (ConstTanBoard) anBoardNew, anMoves, fPartial))
-                    SaveMoves(pml, nMoveDepth + 1, cPip +
-                              anRoll[nMoveDepth], anMoves, (ConstTanBoard) anBoardNew, fPartial);
+                                     cPip + anRoll[nMoveDepth], &pbNew, anMoves, fPartial))
+                    SaveMoves(pml, nMoveDepth + 1, cPip + anRoll[nMoveDepth], anMoves, &pbNew, fPartial);
 
                 fUsed = 1;
             }
@@ -2823,7 +2989,7 @@ CompareMovesGeneral(const move * pm0, const move * pm1)
     int cleft[2] = { 0, 0 };
     int a, b;
 
-    int i = cmp_evalsetup(&pm0->esMove, &pm1->esMove);
+    int i = cmp_moveevalsetup(&pm0->esMove, &pm1->esMove);
 
     if (i)
         return -i;              /* sort descending */
@@ -2871,19 +3037,32 @@ GenerateMoves(movelist * pml, const TanBoard anBoard, int n0, int n1, int fParti
 {
 
     int anRoll[4], anMoves[8];
+    packedboard pb;
+
     anRoll[0] = n0;
     anRoll[1] = n1;
 
     anRoll[2] = anRoll[3] = ((n0 == n1) ? n0 : 0);
 
+    PackBoard(anBoard, &pb);
+
     pml->cMoves = pml->cMaxMoves = pml->cMaxPips = pml->iMoveBest = 0;
     pml->amMoves = MT_Get_aMoves();
-    GenerateMovesSub(pml, anRoll, 0, 23, 0, anBoard, anMoves, fPartial);
+    GenerateMovesSub(pml, anRoll, 0, 23, 0, &pb, anMoves, fPartial);
 
     if (anRoll[0] != anRoll[1]) {
         swap(anRoll, anRoll + 1);
 
-        GenerateMovesSub(pml, anRoll, 0, 23, 0, anBoard, anMoves, fPartial);
+        GenerateMovesSub(pml, anRoll, 0, 23, 0, &pb, anMoves, fPartial);
+    }
+
+    {
+        enginestats *pes = MT_Get_engineStats();
+
+        ++pes->cMoveGen;
+        pes->cMovesGenerated += pml->cMoves;
+        if (pml->cMoves > pes->cMaxMoves)
+            pes->cMaxMoves = pml->cMoves;
     }
 
     return pml->cMoves;
@@ -3021,7 +3200,7 @@ static void
 StatusHypergammon1(char *sz)
 {
 
-    BearoffStatus(apbcHyper[0], sz);
+    BearoffStatus(OpenedHyperDatabase(0), sz);
 
 }
 
@@ -3029,7 +3208,7 @@ static void
 StatusHypergammon2(char *sz)
 {
 
-    BearoffStatus(apbcHyper[1], sz);
+    BearoffStatus(OpenedHyperDatabase(1), sz);
 
 }
 
@@ -3037,7 +3216,7 @@ static void
 StatusHypergammon3(char *sz)
 {
 
-    BearoffStatus(apbcHyper[2], sz);
+    BearoffStatus(OpenedHyperDatabase(2), sz);
 
 }
 
@@ -3231,9 +3410,17 @@ extern int
 EvalCacheResize(unsigned int cNew)
 {
     cCache = CacheResize(&cEval, cNew);
+    NumaInterleave(cEval.entries, (cEval.size / 2) * sizeof(cacheNode));
     return cCache;
 }
 
+extern void
+EvalCacheSetShared(int fShared)
+{
+    cEval.fShared = fShared;
+    cpEval.fShared = fShared;
+}
+
 #if CACHE_STATS
 extern int
 EvalCacheStats(unsigned int *pcUsed, unsigned int *pcLookup, unsigned int *pcHit)
@@ -4119,9 +4306,14 @@ EvalEfficiency(const TanBoard anBoard, positionclass pc, int ply)
 
 
 extern char *
-FormatEval(char *sz, evalsetup * pes)
+FormatEval(char *sz, const moveevalsetup * pes)
 {
 
+    if (pes->nBook) {
+        strcpy(sz, _("Book"));
+        return sz;
+    }
+
     switch (pes->et) {
     case EVAL_NONE:
         strcpy(sz, "");
@@ -4279,7 +4471,7 @@ CalcCubefulEquity(positionclass pc, float arOutput[NUM_ROLLOUT_OUTPUTS], int nPl
     arOutput[OUTPUT_CUBEFUL_EQUITY] = r;
 
 }
-#endif                          /* !LOCKING_VERSION */
+#endif
 
 
 /*
@@ -4346,11 +4538,43 @@ cmp_evalcontext(const evalcontext * pec1, const evalcontext * pec2)
 }
 
 
+#define CMP(a, b) if ((a) < (b)) return -1; else if ((a) > (b)) return +1
+
+/* Field by field, so that the padding of the structs plays no part. */
+
+static int
+cmp_evalcontext_fields(const evalcontext * pec1, const evalcontext * pec2)
+{
+    CMP(pec1->fCubeful, pec2->fCubeful);
+    CMP(pec1->nPlies, pec2->nPlies);
+    CMP(pec1->fUsePrune, pec2->fUsePrune);
+    CMP(pec1->fDeterministic, pec2->fDeterministic);
+    CMP(pec1->rNoise, pec2->rNoise);
+
+    return 0;
+}
+
+static int
+cmp_movefilters(const movefilter aamf1[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+                const movefilter aamf2[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    int i, j;
+
+    for (i = 0; i < MAX_FILTER_PLIES; i++)
+        for (j = 0; j < MAX_FILTER_PLIES; j++) {
+            CMP(aamf1[i][j].Accept, aamf2[i][j].Accept);
+            CMP(aamf1[i][j].Extra, aamf2[i][j].Extra);
+            CMP(aamf1[i][j].Threshold, aamf2[i][j].Threshold);
+        }
+
+    return 0;
+}
+
 /*
  * Compare two rolloutcontexts.
  *
  * Input:
- *    - prc1, prc2: the two evalsetups to compare
+ *    - prc1, prc2: the two rolloutcontexts to compare
  *
  * Output:
  *    None.
@@ -4360,19 +4584,60 @@ cmp_evalcontext(const evalcontext * pec1, const evalcontext * pec2)
  *     0 if  *prc1 "=" *prc2
  *    +1 if  *prc1 ">" *prc2
  *
+ * The order is arbitrary; it only tells different settings apart.
+ *
  */
 
 static int
-cmp_rolloutcontext(const rolloutcontext * UNUSED(prc1), const rolloutcontext * UNUSED(prc2))
+cmp_rolloutcontext(const rolloutcontext * prc1, const rolloutcontext * prc2)
 {
+    int i, n;
 
-    /* FIXME: write me */
+    for (i = 0; i < 2; i++) {
+        if ((n = cmp_evalcontext_fields(&prc1->aecCube[i], &prc2->aecCube[i])) ||
+            (n = cmp_evalcontext_fields(&prc1->aecChequer[i], &prc2->aecChequer[i])) ||
+            (n = cmp_evalcontext_fields(&prc1->aecCubeLate[i], &prc2->aecCubeLate[i])) ||
+            (n = cmp_evalcontext_fields(&prc1->aecChequerLate[i], &prc2->aecChequerLate[i])) ||
+            (n = cmp_movefilters((const movefilter(*)[MAX_FILTER_PLIES]) prc1->aaamfChequer[i],
+                                 (const movefilter(*)[MAX_FILTER_PLIES]) prc2->aaamfChequer[i])) ||
+            (n = cmp_movefilters((const movefilter(*)[MAX_FILTER_PLIES]) prc1->aaamfLate[i],
+                                 (const movefilter(*)[MAX_FILTER_PLIES]) prc2->aaamfLate[i])))
+            return n;
+    }
+
+    if ((n = cmp_evalcontext_fields(&prc1->aecCubeTrunc, &prc2->aecCubeTrunc)) ||
+        (n = cmp_evalcontext_fields(&prc1->aecChequerTrunc, &prc2->aecChequerTrunc)))
+        return n;
+
+    CMP(prc1->fCubeful, prc2->fCubeful);
+    CMP(prc1->fVarRedn, prc2->fVarRedn);
+    CMP(prc1->fInitial, prc2->fInitial);
+    CMP(prc1->fRotate, prc2->fRotate);
+    CMP(prc1->fTruncBearoff2, prc2->fTruncBearoff2);
+    CMP(prc1->fTruncBearoffOS, prc2->fTruncBearoffOS);
+    CMP(prc1->fLateEvals, prc2->fLateEvals);
+    CMP(prc1->fDoTruncate, prc2->fDoTruncate);
+    CMP(prc1->fStopOnSTD, prc2->fStopOnSTD);
+    CMP(prc1->fStopOnJsd, prc2->fStopOnJsd);
+    CMP(prc1->fStopMoveOnJsd, prc2->fStopMoveOnJsd);
+    CMP(prc1->nTruncate, prc2->nTruncate);
+    CMP(prc1->nTrials, prc2->nTrials);
+    CMP(prc1->nLate, prc2->nLate);
+    CMP(prc1->rngRollout, prc2->rngRollout);
+    CMP(prc1->nSeed, prc2->nSeed);
+    CMP(prc1->nMinimumGames, prc2->nMinimumGames);
+    CMP(prc1->rStdLimit, prc2->rStdLimit);
+    CMP(prc1->nMinimumJsdGames, prc2->nMinimumJsdGames);
+    CMP(prc1->rJsdLimit, prc2->rJsdLimit);
+    CMP(prc1->nGamesDone, prc2->nGamesDone);
+    CMP(prc1->rStoppedOnJSD, prc2->rStoppedOnJSD);
+    CMP(prc1->nSkip, prc2->nSkip);
 
     return 0;
-
-
 }
 
+#undef CMP
+
 
 /*
  * Compare two evalsetups.
@@ -4411,7 +4676,8 @@ cmp_evalsetup(const evalsetup * pes1, const evalsetup * pes2)
         return cmp_evalcontext(&pes1->ec, &pes2->ec);
 
     case EVAL_ROLLOUT:
-        return cmp_rolloutcontext(&pes1->rc, &pes2->rc);
+        /* rollouts are not ranked against each other */
+        return 0;
 
     default:
         g_assert_not_reached();
@@ -4420,6 +4686,176 @@ cmp_evalsetup(const evalsetup * pes1, const evalsetup * pes2)
     return 0;
 }
 
+/* As cmp_evalsetup(), for the setups stored with moves. */
+
+extern int
+cmp_moveevalsetup(const moveevalsetup * pmes1, const moveevalsetup * pmes2)
+{
+    /* book moves rank by the quality of the evaluation they were taken
+     * from, not by the context they were looked up with */
+    if (pmes1->nBook || pmes2->nBook) {
+        int n1 = BookMoveQuality(pmes1), n2 = BookMoveQuality(pmes2);
+
+        return n1 < n2 ? -1 : n1 > n2;
+    }
+
+    if (pmes1->et < pmes2->et)
+        return -1;
+    else if (pmes1->et > pmes2->et)
+        return +1;
+
+    switch (pmes1->et) {
+    case EVAL_NONE:
+        return 0;
+
+    case EVAL_EVAL:
+        return cmp_evalcontext(&pmes1->ec, &pmes2->ec);
+
+    case EVAL_ROLLOUT:
+        /* rollouts are not ranked against each other */
+        return 0;
+
+    default:
+        g_assert_not_reached();
+    }
+
+    return 0;
+}
+
+/*
+ * The rollout contexts of rolled out moves.  Each distinct context is
+ * kept once, so moves can be copied and freed without caring who owns
+ * their context; the results of each rollout (games done, JSD, skipped
+ * dice) stay in the moveevalsetup so that they don't make every context
+ * distinct.  All moves that can hold a context belong to the match, so
+ * the table is emptied by ClearRolloutContexts() when the match is freed.
+ */
+
+static GHashTable *phtRolloutContexts = NULL;
+G_LOCK_DEFINE_STATIC(rolloutcontexts);
+
+static guint
+HashEvalContext(guint h, const evalcontext * pec)
+{
+    return ((h * 33 + pec->nPlies) * 33 + pec->fCubeful) * 4 + pec->fUsePrune * 2 + pec->fDeterministic;
+}
+
+/* Floats are left out so that 0.0 and -0.0, which compare equal, hash
+ * alike. */
+
+static guint
+HashRolloutContext(gconstpointer p)
+{
+    const rolloutcontext *prc = p;
+    guint h = 5381;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        h = HashEvalContext(h, &prc->aecCube[i]);
+        h = HashEvalContext(h, &prc->aecChequer[i]);
+        h = HashEvalContext(h, &prc->aecCubeLate[i]);
+        h = HashEvalContext(h, &prc->aecChequerLate[i]);
+    }
+    h = HashEvalContext(h, &prc->aecCubeTrunc);
+    h = HashEvalContext(h, &prc->aecChequerTrunc);
+
+    h = h * 33 + prc->fCubeful + (prc->fVarRedn << 1) + (prc->fInitial << 2) + (prc->fRotate << 3) +
+        (prc->fTruncBearoff2 << 4) + (prc->fTruncBearoffOS << 5) + (prc->fLateEvals << 6) +
+        (prc->fDoTruncate << 7) + (prc->fStopOnSTD << 8) + (prc->fStopOnJsd << 9) + (prc->fStopMoveOnJsd << 10);
+    h = h * 33 + prc->nTruncate;
+    h = h * 33 + prc->nTrials;
+    h = h * 33 + prc->nLate;
+    h = h * 33 + prc->rngRollout;
+    h = h * 33 + (guint) prc->nSeed;
+    h = h * 33 + prc->nMinimumGames;
+    h = h * 33 + prc->nMinimumJsdGames;
+
+    return h;
+}
+
+static gboolean
+EqualRolloutContext(gconstpointer p0, gconstpointer p1)
+{
+    return !cmp_rolloutcontext(p0, p1);
+}
+
+extern const rolloutcontext *
+InternRolloutContext(const rolloutcontext * prc)
+{
+    rolloutcontext *prcShared;
+
+    G_LOCK(rolloutcontexts);
+
+    if (!phtRolloutContexts)
+        phtRolloutContexts = g_hash_table_new_full(HashRolloutContext, EqualRolloutContext, g_free, NULL);
+
+    if (!(prcShared = g_hash_table_lookup(phtRolloutContexts, prc))) {
+#if GLIB_CHECK_VERSION (2,67,4)
+        prcShared = g_memdup2(prc, sizeof(rolloutcontext));
+#else
+        prcShared = g_memdup(prc, sizeof(rolloutcontext));
+#endif
+        g_hash_table_insert(phtRolloutContexts, prcShared, prcShared);
+    }
+
+    G_UNLOCK(rolloutcontexts);
+
+    return prcShared;
+}
+
+extern void
+ClearRolloutContexts(void)
+{
+    G_LOCK(rolloutcontexts);
+
+    if (phtRolloutContexts)
+        g_hash_table_remove_all(phtRolloutContexts);
+
+    G_UNLOCK(rolloutcontexts);
+}
+
+extern void
+SetMoveEvalSetup(moveevalsetup * pmes, const evalsetup * pes)
+{
+    pmes->et = pes->et;
+    pmes->ec = pes->ec;
+    pmes->nBook = 0;
+
+    if (pes->et == EVAL_ROLLOUT) {
+        rolloutcontext rc = pes->rc;
+
+        pmes->nGamesDone = rc.nGamesDone;
+        pmes->rStoppedOnJSD = rc.rStoppedOnJSD;
+        pmes->nSkip = rc.nSkip;
+        rc.nGamesDone = 0;
+        rc.rStoppedOnJSD = 0.0f;
+        rc.nSkip = 0;
+        pmes->prc = InternRolloutContext(&rc);
+    } else {
+        pmes->prc = NULL;
+        pmes->nGamesDone = 0;
+        pmes->rStoppedOnJSD = 0.0f;
+        pmes->nSkip = 0;
+    }
+}
+
+/* Expand the setup of a move into *pes, which is returned. */
+extern evalsetup *
+GetMoveEvalSetup(evalsetup * pes, const moveevalsetup * pmes)
+{
+    pes->et = pmes->et;
+    pes->ec = pmes->ec;
+    if (pmes->prc) {
+        pes->rc = *pmes->prc;
+        pes->rc.nGamesDone = pmes->nGamesDone;
+        pes->rc.rStoppedOnJSD = pmes->rStoppedOnJSD;
+        pes->rc.nSkip = pmes->nSkip;
+    } else
+        memset(&pes->rc, 0, sizeof(rolloutcontext));
+
+    return pes;
+}
+
 
 static void
 calculate_gammon_rates(float aarRates[2][2], float arOutput[], cubeinfo * pci)
@@ -5253,34 +5689,6 @@ DoubleType(const int fDoubled, const int fMove, const int fTurn)
     return DT_NORMAL;
 }
 
-#else
-
-#define FindnSaveBestMoves FindnSaveBestMovesWithLocking
-#define FindBestMove FindBestMoveWithLocking
-#define EvaluatePosition EvaluatePositionWithLocking
-#define ScoreMove ScoreMoveWithLocking
-#define GeneralCubeDecisionE GeneralCubeDecisionEWithLocking
-#define GeneralEvaluationE GeneralEvaluationEWithLocking
-#define EvaluatePositionCache EvaluatePositionCacheWithLocking
-#define FindBestMovePlied FindBestMovePliedWithLocking
-#define GeneralEvaluationEPlied GeneralEvaluationEPliedWithLocking
-#define EvaluatePositionCubeful3 EvaluatePositionCubeful3WithLocking
-#define ScoreMoves ScoreMovesWithLocking
-#define ScoreMovesPruned ScoreMovesPrunedWithLocking
-#define FindBestMoveInEval FindBestMoveInEvalWithLocking
-#define GeneralEvaluationEPliedCubeful GeneralEvaluationEPliedCubefulWithLocking
-#define EvaluatePositionCubeful4 EvaluatePositionCubeful4WithLocking
-#define CacheAdd CacheAddWithLocking
-#define CacheLookup CacheLookupWithLocking
-
-static int EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput[],
-                                 cubeinfo * const pci, const evalcontext * pecx, int nPlies, positionclass pc);
-
-static int FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
-                             TanBoard anBoard, const cubeinfo * pci,
-                             const evalcontext * pec, int nPlies, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
-
-#endif
 
 static int GeneralEvaluationEPlied(NNState * nnStates, float arOutput[NUM_ROLLOUT_OUTPUTS],
                                    const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, int nPlies);
@@ -5362,9 +5770,11 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
             SSE_ALIGN(float arInput[NUM_PRUNING_INPUTS]);
 
             baseInputs((ConstTanBoard) anBoardOut, arInput);
+            ++MT_Get_engineStats()->cPruneNet;
             {
                 const neuralnet *nets[] = { &nnpRace, &nnpCrashed, &nnpContact };
-                const neuralnet *n = nets[pc - CLASS_RACE];
+                static const int aiNet[] = { NUMA_NET_PRACE, NUMA_NET_PCRASHED, NUMA_NET_PCONTACT };
+                const neuralnet *n = ThreadNet(nets[pc - CLASS_RACE], aiNet[pc - CLASS_RACE]);
 #if defined(USE_SIMD_INSTRUCTIONS)
                 (void) nnStates;        /* silence compiler warning */
                 NeuralNetEvaluateSSE(n, arInput, arOutput, NULL);
@@ -5493,6 +5903,8 @@ EvaluatePositionFull(NNState * nnStates, const TanBoard anBoard, float arOutput[
     } else {
         /* at leaf node; use static evaluation */
 
+        ++MT_Get_engineStats()->acEval[pc];
+
         if (acef[pc] (anBoard, arOutput, pci->bgv, nnStates))
             return -1;
 
@@ -5519,6 +5931,7 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
 {
     evalcache ec;
     uint32_t l;
+    enginestats *pes;
     /* This should be a part of the code that is called in all
      * time-consuming operations at a relatively steady rate, so is a
      * good choice for a callback function. */
@@ -5528,8 +5941,12 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
 
     PositionKey(anBoard, &ec.key);
 
+    pes = MT_Get_engineStats();
+    ++pes->cCacheLookup;
+
     ec.nEvalContext = EvalKey(pecx, nPlies, pci, FALSE);
     if ((l = CacheLookup(&cEval, &ec, arOutput, NULL)) == CACHEHIT) {
+        ++pes->cCacheHit;
         return 0;
     }
 
@@ -5538,7 +5955,7 @@ EvaluatePositionCache(NNState * nnStates, const TanBoard anBoard, float arOutput
 
     memcpy(ec.ar, arOutput, sizeof(float) * NUM_OUTPUTS);
     ec.ar[5] = 0.f;
-    CacheAdd(&cEval, &ec, l);
+    pes->cCacheEvict += CacheAdd(&cEval, &ec, l);
     return 0;
 }
 
@@ -5581,6 +5998,8 @@ ScoreMove(NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext
     pm->esMove.et = EVAL_EVAL;
     pm->esMove.ec = *pec;
     pm->esMove.ec.nPlies = nPlies;
+    pm->esMove.prc = NULL;
+    pm->esMove.nBook = 0;
 
     /* Score for move:
      * rScore is the primary score (cubeful/cubeless)
@@ -5591,12 +6010,48 @@ ScoreMove(NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext
     return 0;
 }
 
+/* Moves whose cache entries are fetched together before they are scored */
+#define SCORE_BATCH 16
+
+/* The nEvalContext under which ScoreMove() looks a move up in the cache,
+ * or -1 if it will not use the cache. */
+static int
+ScoreMoveCacheKey(const cubeinfo * pci, const evalcontext * pec, int nPlies)
+{
+    cubeinfo ci;
+
+    if (!cCache || pec->rNoise != 0.0f)
+        return -1;
+
+    /* as in ScoreMove(), and then EvaluatePositionCache() or
+     * EvaluatePositionCubeful3() */
+    memcpy(&ci, pci, sizeof(ci));
+    ci.fMove = !ci.fMove;
+
+    return EvalKey(pec, nPlies, &ci, pec->fCubeful);
+}
+
+static void
+PrefetchMove(const move * pm, int nEvalContext)
+{
+    evalcache ec;
+
+    PositionKeySwapped(&pm->key, &ec.key);
+    ec.nEvalContext = nEvalContext;
+
+    CachePrefetch(&cEval, &ec);
+}
+
 static int
 ScoreMoves(movelist * pml, const cubeinfo * pci, const evalcontext * pec, int nPlies)
 {
-    unsigned int i;
+    unsigned int i, j;
     int r = 0;                  /* return value */
     NNState *nnStates = MT_Get_nnState();
+    enginestats *pes = MT_Get_engineStats();
+    gint64 const t0 = g_get_monotonic_time();
+    int const iStat = MIN(nPlies, ENGINESTATS_PLIES - 1);
+    int const nEvalContext = ScoreMoveCacheKey(pci, pec, nPlies);
 
     pml->rBestScore = -99999.9f;
 
@@ -5607,6 +6062,10 @@ ScoreMoves(movelist * pml, const cubeinfo * pci, const evalcontext * pec, int nP
 
 
     for (i = 0; i < pml->cMoves; i++) {
+        if (nEvalContext >= 0 && i % SCORE_BATCH == 0)
+            for (j = i; j < MIN(i + SCORE_BATCH, pml->cMoves); j++)
+                PrefetchMove(pml->amMoves + j, nEvalContext);
+
         if (ScoreMove(nnStates, pml->amMoves + i, pci, pec, nPlies) < 0) {
             r = -1;
             break;
@@ -5626,6 +6085,9 @@ ScoreMoves(movelist * pml, const cubeinfo * pci, const evalcontext * pec, int nP
         nnStates[0].state = nnStates[1].state = nnStates[2].state = NNSTATE_NONE;
     }
 
+    ++pes->acPly[iStat];
+    pes->anPlyTime[iStat] += g_get_monotonic_time() - t0;
+
     return r;
 }
 
@@ -5633,9 +6095,12 @@ static int
 ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcontext * pec, unsigned int *bmovesi,
                  unsigned int prune_moves)
 {
-    unsigned int j;
+    unsigned int j, k;
     int r = 0;                  /* return value */
     NNState *nnStates = MT_Get_nnState();
+    enginestats *pes = MT_Get_engineStats();
+    gint64 const t0 = g_get_monotonic_time();
+    int const nEvalContext = ScoreMoveCacheKey(pci, pec, 0);
 
     pml->rBestScore = -99999.9f;
 
@@ -5646,6 +6111,10 @@ ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcontext * pec,
 
         unsigned int i = bmovesi[j];
 
+        if (nEvalContext >= 0 && j % SCORE_BATCH == 0)
+            for (k = j; k < MIN(j + SCORE_BATCH, prune_moves); k++)
+                PrefetchMove(pml->amMoves + bmovesi[k], nEvalContext);
+
         if (ScoreMove(nnStates, pml->amMoves + i, pci, pec, 0) < 0) {
             r = -1;
             break;
@@ -5661,6 +6130,9 @@ ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcontext * pec,
 
     nnStates[0].state = nnStates[1].state = nnStates[2].state = NNSTATE_NONE;
 
+    ++pes->acPly[0];
+    pes->anPlyTime[0] += g_get_monotonic_time() - t0;
+
     return r;
 }
 
@@ -5713,6 +6185,46 @@ FindBestMove(int anMove[8], int nDice0, int nDice1,
     return FindBestMovePlied(anMove, nDice0, nDice1, anBoard, pci, pec ? pec : &ecBasic, pec ? pec->nPlies : 0, aamf);
 }
 
+/*
+ * The first cBook moves of pml were found in the position book. The
+ * other moves only get a 0-ply score and are ranked after them, except
+ * keyMove which is evaluated as usual.
+ */
+
+static int
+ScoreBookMoves(movelist * pml, unsigned int cBook, const positionkey * keyMove, const cubeinfo * pci,
+               const evalcontext * pec)
+{
+    movelist ml = *pml;
+    unsigned int i;
+
+    if (ml.cMoves > cBook) {
+        ml.amMoves += cBook;
+        ml.cMoves -= cBook;
+        if (ScoreMoves(&ml, pci, pec, 0) < 0)
+            return -1;
+        qsort(ml.amMoves, ml.cMoves, sizeof(move), (cfunc) CompareMoves);
+    }
+
+    if (keyMove)
+        for (i = cBook; i < pml->cMoves; i++)
+            if (EqualKeys((*keyMove), pml->amMoves[i].key)) {
+                move m = pml->amMoves[i];
+
+                if (pec->nPlies && ScoreMove(NULL, &m, pci, pec, pec->nPlies) < 0)
+                    return -1;
+
+                memmove(pml->amMoves + cBook + 1, pml->amMoves + cBook, (i - cBook) * sizeof(move));
+                pml->amMoves[cBook++] = m;
+                break;
+            }
+
+    qsort(pml->amMoves, cBook, sizeof(move), (cfunc) CompareMoves);
+    pml->iMoveBest = 0;
+
+    return 0;
+}
+
 extern int
 FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard, positionkey * keyMove, const
                    float rThr, const cubeinfo * pci, const evalcontext * pec,
@@ -5750,6 +6262,20 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     pml->amMoves = pm;
     nMoves = pml->cMoves;
 
+    if (fBook) {
+        unsigned int cBook = BookLookupMoves(pml, anBoard, nDice0, nDice1, pci, pec);
+
+        if (cBook) {
+            if (ScoreBookMoves(pml, cBook, keyMove, pci, pec) < 0) {
+                g_free(pm);
+                pml->cMoves = 0;
+                pml->amMoves = NULL;
+                return -1;
+            }
+            return 0;
+        }
+    }
+
     mFilters = (pec->nPlies > 0 && pec->nPlies <= MAX_FILTER_PLIES) ?
         aamf[pec->nPlies - 1] : aamf[MAX_FILTER_PLIES - 1];
 
@@ -5883,6 +6409,9 @@ GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
     int i, j;
 
 
+    if (fBook && BookLookupCube(anBoard, pci, pec, aarOutput))
+        return 0;
+
     /* Setup cube for "no double" and "double, take" */
 
     memcpy(&aciCubePos[0], pci, sizeof(cubeinfo));
@@ -6092,7 +6621,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         if (pc == CLASS_HYPERGAMMON1 || pc == CLASS_HYPERGAMMON2 || pc == CLASS_HYPERGAMMON3) {
 
-            bearoffcontext *pbc = apbcHyper[pc - CLASS_HYPERGAMMON1];
+            bearoffcontext *pbc = HyperDatabase(pc - CLASS_HYPERGAMMON1);
             unsigned int nUs, nThem, iPos;
             unsigned int n;
 
@@ -6104,7 +6633,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
             n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
             iPos = nUs * n + nThem;
 
-            if (BearoffHyper(apbcHyper[pc - CLASS_HYPERGAMMON1], iPos, arOutput, arEquity))
+            if (BearoffHyper(pbc, iPos, arOutput, arEquity))
                 return -1;
 
         } else if (pc > CLASS_OVER && pc <= CLASS_PERFECT /* && ! pciMove->nMatchTo */ ) {
@@ -6288,6 +6817,7 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
     int ici;
     int fAll;
     evalcache ec;
+    enginestats *pes;
 
     if (!cCache || pec->rNoise != 0.0f)
         /* non-deterministic evaluation; never cache */
@@ -6297,6 +6827,7 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
     }
 
     PositionKey(anBoard, &ec.key);
+    pes = MT_Get_engineStats();
 
     /* check cache for existence for earlier calculation */
 
@@ -6311,9 +6842,11 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
 
         ec.nEvalContext = EvalKey(pec, nPlies, &aciCubePos[ici], TRUE);
 
+        ++pes->cCacheLookup;
         if (CacheLookup(&cEval, &ec, arOutput, arCubeful + ici) != CACHEHIT) {
             fAll = FALSE;
-        }
+        } else
+            ++pes->cCacheHit;
     }
 
     /* get equities */
@@ -6337,7 +6870,7 @@ EvaluatePositionCubeful3(NNState * nnStates, const TanBoard anBoard,
                 ec.ar[5] = arCubeful[ici];      /* Cubeful equity stored in slot 5 */
                 ec.nEvalContext = EvalKey(pec, nPlies, &aciCubePos[ici], TRUE);
 
-                CacheAdd(&cEval, &ec, GetHashKey(cEval.hashMask, &ec));
+                pes->cCacheEvict += CacheAdd(&cEval, &ec, GetHashKey(cEval.hashMask, &ec));
 
             }
         }
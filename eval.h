@@ -26,15 +26,11 @@
 #include "neuralnet.h"
 #include "cache.h"
 
-#define EXP_LOCK_FUN(ret, name, ...) \
-	typedef ret (*f_##name)( __VA_ARGS__); \
-	extern f_##name name; \
-	extern ret name##NoLocking( __VA_ARGS__); \
-	extern ret name##WithLocking( __VA_ARGS__)
-
 #define WEIGHTS_VERSION "1.01"
 #define WEIGHTS_VERSION_BINARY 1.01f
 #define WEIGHTS_MAGIC_BINARY 472.3782f
+/* binary weights laid out to be used in place from a mapping */
+#define WEIGHTS_MAGIC_IMAGE 472.3783f
 
 #define NUM_OUTPUTS 5
 #define NUM_CUBEFUL_OUTPUTS 4
@@ -191,6 +187,23 @@ typedef struct {
     rolloutcontext rc;
 } evalsetup;
 
+/* The evaluation setup stored with each move of a move list.  Analysed
+ * matches hold thousands of these, so the rollout context, which is most
+ * of an evalsetup and only used by rolled out moves, is shared (see
+ * InternRolloutContext()) rather than copied into every move. */
+typedef struct {
+    evaltype et;
+    evalcontext ec;
+    const rolloutcontext *prc;  /* NULL unless et == EVAL_ROLLOUT; its
+                                 * nGamesDone, rStoppedOnJSD and nSkip are
+                                 * always 0, the move's own are below */
+    unsigned int nGamesDone;
+    float rStoppedOnJSD;
+    int nSkip;
+    int nBook;                  /* quality of the book entry the evaluation
+                                 * was taken from, 0 if not from the book */
+} moveevalsetup;
+
 typedef enum {
     DOUBLE_TAKE,
     DOUBLE_PASS,
@@ -273,7 +286,7 @@ typedef struct {
     /* evaluation for this move */
     float arEvalMove[NUM_ROLLOUT_OUTPUTS];
     float arEvalStdDev[NUM_ROLLOUT_OUTPUTS];
-    evalsetup esMove;
+    moveevalsetup esMove;
     CMark cmark;
 } move;
 
@@ -285,7 +298,8 @@ extern bearoffcontext *pbc1;
 extern bearoffcontext *pbc2;
 extern bearoffcontext *pbcOS;
 extern bearoffcontext *pbcTS;
-extern bearoffcontext *apbcHyper[3];
+extern bearoffcontext *HyperDatabase(int i);
+extern int HyperDatabaseInstalled(int i);
 
 typedef struct {
     unsigned int cMoves;        /* and current move when building list */
@@ -343,7 +357,7 @@ extern classevalfunc acef[N_CLASSES];
      ( ( (pci)->fJacoby ) ? arEquity[ 2 ] : arEquity[ 1 ] ) : \
      ( ( (pci)->fCubeOwner == (pci)->fMove ) ? arEquity[ 0 ] : arEquity[ 3 ] ) )
 
-extern void EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pfProgress) (unsigned int));
+extern void EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff);
 
 extern int EvalShutdown(void);
 
@@ -354,8 +368,8 @@ extern int EvalNewWeights(int nSize);
 extern int EvalSave(const char *szWeights);
 
 
-EXP_LOCK_FUN(int, EvaluatePosition, NNState * nnStates, const TanBoard anBoard, float arOutput[],
-             cubeinfo * const pci, const evalcontext * pec);
+extern int EvaluatePosition(NNState * nnStates, const TanBoard anBoard, float arOutput[],
+                            cubeinfo * const pci, const evalcontext * pec);
 
 extern void
  InvertEvaluationR(float ar[NUM_ROLLOUT_OUTPUTS], const cubeinfo * pci);
@@ -363,13 +377,13 @@ extern void
 extern void
  InvertEvaluation(float ar[NUM_OUTPUTS]);
 
-EXP_LOCK_FUN(int, FindBestMove, int anMove[8], int nDice0, int nDice1,
-             TanBoard anBoard, const cubeinfo * pci, evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+extern int FindBestMove(int anMove[8], int nDice0, int nDice1,
+                        TanBoard anBoard, const cubeinfo * pci, evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
 
-EXP_LOCK_FUN(int, FindnSaveBestMoves, movelist * pml,
-             int nDice0, int nDice1, const TanBoard anBoard,
-             positionkey * keyMove, const float rThr,
-             const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
+extern int FindnSaveBestMoves(movelist * pml,
+                              int nDice0, int nDice1, const TanBoard anBoard,
+                              positionkey * keyMove, const float rThr,
+                              const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
 
 extern void
  PipCount(const TanBoard anBoard, unsigned int anPips[2]);
@@ -396,6 +410,7 @@ extern int
 
 extern void EvalCacheFlush(void);
 extern int EvalCacheResize(unsigned int cNew);
+extern void EvalCacheSetShared(int fShared);
 extern int EvalCacheStats(unsigned int *pcUsed, unsigned int *pcLookup, unsigned int *pcHit);
 extern double GetEvalCacheSize(void);
 void SetEvalCacheSize(unsigned int size);
@@ -464,15 +479,15 @@ extern float
  se_eq2mwc(const float rEq, const cubeinfo * pci);
 
 extern char
-*FormatEval(char *sz, evalsetup * pes);
+*FormatEval(char *sz, const moveevalsetup * pes);
 
 extern cubedecision FindCubeDecision(float arDouble[], float aarOutput[][NUM_ROLLOUT_OUTPUTS], const cubeinfo * pci);
 
-EXP_LOCK_FUN(int, GeneralCubeDecisionE, float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
-             const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, const evalsetup * pes);
+extern int GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
+                                const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, const evalsetup * pes);
 
-EXP_LOCK_FUN(int, GeneralEvaluationE, float arOutput[NUM_ROLLOUT_OUTPUTS],
-             const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec);
+extern int GeneralEvaluationE(float arOutput[NUM_ROLLOUT_OUTPUTS],
+                              const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec);
 
 extern int
  cmp_evalsetup(const evalsetup * pes1, const evalsetup * pes2);
@@ -480,6 +495,14 @@ extern int
 extern int
  cmp_evalcontext(const evalcontext * pec1, const evalcontext * pec2);
 
+extern int
+ cmp_moveevalsetup(const moveevalsetup * pmes1, const moveevalsetup * pmes2);
+
+extern const rolloutcontext *InternRolloutContext(const rolloutcontext * prc);
+extern void ClearRolloutContexts(void);
+extern void SetMoveEvalSetup(moveevalsetup * pmes, const evalsetup * pes);
+extern evalsetup *GetMoveEvalSetup(evalsetup * pes, const moveevalsetup * pmes);
+
 extern char
 *GetCubeRecommendation(const cubedecision cd);
 
@@ -507,7 +530,7 @@ extern float
 extern void
  RefreshMoveList(movelist * pml, int *ai);
 
-EXP_LOCK_FUN(int, ScoreMove, NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext * pec, int nPlies);
+extern int ScoreMove(NNState * nnStates, move * pm, const cubeinfo * pci, const evalcontext * pec, int nPlies);
 
 extern void
  CopyMoveList(movelist * pmlDest, const movelist * pmlSrc);
@@ -536,6 +559,11 @@ extern int
 extern void
  baseInputs(const TanBoard anBoard, float arInput[]);
 
+extern void
+ pointMasks(const TanBoard anBoard, unsigned int afOccupied[2], unsigned int afMade[2]);
+
+extern unsigned int NetInputs(const TanBoard anBoard, positionclass pc, int fPrune, float arInput[]);
+
 extern int CompareMoves(const move * pm0, const move * pm1);
 extern float EvalEfficiency(const TanBoard anBoard, positionclass pc, int ply);
 extern float Cl2CfMoney(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX);
@@ -41,6 +41,8 @@
 #include "matchid.h"
 #include "boardpos.h"
 #include "boarddim.h"
+#include "multithread.h"
+#include "sgf.h"
 
 #if defined(HAVE_PANGOCAIRO)
 #include <cairo.h>
@@ -507,7 +509,6 @@ WritePNG(const char *sz, unsigned char *puch, unsigned int nStride, unsigned int
     }
 
     if (setjmp(png_jmpbuf(ppng))) {
-        outputerr(sz);
         fclose(pf);
         png_destroy_write_struct(&ppng, &pinfo);
         return -1;
@@ -578,6 +579,7 @@ GenerateImage(renderimages * pri, renderdata * prd,
     int fResign = 0, nResignOrientation = 0;
     int anArrowPosition[2];
     int cube_owner;
+    int n;
 
     memcpy(anBoardTemp, anBoard, sizeof anBoardTemp);
 
@@ -586,10 +588,7 @@ GenerateImage(renderimages * pri, renderdata * prd,
 
     /* allocate memory for board */
 
-    if (!(puch = (unsigned char *) malloc(BOARD_WIDTH * BOARD_HEIGHT * nSize * nSize * 3))) {
-        outputerr("malloc");
-        return -1;
-    }
+    puch = g_malloc(BOARD_WIDTH * BOARD_HEIGHT * nSize * nSize * 3);
 
     /* calculate cube position */
 
@@ -658,11 +657,34 @@ GenerateImage(renderimages * pri, renderdata * prd,
 
     /* write png */
 
-    WritePNG(szName, puch, nSizeX * nSize * 3, nSizeX * nSize, nSizeY * nSize);
+    n = WritePNG(szName, puch, nSizeX * nSize * 3, nSizeX * nSize, nSizeY * nSize);
 
-    free(puch);
+    g_free(puch);
 
-    return 0;
+    return n;
+}
+
+/* The board, chequer, dice and cube layers only depend on the
+ * appearance, so keep the last set rendered for the next export */
+
+static renderdata rdExport;
+static renderimages riExport;
+static int fExportImages = FALSE;
+
+static renderimages *
+ExportImages(const renderdata * prd)
+{
+    if (fExportImages) {
+        if (!memcmp(prd, &rdExport, sizeof(renderdata)))
+            return &riExport;
+        FreeImages(&riExport);
+    }
+
+    memcpy(&rdExport, prd, sizeof(renderdata));
+    RenderImages(&rdExport, &riExport);
+    fExportImages = TRUE;
+
+    return &riExport;
 }
 
 extern void
@@ -689,7 +711,6 @@ CommandExportPositionPNG(char *sz)
     } else
 #endif
     {
-        renderimages ri;
         renderdata rd;
 
         CopyAppearance(&rd);
@@ -697,14 +718,256 @@ CommandExportPositionPNG(char *sz)
 
         g_assert(rd.nSize >= 1);
 
-        RenderImages(&rd, &ri);
+        if (GenerateImage(ExportImages(&rd), &rdExport, msBoard(), sz,
+                          exsExport.nPNGSize, BOARD_WIDTH, BOARD_HEIGHT, 0, 0,
+                          ms.fMove, ms.fTurn, fCubeUse, ms.anDice, ms.nCube, ms.fDoubled, ms.fCubeOwner) < 0)
+            outputf(_("Error creating image file %s\n"), sz);
+    }
+}
+
+/*
+ * Batch export of every position of a game or match as PNG images.
+ * The positions are collected first and then composited and written
+ * by the worker threads, all sharing one set of rendered layers.
+ */
+
+typedef struct {
+    TanBoard anBoard;
+    unsigned int anDice[2];
+    int fMove, fTurn, nCube, fDoubled, fCubeOwner;
+    char *szName;
+    int fFailed;
+} pngposition;
+
+typedef struct {
+    GArray *aPositions;
+    renderimages *pri;
+    renderdata *prd;
+    int iNext;
+    int cDone;
+} pngbatch;
+
+static pngbatch *ppbProgress;
+
+static char *
+filename_from_iPosition(const char *szBase, const int iGame, const int iPosition)
+{
+    const char *szExtension = strrchr(szBase, '.');
+
+    if (!szExtension || strchr(szExtension, G_DIR_SEPARATOR))
+        return g_strdup_printf("%s_%03d_%03d.png", szBase, iGame + 1, iPosition + 1);
 
-        GenerateImage(&ri, &rd, msBoard(), sz,
-                      exsExport.nPNGSize, BOARD_WIDTH, BOARD_HEIGHT, 0, 0,
-                      ms.fMove, ms.fTurn, fCubeUse, ms.anDice, ms.nCube, ms.fDoubled, ms.fCubeOwner);
+    return g_strdup_printf("%.*s_%03d_%03d%s", (int) (szExtension - szBase), szBase,
+                           iGame + 1, iPosition + 1, szExtension);
+}
 
-        FreeImages(&ri);
+static void
+AddPNGPosition(pngbatch * ppb, const matchstate * pms, const char *szBase, const int iGame, const int iPosition)
+{
+    pngposition pp;
+
+    memcpy(pp.anBoard, pms->anBoard, sizeof(TanBoard));
+    pp.anDice[0] = pms->anDice[0];
+    pp.anDice[1] = pms->anDice[1];
+    pp.fMove = pms->fMove;
+    pp.fTurn = pms->fTurn;
+    pp.nCube = pms->nCube;
+    pp.fDoubled = pms->fDoubled;
+    pp.fCubeOwner = pms->fCubeOwner;
+    pp.szName = filename_from_iPosition(szBase, iGame, iPosition);
+    pp.fFailed = FALSE;
+
+    g_array_append_val(ppb->aPositions, pp);
+}
+
+static void
+AddPNGGame(pngbatch * ppb, listOLD * plGame, const char *szBase, const int iGame)
+{
+    listOLD *pl;
+    moverecord *pmr;
+    matchstate msExport;
+    int iPosition = 0;
+
+    msExport.nMatchTo = 0;
+
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
+
+        pmr = pl->p;
+
+        FixMatchState(&msExport, pmr);
+
+        switch (pmr->mt) {
+
+        case MOVE_NORMAL:
+
+            if (pmr->fPlayer != msExport.fMove)
+                SwapSides(msExport.anBoard);
+
+            msExport.fTurn = msExport.fMove = pmr->fPlayer;
+            msExport.anDice[0] = pmr->anDice[0];
+            msExport.anDice[1] = pmr->anDice[1];
+
+            AddPNGPosition(ppb, &msExport, szBase, iGame, iPosition++);
+            break;
+
+        case MOVE_DOUBLE:
+        case MOVE_TAKE:
+        case MOVE_DROP:
+
+            AddPNGPosition(ppb, &msExport, szBase, iGame, iPosition++);
+            break;
+
+        default:
+
+            break;
+
+        }
+
+        ApplyMoveRecord(&msExport, plGame, pmr);
+
+    }
+}
+
+static void
+WritePNGPositions(pngbatch * ppb)
+{
+    int i;
+
+    while ((i = MT_SafeIncValue(&ppb->iNext) - 1) < (int) ppb->aPositions->len) {
+        pngposition *pp = &g_array_index(ppb->aPositions, pngposition, i);
+
+        pp->fFailed = GenerateImage(ppb->pri, ppb->prd, (ConstTanBoard) pp->anBoard, pp->szName,
+                                    (int) ppb->prd->nSize, BOARD_WIDTH, BOARD_HEIGHT, 0, 0,
+                                    pp->fMove, pp->fTurn, fCubeUse, pp->anDice, pp->nCube,
+                                    pp->fDoubled, pp->fCubeOwner) < 0;
+
+        MT_SafeInc(&ppb->cDone);
+    }
+}
+
+static gboolean
+PNGBatchProgress(gpointer UNUSED(unused))
+{
+    if (ppbProgress)
+        ProgressValue(g_atomic_int_get(&ppbProgress->cDone));
+
+    return TRUE;
+}
+
+static void
+ExportPNGPositions(pngbatch * ppb)
+{
+    renderdata rd;
+    guint i, cFailed = 0;
+
+    if (!ppb->aPositions->len) {
+        outputl(_("There are no positions to export."));
+        return;
+    }
+
+    /* the layers are shared read-only by all the threads */
+
+    CopyAppearance(&rd);
+    rd.nSize = exsExport.nPNGSize;
+#if defined(USE_BOARD3D)
+    rd.fDisplayType = DT_2D;
+#endif
+
+    g_assert(rd.nSize >= 1);
+
+    ppb->pri = ExportImages(&rd);
+    ppb->prd = &rdExport;
+    ppb->iNext = ppb->cDone = 0;
+
+    ProgressStartValue(_("Writing PNG images"), (int) ppb->aPositions->len);
+    ppbProgress = ppb;
+
+    mt_add_tasks(MIN(MT_GetNumThreads(), ppb->aPositions->len), (AsyncFun) WritePNGPositions, ppb, NULL);
+    MT_WaitForTasks(PNGBatchProgress, 250, FALSE);
+
+    ppbProgress = NULL;
+    ProgressEnd();
+
+    for (i = 0; i < ppb->aPositions->len; ++i) {
+        pngposition *pp = &g_array_index(ppb->aPositions, pngposition, i);
+
+        if (pp->fFailed) {
+            outputf(_("Error creating image file %s\n"), pp->szName);
+            ++cFailed;
+        }
     }
+
+    outputf(ngettext("%u position exported.\n", "%u positions exported.\n",
+                     ppb->aPositions->len - cFailed), ppb->aPositions->len - cFailed);
+}
+
+static pngbatch *
+NewPNGBatch(void)
+{
+    pngbatch *ppb = g_new0(pngbatch, 1);
+
+    ppb->aPositions = g_array_new(FALSE, FALSE, sizeof(pngposition));
+
+    return ppb;
+}
+
+static void
+FreePNGBatch(pngbatch * ppb)
+{
+    guint i;
+
+    for (i = 0; i < ppb->aPositions->len; ++i)
+        g_free(g_array_index(ppb->aPositions, pngposition, i).szName);
+
+    g_array_free(ppb->aPositions, TRUE);
+    g_free(ppb);
+}
+
+extern void
+CommandExportGamePNG(char *sz)
+{
+    pngbatch *ppb;
+
+    sz = NextToken(&sz);
+
+    if (!plGame) {
+        outputl(_("No game in progress (type `new game' to start one)."));
+        return;
+    }
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to export to (see `help export game png')."));
+        return;
+    }
+
+    ppb = NewPNGBatch();
+    AddPNGGame(ppb, plGame, sz, getGameNumber(plGame));
+    ExportPNGPositions(ppb);
+    FreePNGBatch(ppb);
+}
+
+extern void
+CommandExportMatchPNG(char *sz)
+{
+    pngbatch *ppb;
+    listOLD *pl;
+    int i;
+
+    sz = NextToken(&sz);
+
+    if (!CheckGameExists())
+        return;
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to export to (see `help export match png')."));
+        return;
+    }
+
+    ppb = NewPNGBatch();
+    for (pl = lMatch.plNext, i = 0; pl != &lMatch; pl = pl->plNext, i++)
+        AddPNGGame(ppb, pl->p, sz, i);
+    ExportPNGPositions(ppb);
+    FreePNGBatch(ppb);
 }
 
 
@@ -1390,3 +1653,136 @@ CommandExportMatchSnowieTxt(char *sz)
 {
     ExportMatchMat(sz, TRUE);
 }
+
+/*
+ * Export every game of an SGF file, or of all the SGF files in a
+ * folder, one game at a time so that memory use does not grow with
+ * the size of the archive.  Game n of foo.sgf is written to foo_nnn
+ * in the output folder.
+ */
+
+static gint
+CompareFilenames(gconstpointer a, gconstpointer b)
+{
+    return strcmp(a, b);
+}
+
+static void
+ExportArchive(char *sz, const char *szExtension, void (*pfExport) (char *))
+{
+    char *szIn, *szOut;
+    GList *plFiles = NULL, *pl;
+    int cGames = 0, cFiles = 0;
+    int fSaveConfirmSave;
+
+    if (!(szIn = NextToken(&sz)) || !(szOut = NextToken(&sz))) {
+        outputf(_("You must specify an SGF file or folder and an output folder (see `help export archive %s').\n"),
+                szExtension);
+        return;
+    }
+
+    if (g_file_test(szIn, G_FILE_TEST_IS_DIR)) {
+        GDir *dir;
+        GError *error = NULL;
+        const char *szName;
+
+        if (!(dir = g_dir_open(szIn, 0, &error))) {
+            outputerrf("%s", error->message);
+            g_error_free(error);
+            return;
+        }
+        while ((szName = g_dir_read_name(dir)) != NULL) {
+            size_t len = strlen(szName);
+
+            if (len > 4 && !StrCaseCmp(szName + len - 4, ".sgf"))
+                plFiles = g_list_prepend(plFiles, g_build_filename(szIn, szName, NULL));
+        }
+        g_dir_close(dir);
+
+        if (!plFiles) {
+            outputf(_("No SGF files found in %s.\n"), szIn);
+            return;
+        }
+        plFiles = g_list_sort(plFiles, CompareFilenames);
+    } else
+        plFiles = g_list_prepend(NULL, g_strdup(szIn));
+
+    if (g_mkdir_with_parents(szOut, 0755) < 0) {
+        outputerr(szOut);
+        g_list_free_full(plFiles, g_free);
+        return;
+    }
+
+    if (!get_input_discard()) {
+        g_list_free_full(plFiles, g_free);
+        return;
+    }
+
+    fSaveConfirmSave = fConfirmSave;
+    fConfirmSave = FALSE;
+
+    for (pl = plFiles; pl && !fInterrupt; pl = pl->next) {
+        sgfstream *pss;
+        char *szBase, *pch;
+        int iGame;
+
+        if (!(pss = SGFStreamOpen(pl->data)))
+            continue;
+
+        szBase = g_path_get_basename(pl->data);
+        if ((pch = strrchr(szBase, '.')) != NULL)
+            *pch = 0;
+
+        for (iGame = 0; !fInterrupt && SGFStreamNextGame(pss); iGame++) {
+            char *szName = g_strdup_printf("%s_%03d.%s", szBase, iGame + 1, szExtension);
+            char *szFile = g_build_filename(szOut, szName, NULL);
+            char *szQuoted = g_strdup_printf("\"%s\"", szFile);
+
+            pfExport(szQuoted);
+            cGames++;
+
+            g_free(szQuoted);
+            g_free(szFile);
+            g_free(szName);
+        }
+
+        SGFStreamClose(pss);
+        g_free(szBase);
+        cFiles++;
+    }
+
+    fConfirmSave = fSaveConfirmSave;
+    g_list_free_full(plFiles, g_free);
+
+    outputf(_("%d games exported from %d files.\n"), cGames, cFiles);
+}
+
+extern void
+CommandExportArchiveHtml(char *sz)
+{
+    ExportArchive(sz, "html", CommandExportGameHtml);
+}
+
+extern void
+CommandExportArchiveLaTeX(char *sz)
+{
+    ExportArchive(sz, "tex", CommandExportGameLaTeX);
+}
+
+extern void
+CommandExportArchivePDF(char *sz)
+{
+    ExportArchive(sz, "pdf", CommandExportGamePDF);
+}
+
+extern void
+CommandExportArchivePS(char *sz)
+{
+    ExportArchive(sz, "ps", CommandExportGamePS);
+}
+
+extern void
+CommandExportArchiveText(char *sz)
+{
+    ExportArchive(sz, "txt", CommandExportGameText);
+}
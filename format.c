@@ -1100,8 +1100,8 @@ static int
 DumpHypergammon1(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[0]);
-    return BearoffDump(apbcHyper[0], anBoard, szOutput);
+    g_assert(HyperDatabase(0));
+    return BearoffDump(HyperDatabase(0), anBoard, szOutput);
 
 }
 
@@ -1109,8 +1109,8 @@ static int
 DumpHypergammon2(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[1]);
-    return BearoffDump(apbcHyper[1], anBoard, szOutput);
+    g_assert(HyperDatabase(1));
+    return BearoffDump(HyperDatabase(1), anBoard, szOutput);
 
 }
 
@@ -1118,8 +1118,8 @@ static int
 DumpHypergammon3(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[2]);
-    return BearoffDump(apbcHyper[2], anBoard, szOutput);
+    g_assert(HyperDatabase(2));
+    return BearoffDump(HyperDatabase(2), anBoard, szOutput);
 
 }
 
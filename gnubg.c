@@ -67,6 +67,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 
 #include "analysis.h"
 #include "backgammon.h"
+#include "book.h"
 #include "dice.h"
 #include "drawboard.h"
 #include "eval.h"
@@ -123,6 +124,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 #include "inc3d.h"
 #endif
 #include "multithread.h"
+#include "numa.h"
 #include "openurl.h"
 
 #if defined(MSDOS) || defined(__MSDOS__) || defined(WIN32)
@@ -207,6 +209,7 @@ int fCubeUse = TRUE;
 int fDisplay = TRUE;
 int fFullScreen = FALSE;
 int fGotoFirstGame = FALSE;
+int fSGFIndex = FALSE;
 int fInvertMET = FALSE;
 int fJacoby = TRUE;
 int fOutputRawboard = FALSE;
@@ -236,6 +239,7 @@ unsigned int nDefaultLength = 7;
  * can be chang edin menu
  */
 int fBackgroundAnalysis = FALSE;
+int fAnalyseIncremental = FALSE;
 
 /*
  * if we analyze in the background, we turn on the following global flag
@@ -530,6 +534,7 @@ static char szDICE[] = N_("<die> <die>"),
     szENDPOINT[] = N_("<host>:<port>"),
     szER[] = "evaluation|rollout",
     szFILENAME[] = N_("<filename>"),
+    szFILENAMES[] = N_("<filename> ..."),
     szKEYVALUE[] = N_("[<key>=<value> ...]"),
     szLENGTH[] = N_("<length>"),
     szLIMIT[] = N_("<limit>"),
@@ -568,6 +573,11 @@ static char szDICE[] = N_("<die> <die>"),
     szXGID[] = N_("<xgid>"),
     szURL[] = "<URL>",
     szMAXERR[] = N_("<fraction>"), szMINGAMES[] = N_("<minimum games to rollout>"), szFOLDER[] = N_("<folder>"),
+    szFOLDERBATCH[] = N_("<folder> [batch size]"),
+    szBOOKADD[] = N_("<filename> [moves per game]"),
+    szSELFPLAY[] = N_("<games> [match length [SGF prefix]]"),
+    szARCHIVE[] = N_("<SGF file or folder> <output folder>"),
+    szLOADGAMES[] = N_("<filename> <first game> [last game]"),
 #if defined(USE_GTK)
     szWARN[] = N_("[<warning>]"), szWARNYN[] = N_("<warning> on|off"),
 #endif
@@ -584,6 +594,7 @@ char *default_export_folder = NULL;
 char *default_sgf_folder = NULL;
 
 const char *szHomeDirectory;
+char *szProgramPath;
 
 static char const *aszBuildInfo[] = {
 #if defined(USE_PYTHON)
@@ -1855,7 +1866,7 @@ FormatMoveHint(char *sz, const matchstate * pms, movelist * pml,
         case EVAL_ROLLOUT:
             strcat(sz, OutputRolloutResult("     ", NULL, (float (*)[NUM_ROLLOUT_OUTPUTS])
                                            ar, (float (*)[NUM_ROLLOUT_OUTPUTS])
-                                           arStdDev, &ci, 0, 1, pml->amMoves[i].esMove.rc.fCubeful));
+                                           arStdDev, &ci, 0, 1, pml->amMoves[i].esMove.prc->fCubeful));
             break;
         default:
             break;
@@ -1873,9 +1884,12 @@ FormatMoveHint(char *sz, const matchstate * pms, movelist * pml,
             strcat(sz, OutputEvalContext(&pml->amMoves[i].esMove.ec, TRUE));
             strcat(sz, "\n");
             break;
-        case EVAL_ROLLOUT:
-            strcat(sz, OutputRolloutContext("        ", &pml->amMoves[i].esMove.rc));
-            break;
+        case EVAL_ROLLOUT:{
+                evalsetup es;
+
+                strcat(sz, OutputRolloutContext("        ", &GetMoveEvalSetup(&es, &pml->amMoves[i].esMove)->rc));
+                break;
+            }
 
         default:
             break;
@@ -2889,6 +2903,9 @@ SaveRNGSettings(FILE * pf, const char *sz, rng rngCurrent, rngcontext * rngctx)
     case RNG_MERSENNE:
         fprintf(pf, "%s rng mersenne\n", sz);
         break;
+    case RNG_PHILOX:
+        fprintf(pf, "%s rng philox\n", sz);
+        break;
     case RNG_RANDOM_DOT_ORG:
         fprintf(pf, "%s rng random.org\n", sz);
         break;
@@ -3088,6 +3105,7 @@ SaveAnalysisSettings(FILE * pf)
     fprintf(pf, "set analysis player 1 analyse %s\n", afAnalysePlayers[1] ? "yes" : "no");
     fprintf(pf, "set automatic db %s\n", fAutoDB ? "on" : "off");
     fprintf(pf, "set analysis background %s\n", fBackgroundAnalysis ? "on" : "off");
+    fprintf(pf, "set analysis incremental %s\n", fAnalyseIncremental ? "on" : "off");
     fprintf(pf, "set analysis filesetting %s\n", aszAnalyzeFileSettingCommands[AnalyzeFileSettingDef]);
 }
 
@@ -3101,6 +3119,7 @@ SaveImportExportSettings(FILE * pf)
         fprintf(pf, "set export folder \"%s\"\n", default_export_folder);
     if (default_sgf_folder && *default_sgf_folder)
         fprintf(pf, "set sgf folder \"%s\"\n", default_sgf_folder);
+    fprintf(pf, "set sgf index %s\n", fSGFIndex ? "on" : "off");
 
     fprintf(pf, "set export include annotations %s\n", exsExport.fIncludeAnnotation ? "yes" : "no");
     fprintf(pf, "set export include analysis %s\n", exsExport.fIncludeAnalysis ? "yes" : "no");
@@ -3298,7 +3317,10 @@ SaveEvaluationSettings(FILE * pf)
     fprintf(pf, "set cache %u\n", GetEvalCacheEntries());
     fprintf(pf, "set matchequitytable \"%s\"\n", miCurrent.szFileName);
     fprintf(pf, "set invert matchequitytable %s\n", fInvertMET ? "on" : "off");
+    if (fBook)
+        fprintf(pf, "set book \"%s\"\n", BookGetFile());
 #if defined(USE_MULTITHREAD)
+    fprintf(pf, "set numa %s\n", fNuma ? "on" : "off");
     fprintf(pf, "set threads %u\n", MT_GetNumThreads());
 #endif
 }
@@ -3433,6 +3455,9 @@ CommandSaveSettings(char *szParam)
     SavePlayerSettings(pf);
     SaveRNGSettings(pf, "set", rngCurrent, rngctxCurrent);
     SaveRolloutSettings(pf, "set rollout", &rcRollout);
+    fprintf(pf, "set rollout shards %u\n", nRolloutShards);
+    if (szRolloutShardCommand)
+        fprintf(pf, "set rollout shardcommand %s\n", szRolloutShardCommand);
     SaveImportExportSettings(pf);
     SaveSoundSettings(pf);
     RelationalSaveSettings(pf);
@@ -4249,20 +4274,6 @@ HandleInterrupt(int UNUSED(idSignal))
     errno = saved_errno;
 }
 
-static void
-BearoffProgress(unsigned int i)
-{
-#if defined(USE_GTK)
-    if (fX) {
-        GTKBearoffProgress(i);
-        return;
-    }
-#endif
-    putchar("\\|/-"[(i / 1000) % 4]);
-    putchar('\r');
-    fflush(stdout);
-}
-
 static void
 VersionMessage(void)
 {
@@ -4431,7 +4442,7 @@ init_nets(int fNoBearoff)
 {
     char *gnubg_weights = BuildFilename("gnubg.weights");
     char *gnubg_weights_binary = BuildFilename("gnubg.wd");
-    EvalInitialise(gnubg_weights, gnubg_weights_binary, fNoBearoff, fShowProgress ? BearoffProgress : NULL);
+    EvalInitialise(gnubg_weights, gnubg_weights_binary, fNoBearoff);
     g_free(gnubg_weights);
     g_free(gnubg_weights_binary);
 }
@@ -4608,9 +4619,12 @@ main(int argc, char *argv[])
 #endif
     char *pchMatch = NULL;
     char *met = NULL;
+    gint64 usStart;
 
     static char *pchCommands = NULL, *lang = NULL;
     static int fNoBearoff = FALSE, fNoX = FALSE, fSplash = FALSE, fNoTTY = FALSE, show_version = FALSE, debug = FALSE;
+    static int fRolloutWorker = FALSE;
+    FILE *pfRolloutResults = NULL;
     GOptionEntry ao[] = {
         {"no-bearoff", 'b', 0, G_OPTION_ARG_NONE, &fNoBearoff,
          N_("Do not use bearoff database"), NULL},
@@ -4643,6 +4657,8 @@ main(int argc, char *argv[])
          N_("Specify location of program documentation"), NULL},
         {"prefsdir", 's', 0, G_OPTION_ARG_STRING, &prefsdir,
          N_("Specify location of user's preferences directory"), NULL},
+        {"rollout-worker", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &fRolloutWorker,
+         N_("Play the rollout trials sent on standard input and exit"), NULL},
         {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
     };
     GError *error = NULL;
@@ -4694,6 +4710,28 @@ main(int argc, char *argv[])
     if (argc > 1 && *argv[1])
         pchMatch = matchfile_from_argv(argv[1]);
 
+    /* remember where we were started from, to start rollout workers */
+    if (g_path_is_absolute(argv[0]))
+        szProgramPath = g_strdup(argv[0]);
+    else if (strchr(argv[0], G_DIR_SEPARATOR) || strchr(argv[0], '/')) {
+        gchar *szCurrent = g_get_current_dir();
+        szProgramPath = g_build_filename(szCurrent, argv[0], NULL);
+        g_free(szCurrent);
+    } else if ((szProgramPath = g_find_program_in_path(argv[0])) == NULL)
+        szProgramPath = g_strdup(argv[0]);
+
+    if (fRolloutWorker) {
+        /* the results go to the real standard output; anything else
+         * printed goes to standard error */
+        pfRolloutResults = fdopen(dup(STDOUT_FILENO), "wb");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        if (!pfRolloutResults) {
+            outputerrf(_("Cannot write rollout results: %s\n"), g_strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        fNoX = TRUE;
+    }
+
     if (!debug)
         g_log_set_handler(NULL, G_LOG_LEVEL_DEBUG, &null_debug, NULL);
 
@@ -4753,9 +4791,11 @@ main(int argc, char *argv[])
     init_rng();
 
     PushSplash(pwSplash, _("Initialising"), _("match equity table"));
+    usStart = g_get_monotonic_time();
     met = BuildFilename2("met", "Kazaross-XG2.xml");
     InitMatchEquity(met);
     g_free(met);
+    StartupPhase(N_("match equity table"), usStart);
 
     PushSplash(pwSplash, _("Initialising"), _("neural nets"));
     init_nets(fNoBearoff);
@@ -4771,7 +4811,9 @@ main(int argc, char *argv[])
 
 #if defined(USE_PYTHON)
     PushSplash(pwSplash, _("Initialising"), "Python");
+    usStart = g_get_monotonic_time();
     PythonInitialise(argv[0]);
+    StartupPhase(N_("Python"), usStart);
 #endif
 
     SetExitSoundOff();
@@ -4779,7 +4821,9 @@ main(int argc, char *argv[])
     /* -r option given */
     if (!fNoRC) {
         PushSplash(pwSplash, _("Loading"), _("User Settings"));
+        usStart = g_get_monotonic_time();
         LoadRCFiles();
+        StartupPhase(N_("user settings"), usStart);
     }
 
     strcpy(ap[0].szName, default_names[0]);
@@ -4793,6 +4837,9 @@ main(int argc, char *argv[])
     MT_StartThreads();
 #endif
 
+    if (fRolloutWorker)
+        exit(RolloutWorker(stdin, pfRolloutResults) ? EXIT_FAILURE : EXIT_SUCCESS);
+
     /* start-up sound */
     playSound(SOUND_START);
 
@@ -5339,6 +5386,13 @@ CommandHistory(char *UNUSED(sz))
 
 #endif                          /* HAVE_LIB_READLINE */
 
+extern void
+CommandClearEngineStats(char *UNUSED(sz))
+{
+    EngineStatsReset();
+    outputl(_("Engine statistics have been reset"));
+}
+
 extern void
 CommandClearHint(char *UNUSED(sz))
 {
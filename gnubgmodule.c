@@ -785,9 +785,163 @@ PythonNextTurn(PyObject * UNUSED(self), PyObject * UNUSED(args))
 
 }
 
+/*
+ * Engine calls release the GIL so that other Python threads can run
+ * while the worker pool is busy. Calls from several Python threads are
+ * serialised by pyEngineLock, since the task queue and the globals the
+ * engine uses are shared. The other entry points that read or change
+ * the match or the settings hold it too, keeping the GIL, so that they
+ * wait for an engine call to finish. It is recursive, as commands and
+ * hooks may call back into the module. With the GUI up, pending events
+ * are processed while waiting and may run Python code, so there the
+ * GIL is kept and calls are not serialised, as before.
+ */
+
+#if GLIB_CHECK_VERSION (2,32,0)
+static GRecMutex pyEngineLock;
+#define PyEngineLock() g_rec_mutex_lock(&pyEngineLock)
+#define PyEngineUnlock() g_rec_mutex_unlock(&pyEngineLock)
+#else
+static GStaticRecMutex pyEngineLock = G_STATIC_REC_MUTEX_INIT;
+#define PyEngineLock() g_static_rec_mutex_lock(&pyEngineLock)
+#define PyEngineUnlock() g_static_rec_mutex_unlock(&pyEngineLock)
+#endif
+
+static PyThreadState *
+PyEngineEnter(void)
+{
+    PyThreadState *ts;
+
+#if defined(USE_GTK)
+    if (fX)
+        return NULL;
+#endif
+
+    ts = PyEval_SaveThread();
+    PyEngineLock();
+
+    return ts;
+}
+
+/*
+ * The engine uses the calling thread's local data (move buffers,
+ * neural net state, statistics), which Python threads started by a
+ * script do not have. They share one set, which is safe as their calls
+ * are serialised by pyEngineLock. With the GUI up, waiting for the
+ * workers processes GTK events, so only the main thread may call in.
+ * Returns FALSE with an exception set if the engine may not be used.
+ */
+static int
+PyEngineThreadOK(void)
+{
+#if defined(USE_MULTITHREAD)
+    static ThreadLocalData *ptldForeign = NULL;
+
+    if (MT_TryGetTLD())
+        return TRUE;
+
+#if defined(USE_GTK)
+    if (fX) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        _("the engine can only be used from the main thread while the GUI is running"));
+        return FALSE;
+    }
+#endif
+
+    /* the GIL is held, so only one thread gets here at a time */
+    if (!ptldForeign)
+        ptldForeign = MT_CreateThreadLocalData(MT_FOREIGN_THREAD_ID);
+    TLSSetValue(td.tlsItem, (size_t) ptldForeign);
+#endif
+    return TRUE;
+}
+
+static void
+PyEngineLeave(PyThreadState * ts)
+{
+    if (!ts)
+        return;
+
+    PyEngineUnlock();
+    PyEval_RestoreThread(ts);
+}
+
+/* Take pyEngineLock but keep the GIL, which is only let go while
+ * waiting for the lock so that the thread holding it can finish */
+static void
+PyEngineSerialise(void)
+{
+    PyThreadState *ts;
+
+#if defined(USE_GTK)
+    if (fX)
+        return;
+#endif
+
+    ts = PyEval_SaveThread();
+    PyEngineLock();
+    PyEval_RestoreThread(ts);
+}
+
+static void
+PyEngineUnserialise(void)
+{
+#if defined(USE_GTK)
+    if (fX)
+        return;
+#endif
+
+    PyEngineUnlock();
+}
+
+#define PY_SERIALISED(fn) \
+static PyObject * \
+fn##Serialised(PyObject * self, PyObject * args) \
+{ \
+    PyObject *ret; \
+ \
+    PyEngineSerialise(); \
+    ret = fn(self, args); \
+    PyEngineUnserialise(); \
+ \
+    return ret; \
+}
+
+#define PY_SERIALISED_KEYWORDS(fn) \
+static PyObject * \
+fn##Serialised(PyObject * self, PyObject * args, PyObject * keywds) \
+{ \
+    PyObject *ret; \
+ \
+    PyEngineSerialise(); \
+    ret = fn(self, args, keywds); \
+    PyEngineUnserialise(); \
+ \
+    return ret; \
+}
+
+/* RunAsyncProcess() without the GIL and without progress output */
+static int
+PyEngineRun(AsyncFun fun, void *data, const char *szMsg)
+{
+    PyThreadState *ts = PyEngineEnter();
+    int fSaveShowProg = fShowProgress;
+    int ret;
+
+    fShowProgress = FALSE;
+    ret = RunAsyncProcess(fun, data, szMsg);
+    fShowProgress = fSaveShowProg;
+
+    PyEngineLeave(ts);
+
+    return ret;
+}
+
+/* called from hint_move(), which runs without the GIL */
 static int
 PythonHint_Callback(procrecorddata * pr)
 {
+    PyGILState_STATE gstate = PyGILState_Ensure();
     char szMove[FORMATEDMOVESIZE];
     PyObject *list = (PyObject *) pr->pvUserData;
     PyObject *hintdict = NULL, *ctxdict = NULL, *details = NULL;
@@ -795,7 +949,7 @@ PythonHint_Callback(procrecorddata * pr)
     int index = (int) (ptrdiff_t) pr->avOutputData[PROCREC_HINT_ARGOUT_INDEX];
     const matchstate *pms = pr->avOutputData[PROCREC_HINT_ARGOUT_MATCHSTATE];
     const movelist *pml = pr->avOutputData[PROCREC_HINT_ARGOUT_MOVELIST];
-    const evalsetup *pes = &pml->amMoves[index].esMove;
+    const moveevalsetup *pes = &pml->amMoves[index].esMove;
     float rEq = pml->amMoves[index].rScore;
     float rEqTop = pml->amMoves[0].rScore;
     float rEqDiff = rEq - rEqTop;
@@ -828,10 +982,10 @@ PythonHint_Callback(procrecorddata * pr)
                                     "probs-std", s[0], s[1], s[2], s[3], s[4],
                                     "match-eq", p[OUTPUT_EQUITY],
                                     "cubeful-eq", p[OUTPUT_CUBEFUL_EQUITY],
-                                    "score", pmi->rScore, "score2", pmi->rScore2, "trials", pes->rc.nGamesDone,
-                                    "stopped-on-jsd", pes->rc.rStoppedOnJSD);
+                                    "score", pmi->rScore, "score2", pmi->rScore2, "trials", pes->nGamesDone,
+                                    "stopped-on-jsd", pes->rStoppedOnJSD);
 
-            ctxdict = RolloutContextToPy(&pes->rc);
+            ctxdict = RolloutContextToPy(pes->prc);
             hintdict =
                 Py_BuildValue("{s:i,s:s,s:s,s:f,s:f,s:N,s:N}", "movenum", index + 1, "type", "rollout", "move", szMove,
                               "equity", rEq, "eqdiff", rEqDiff, "context", ctxdict, "details", details);
@@ -846,6 +1000,8 @@ PythonHint_Callback(procrecorddata * pr)
         Py_DECREF(hintdict);
     }
 
+    PyGILState_Release(gstate);
+
     return TRUE;
 }
 
@@ -858,7 +1014,7 @@ PythonHint(PyObject * UNUSED(self), PyObject * args)
     char *szHintType = NULL;
     int nMaxMoves = -1;
 
-    if (!PyArg_ParseTuple(args, "|i", &nMaxMoves))
+    if (!PyArg_ParseTuple(args, "|i", &nMaxMoves) || !PyEngineThreadOK())
         return NULL;
 
     if (nMaxMoves < 0)
@@ -888,7 +1044,12 @@ PythonHint(PyObject * UNUSED(self), PyObject * args)
         prochint.pfProcessRecord = PythonHint_Callback;
         prochint.avInputData[PROCREC_HINT_ARGIN_SHOWPROGRESS] = (void *) (long) 0;
         prochint.avInputData[PROCREC_HINT_ARGIN_MAXMOVES] = (void *) (ptrdiff_t) nMaxMoves;
-        hint_move(szNumber, FALSE, (void *) &prochint);
+        {
+            PyThreadState *ts = PyEngineEnter();
+
+            hint_move(szNumber, FALSE, (void *) &prochint);
+            PyEngineLeave(ts);
+        }
         if (MT_SafeGet(&fInterrupt)) {
             ResetInterrupt();
             PyErr_SetString(PyExc_StandardError, _("interrupted/errno in hint_move"));
@@ -1132,6 +1293,43 @@ PythonClassifyPosition(PyObject * UNUSED(self), PyObject * args)
     return PyInt_FromLong(ClassifyPosition((ConstTanBoard) anBoard, iVariant));
 }
 
+static PyObject *
+PythonEngineStats(PyObject * UNUSED(self), PyObject * UNUSED(args))
+{
+    enginestats es;
+    PyObject *pyDict, *pyEvals, *pyPlies;
+    unsigned int i;
+
+    EngineStatsSum(&es);
+
+    if (!(pyDict = PyDict_New()))
+        return NULL;
+
+    pyEvals = PyTuple_New(N_CLASSES);
+    for (i = 0; i < N_CLASSES; i++)
+        PyTuple_SET_ITEM(pyEvals, i, PyLong_FromUnsignedLongLong(es.acEval[i]));
+    DictSetItemSteal(pyDict, "evals", pyEvals);
+
+    DictSetItemSteal(pyDict, "neuralnets", PyLong_FromUnsignedLongLong(es.cNeuralNet));
+    DictSetItemSteal(pyDict, "prunenets", PyLong_FromUnsignedLongLong(es.cPruneNet));
+    DictSetItemSteal(pyDict, "movegens", PyLong_FromUnsignedLongLong(es.cMoveGen));
+    DictSetItemSteal(pyDict, "movesgenerated", PyLong_FromUnsignedLongLong(es.cMovesGenerated));
+    DictSetItemSteal(pyDict, "maxmoves", PyLong_FromUnsignedLongLong(es.cMaxMoves));
+    DictSetItemSteal(pyDict, "cachelookups", PyLong_FromUnsignedLongLong(es.cCacheLookup));
+    DictSetItemSteal(pyDict, "cachehits", PyLong_FromUnsignedLongLong(es.cCacheHit));
+    DictSetItemSteal(pyDict, "cacheevictions", PyLong_FromUnsignedLongLong(es.cCacheEvict));
+    DictSetItemSteal(pyDict, "bearoffreads", PyLong_FromUnsignedLongLong(es.cBearoffRead));
+    DictSetItemSteal(pyDict, "bearoffdiskreads", PyLong_FromUnsignedLongLong(es.cBearoffDisk));
+
+    pyPlies = PyTuple_New(ENGINESTATS_PLIES);
+    for (i = 0; i < ENGINESTATS_PLIES; i++)
+        PyTuple_SET_ITEM(pyPlies, i, Py_BuildValue("(Kd)", (unsigned long long) es.acPly[i],
+                                                   (double) es.anPlyTime[i] / G_TIME_SPAN_SECOND));
+    DictSetItemSteal(pyDict, "plies", pyPlies);
+
+    return pyDict;
+}
+
 static PyObject *
 PythonErrorRating(PyObject * UNUSED(self), PyObject * args)
 {
@@ -1223,12 +1421,14 @@ PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
     PyObject *pyCubeInfo = NULL;
     PyObject *pyEvalContext = NULL;
 
-    int fSaveShowProg;
     decisionData dd;
     TanBoard anBoard;
     cubeinfo ci;
     evalcontext ec;
 
+    if (!PyEngineThreadOK())
+        return NULL;
+
     memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
     memcpy(anBoard, msBoard(), sizeof(TanBoard));
     GetMatchStateCubeInfo(&ci, &ms);
@@ -1249,15 +1449,11 @@ PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
     dd.pci = &ci;
     dd.pec = &ec;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncMoveDecisionE, &dd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
+    if ((PyEngineRun((AsyncFun) asyncMoveDecisionE, &dd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
         ResetInterrupt();
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncMoveDecisionE"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     {
         PyObject *p = PyTuple_New(6);
@@ -1277,7 +1473,6 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     PyObject *pyCubeInfo = NULL;
     PyObject *pyEvalContext = NULL;
 
-    int fSaveShowProg;
     decisionData dd;
     TanBoard anBoard;
     float arCube[NUM_CUBEFUL_OUTPUTS];
@@ -1285,6 +1480,9 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     evalcontext ec;
     cubedecision cp;
 
+    if (!PyEngineThreadOK())
+        return NULL;
+
     memcpy(&ec, &GetEvalCube()->ec, sizeof(evalcontext));
     memcpy(anBoard, msBoard(), sizeof(TanBoard));
     GetMatchStateCubeInfo(&ci, &ms);
@@ -1306,15 +1504,11 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     dd.pec = &ec;
     dd.pes = NULL;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncCubeDecisionE, &dd, _("Considering cube decision...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
+    if ((PyEngineRun((AsyncFun) asyncCubeDecisionE, &dd, _("Considering cube decision...")) != 0) || MT_SafeGet(&fInterrupt)) {
         ResetInterrupt();
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncCubeDecisionE"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     cp = FindCubeDecision(arCube, dd.aarOutput, &ci);
 
@@ -1346,7 +1540,9 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     evalcontext ec;
     movelist ml;
     findData fd;
-    int fSaveShowProg;
+
+    if (!PyEngineThreadOK())
+        return NULL;
 
     memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
     memcpy(anBoard, msBoard(), sizeof(TanBoard));
@@ -1384,15 +1580,11 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     fd.pci = &ci;
     fd.pec = &ec;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncFindBestMoves, &fd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
-        fShowProgress = fSaveShowProg;
+    if ((PyEngineRun((AsyncFun) asyncFindBestMoves, &fd, _("Considering move...")) != 0) || MT_SafeGet(&fInterrupt)) {
         ResetInterrupt();
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncFindBestMoves"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     {
         PyObject *p;
@@ -1418,6 +1610,245 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     }
 }
 
+/*
+ * Convert a sequence of boards, or a C contiguous buffer of n x 2 x 25
+ * integers (e.g. a numpy array), to a newly allocated array of boards.
+ * Returns NULL with an exception set on error.
+ */
+
+static TanBoard *
+PyToBoards(PyObject * p, Py_ssize_t * pn)
+{
+    TanBoard *aBoards;
+    Py_ssize_t i, n;
+
+    if (PyObject_CheckBuffer(p)) {
+        Py_buffer view;
+        const char *pchFormat;
+        const unsigned char *pb;
+        int fSigned;
+
+        if (PyObject_GetBuffer(p, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+            return NULL;
+
+        pchFormat = view.format ? view.format : "B";
+        if (*pchFormat == '@' || *pchFormat == '=')
+            pchFormat++;
+
+        if (strlen(pchFormat) != 1 || !strchr("bBhHiIlLqQ", *pchFormat)
+            || (view.itemsize != 1 && view.itemsize != 2 && view.itemsize != 4 && view.itemsize != 8)
+            || (view.len / view.itemsize) % (2 * 25)) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, _("boards must be a buffer of n x 2 x 25 integers"));
+            return NULL;
+        }
+
+        fSigned = g_ascii_islower(*pchFormat);
+        n = view.len / view.itemsize / (2 * 25);
+        aBoards = g_new(TanBoard, MAX(n, 1));
+        pb = (const unsigned char *) view.buf;
+
+        for (i = 0; i < n * 2 * 25; i++, pb += view.itemsize) {
+            gint64 v;
+
+            switch (view.itemsize) {
+            case 1:
+                v = fSigned ? *(const gint8 *) pb : *(const guint8 *) pb;
+                break;
+            case 2:
+                v = fSigned ? *(const gint16 *) pb : *(const guint16 *) pb;
+                break;
+            case 4:
+                v = fSigned ? *(const gint32 *) pb : *(const guint32 *) pb;
+                break;
+            default:
+                v = *(const gint64 *) pb;
+                break;
+            }
+
+            if (v < 0 || v > 15) {
+                PyBuffer_Release(&view);
+                g_free(aBoards);
+                PyErr_SetString(PyExc_ValueError, _("invalid number of chequers in board"));
+                return NULL;
+            }
+
+            aBoards[i / 50][(i / 25) % 2][i % 25] = (unsigned int) v;
+        }
+
+        PyBuffer_Release(&view);
+    } else {
+        PyObject *pySeq = PySequence_Fast(p, _("boards must be a sequence or a buffer"));
+
+        if (!pySeq)
+            return NULL;
+
+        n = PySequence_Fast_GET_SIZE(pySeq);
+        aBoards = g_new(TanBoard, MAX(n, 1));
+
+        for (i = 0; i < n; i++)
+            if (!PyToBoard(PySequence_Fast_GET_ITEM(pySeq, i), aBoards[i])) {
+                Py_DECREF(pySeq);
+                g_free(aBoards);
+                PyErr_Format(PyExc_ValueError, _("invalid board at index %d"), (int) i);
+                return NULL;
+            }
+
+        Py_DECREF(pySeq);
+    }
+
+    *pn = n;
+    return aBoards;
+}
+
+typedef struct {
+    const TanBoard *aBoards;
+    float *ar;                  /* n x cOutputs results */
+    int n;
+    int cOutputs;
+    int iNext;                  /* next board to evaluate */
+    int fCubeful;
+    cubeinfo *pci;
+    const evalcontext *pec;
+} batchData;
+
+/* each worker takes boards from the batch until it is exhausted */
+static void
+asyncEvaluateBatch(batchData * pbd)
+{
+    int i;
+
+    while ((i = MT_SafeIncValue(&pbd->iNext) - 1) < pbd->n) {
+        float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+        float *ar = pbd->ar + (size_t) i *pbd->cOutputs;
+
+        if (MT_SafeGet(&fInterrupt))
+            return;
+
+        if (pbd->fCubeful) {
+            if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) pbd->aBoards[i], pbd->pci, pbd->pec, NULL) < 0) {
+                MT_SetResultFailed();
+                return;
+            }
+            FindCubeDecision(ar, aarOutput, pbd->pci);
+        } else {
+            if (GeneralEvaluationE(aarOutput[0], (ConstTanBoard) pbd->aBoards[i], pbd->pci, pbd->pec) < 0) {
+                MT_SetResultFailed();
+                return;
+            }
+            memcpy(ar, aarOutput[0], pbd->cOutputs * sizeof(float));
+        }
+    }
+}
+
+static gboolean
+BatchProgress(gpointer UNUSED(unused))
+{
+    return TRUE;
+}
+
+static PyObject *
+PythonEvaluateBatch(PyObject * args, int fCubeful)
+{
+    PyObject *pyBoards = NULL;
+    PyObject *pyCubeInfo = NULL;
+    PyObject *pyEvalContext = NULL;
+    PyObject *pyResult;
+    PyThreadState *ts;
+    TanBoard *aBoards;
+    Py_ssize_t n;
+    cubeinfo ci;
+    evalcontext ec;
+    batchData bd;
+    int ret;
+
+    if (!PyEngineThreadOK())
+        return NULL;
+
+    memcpy(&ec, fCubeful ? &GetEvalCube()->ec : &GetEvalChequer()->ec, sizeof(evalcontext));
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    if (!PyArg_ParseTuple(args, "O|OO", &pyBoards, &pyCubeInfo, &pyEvalContext))
+        return NULL;
+
+    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
+        return NULL;
+
+    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+        return NULL;
+
+    if (!(aBoards = PyToBoards(pyBoards, &n)))
+        return NULL;
+
+    bd.aBoards = (const TanBoard *) aBoards;
+    bd.n = (int) n;
+    bd.cOutputs = fCubeful ? NUM_CUBEFUL_OUTPUTS : NUM_OUTPUTS + 1;
+    bd.iNext = 0;
+    bd.fCubeful = fCubeful;
+    bd.pci = &ci;
+    bd.pec = &ec;
+
+    /* evaluate straight into the memory of the result */
+#if (PY_MAJOR_VERSION >= 3)
+    if (!(pyResult = PyBytes_FromStringAndSize(NULL, (Py_ssize_t) (n * bd.cOutputs * sizeof(float))))) {
+        g_free(aBoards);
+        return NULL;
+    }
+    bd.ar = (float *) PyBytes_AS_STRING(pyResult);
+#else
+    if (!(pyResult = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) (n * bd.cOutputs * sizeof(float))))) {
+        g_free(aBoards);
+        return NULL;
+    }
+    bd.ar = (float *) PyByteArray_AS_STRING(pyResult);
+#endif
+
+    if (n > 0) {
+        ts = PyEngineEnter();
+        mt_add_tasks(MIN(MT_GetNumThreads(), (unsigned int) n), (AsyncFun) asyncEvaluateBatch, &bd, NULL);
+        ret = MT_WaitForTasks(BatchProgress, 10, FALSE);
+        PyEngineLeave(ts);
+
+        if (ret < 0 || MT_SafeGet(&fInterrupt)) {
+            g_free(aBoards);
+            Py_DECREF(pyResult);
+            ResetInterrupt();
+            PyErr_SetString(PyExc_StandardError, _("interrupted/errno in batch evaluation"));
+            return NULL;
+        }
+    }
+
+    g_free(aBoards);
+
+#if (PY_MAJOR_VERSION >= 3)
+    {
+        /* a float32 view of shape (n, outputs), usable by numpy without copying */
+        PyObject *pyView = PyMemoryView_FromObject(pyResult);
+
+        Py_DECREF(pyResult);
+        if (!pyView)
+            return NULL;
+
+        pyResult = PyObject_CallMethod(pyView, "cast", "s(ni)", "f", n, bd.cOutputs);
+        Py_DECREF(pyView);
+    }
+#endif
+
+    return pyResult;
+}
+
+SIMD_STACKALIGN static PyObject *
+PythonEvaluateBatchCubeless(PyObject * UNUSED(self), PyObject * args)
+{
+    return PythonEvaluateBatch(args, FALSE);
+}
+
+SIMD_STACKALIGN static PyObject *
+PythonEvaluateBatchCubeful(PyObject * UNUSED(self), PyObject * args)
+{
+    return PythonEvaluateBatch(args, TRUE);
+}
+
 static PyObject *
 METRow(float ar[MAXSCORE], const int n)
 {
@@ -2261,7 +2692,7 @@ PyMoveAnalysis(const movelist * pml, PyMatchState * ms)
             case EVAL_ROLLOUT:
                 {
                     PyObject *m = PyMove(pmi->anMove);
-                    const evalsetup *pes = &pmi->esMove;
+                    const moveevalsetup *pes = &pmi->esMove;
                     const float *p = pmi->arEvalMove;
                     const float *s = pmi->arEvalStdDev;
 
@@ -2269,7 +2700,7 @@ PyMoveAnalysis(const movelist * pml, PyMatchState * ms)
                                       ",s:(fffff),s:f,s:f}",
                                       "type", "rollout",
                                       "move", m,
-                                      "trials", pes->rc.nGamesDone,
+                                      "trials", pes->nGamesDone,
                                       "probs", p[0], p[1], p[2], p[3], p[4],
                                       "match-eq", p[OUTPUT_EQUITY],
                                       "cubeful-eq", p[OUTPUT_CUBEFUL_EQUITY],
@@ -2278,7 +2709,7 @@ PyMoveAnalysis(const movelist * pml, PyMatchState * ms)
                     Py_DECREF(m);
 
                     {
-                        PyObject *c = diffRolloutContext(&pes->rc, ms);
+                        PyObject *c = diffRolloutContext(pes->prc, ms);
                         if (c) {
                             DictSetItemSteal(v, "rollout-context", c);
                         }
@@ -3159,9 +3590,36 @@ PythonNavigate(PyObject * UNUSED(self), PyObject * args, PyObject * keywds)
 }
 
 
+/* the entry points that do not call the engine but use its globals */
+
+PY_SERIALISED(PythonBoard)
+PY_SERIALISED(PythonCommand)
+PY_SERIALISED(PythonShow)
+PY_SERIALISED(PythonSetGNUbgID)
+PY_SERIALISED(PythonClassifyPosition)
+PY_SERIALISED(PythonDiceRolls)
+PY_SERIALISED(PythonEngineStats)
+PY_SERIALISED(PythonEq2mwc)
+PY_SERIALISED(PythonEq2mwcStdErr)
+PY_SERIALISED(PythonMwc2eq)
+PY_SERIALISED(PythonMwc2eqStdErr)
+PY_SERIALISED(PythonMatchChecksum)
+PY_SERIALISED(PythonCubeInfo)
+PY_SERIALISED(PythonPosInfo)
+PY_SERIALISED(PythonMET)
+PY_SERIALISED(PythonMatchID)
+PY_SERIALISED(PythonGetEvalHintFilter)
+PY_SERIALISED(PythonSetEvalHintFilter)
+PY_SERIALISED(PythonGnubgID)
+PY_SERIALISED(PythonNextTurn)
+PY_SERIALISED(PythonEvalContext)
+PY_SERIALISED(PythonRolloutContext)
+PY_SERIALISED_KEYWORDS(PythonMatch)
+PY_SERIALISED_KEYWORDS(PythonNavigate)
+
 static PyMethodDef gnubgMethods[] = {
 
-    {"board", PythonBoard, METH_VARARGS,
+    {"board", PythonBoardSerialised, METH_VARARGS,
      "Get the current board\n"
      "    arguments: none\n"
      "    returns: tuple of two lists of 25 ints:\n" "        pieces on points 1..24 and the bar"}
@@ -3171,13 +3629,13 @@ static PyMethodDef gnubgMethods[] = {
      "    arguments: [cube-info dictionary]\n"
      "        cube-info: see 'cfevaluate'\n" "    returns: cube-info dictionary"}
     ,
-    {"command", PythonCommand, METH_VARARGS,
+    {"command", PythonCommandSerialised, METH_VARARGS,
      "Execute a command\n" "    arguments: string containing command\n" "    returns: None"}
     ,
-    {"show", PythonShow, METH_VARARGS,
+    {"show", PythonShowSerialised, METH_VARARGS,
      "Execute the 'show arguments' command\n" "    arguments: string containing arguments\n" "    returns: result, with final newline(s) stripped, as string"}
     ,
-    {"setgnubgid", PythonSetGNUbgID, METH_VARARGS,
+    {"setgnubgid", PythonSetGNUbgIDSerialised, METH_VARARGS,
      "Set current board and matchid\n" "    arguments: string containing a GNUbgID or XGID\n" "    returns: None"}
     ,
     {"cfevaluate", PythonEvaluateCubeful, METH_VARARGS,
@@ -3192,14 +3650,35 @@ static PyMethodDef gnubgMethods[] = {
      "           'deterministic'=> 0/1, 'noise'->float\n"
      "    returns: evaluation = tuple (floats optimal, nodouble, take, drop, int recommendation, String recommendationtext)"}
     ,
-    {"classifypos", (PyCFunction) PythonClassifyPosition, METH_VARARGS,
+    {"classifypos", (PyCFunction) PythonClassifyPositionSerialised, METH_VARARGS,
      "classify a position for a given backammon variant and board\n"
      "    arguments: [board], [int variant]\n" "    returns: int posclass"}
     ,
-    {"dicerolls", PythonDiceRolls, METH_VARARGS,
+    {"dicerolls", PythonDiceRollsSerialised, METH_VARARGS,
      "return a list of dice rolls from current RNG\n"
      "   arguments: number of rolls\n" "    returns: list of tuples (2 elements each, one for each die)\n"}
     ,
+    {"enginestats", PythonEngineStatsSerialised, METH_NOARGS,
+     "return the evaluation engine statistics summed over all threads\n"
+     "    arguments: none\n"
+     "    returns: dictionary with counters; 'evals' is indexed by posclass,\n"
+     "         'plies' holds a tuple (move lists scored, seconds) per ply"}
+    ,
+    {"evaluate_batch", PythonEvaluateBatchCubeless, METH_VARARGS,
+     "Cubeless evaluation of many positions on the calculation threads\n"
+     "    arguments: boards [cube-info] [eval context]\n"
+     "         boards is a sequence of boards or a buffer (e.g. numpy array)\n"
+     "         of n x 2 x 25 integers\n"
+     "    returns float32 memoryview of shape (n, 6) holding the values\n"
+     "         returned by 'evaluate' for each board"}
+    ,
+    {"cfevaluate_batch", PythonEvaluateBatchCubeful, METH_VARARGS,
+     "Cubeful evaluation of many positions on the calculation threads\n"
+     "    arguments: boards [cube-info] [eval context]\n"
+     "         see 'evaluate_batch'\n"
+     "    returns float32 memoryview of shape (n, 4) holding the cubeful\n"
+     "         equities returned by 'cfevaluate' for each board"}
+    ,
     {"evaluate", PythonEvaluate, METH_VARARGS,
      "Cubeless evaluation\n"
      "    arguments: [board] [cube-info] [eval context]\n"
@@ -3207,19 +3686,19 @@ static PyMethodDef gnubgMethods[] = {
      "    returns tuple(floats P(win), P(win gammon), P(win backgammnon)\n"
      "         P(lose gammon), P(lose backgammon), cubeless equity)"}
     ,
-    {"evalcontext", PythonEvalContext, METH_VARARGS,
+    {"evalcontext", PythonEvalContextSerialised, METH_VARARGS,
      "make an evalcontext\n"
      "    argument: [tuple ( 5 int, float )]\n" "    returns:  eval-context ( see 'cfevaluate' )"}
     ,
-    {"rolloutcontext", PythonRolloutContext, METH_VARARGS,
+    {"rolloutcontext", PythonRolloutContextSerialised, METH_VARARGS,
      "make a rolloutcontext\n" "    argument: [tuple ( 16 int, 2 float )]\n" "    returns:  rollout-context"}
     ,
-    {"eq2mwc", PythonEq2mwc, METH_VARARGS,
+    {"eq2mwc", PythonEq2mwcSerialised, METH_VARARGS,
      "convert equity to MWC\n"
      "    argument: [float equity], [cube-info]\n"
      "         defaults equity = 0.0, cube-info see 'cfevaluate'\n" "    return float mwc"}
     ,
-    {"eq2mwc_stderr", PythonEq2mwcStdErr, METH_VARARGS,
+    {"eq2mwc_stderr", PythonEq2mwcStdErrSerialised, METH_VARARGS,
      "convert equity standard error to MWC\n"
      "    argument: [float equity], [cube-info]\n"
      "         defaults equity = 0.0, cube-info see 'cfevaluate'\n" "    return float mwc"}
@@ -3233,26 +3712,26 @@ static PyMethodDef gnubgMethods[] = {
     {"hint", PythonHint, METH_VARARGS,
      "    arguments: [max moves]\n" "    returns: hint dictionary\n"}
     ,
-    {"mwc2eq", PythonMwc2eq, METH_VARARGS,
+    {"mwc2eq", PythonMwc2eqSerialised, METH_VARARGS,
      "convert MWC to equity\n"
      "    argument: [float match-winning-chance], [cube-info]\n"
      "         defaults mwc = 0.0, cube-info see 'cfevaluate'\n" "    returns: float equity"}
     ,
-    {"mwc2eq_stderr", PythonMwc2eqStdErr, METH_VARARGS,
+    {"mwc2eq_stderr", PythonMwc2eqStdErrSerialised, METH_VARARGS,
      "convert standard error MWC to equity\n"
      "    argument: [float match-winning-chance], [cube-info]\n"
      "         defaults mwc = 0.0, cube-info see 'cfevaluate'\n" "    returns: float equity"}
     ,
-    {"matchchecksum", PythonMatchChecksum, METH_VARARGS,
+    {"matchchecksum", PythonMatchChecksumSerialised, METH_VARARGS,
      "Calculate checksum for current match\n" "    arguments: none\n" "    returns: MD5 digest as 32 char hex string"}
     ,
-    {"cubeinfo", PythonCubeInfo, METH_VARARGS,
+    {"cubeinfo", PythonCubeInfoSerialised, METH_VARARGS,
      "Make a cubeinfo\n"
      "    arguments: [cube value, cube owner = 0/1, player on move = 0/1, \n"
      "        match length (0 = money), score (tuple int, int), \n"
      "        is crawford = 0/1, bg variant = 0/5]\n" "    returns pos-info dictionary ( see 'cfevaluate' )"}
     ,
-    {"posinfo", PythonPosInfo, METH_VARARGS,
+    {"posinfo", PythonPosInfoSerialised, METH_VARARGS,
      "Make a posinfo dictionary\n"
      "    arguments: [player on roll = 0/1, player resigned = 0/1, \n"
      "        player doubled = 0/1, gamestate = 0..7, dice = tuple(0..6, 0..6)] \n"
@@ -3260,7 +3739,7 @@ static PyMethodDef gnubgMethods[] = {
      "       pos-info = dictionary: 'dice'=>tuple (int,int), 'turn'=>0/1\n"
      "           'resigned'=>0/1, 'doubled'=>0/1, 'gamestate'=>int (0..7)\n"}
     ,
-    {"met", PythonMET, METH_VARARGS,
+    {"met", PythonMETSerialised, METH_VARARGS,
      "return the current match equity table\n"
      "   arguments: [max score]\n"
      "    returns: list of list n of list n (rows of pre-crawford table\n"
@@ -3270,18 +3749,18 @@ static PyMethodDef gnubgMethods[] = {
      "return position ID from board\n"
      "    arguments: [board] ( see 'cfevaluate' )\n" "    returns: position ID as string"}
     ,
-    {"matchid", PythonMatchID, METH_VARARGS,
+    {"matchid", PythonMatchIDSerialised, METH_VARARGS,
      "return MatchID from current position, or from cube-info, pos-info\n"
      "    arguments: [cube-info dictionary], [pos-info dictionary] \n"
      "        cube-info: see 'cfevaluate'\n" "        pos-info: see 'posinfo'\n" "    returns: Match ID as string"}
     ,
-    {"getevalhintfilter", PythonGetEvalHintFilter, METH_VARARGS,
+    {"getevalhintfilter", PythonGetEvalHintFilterSerialised, METH_VARARGS,
      "return hint/eval move filters \n" "    arguments: none\n" "    returns: list of movefilters"}
     ,
-    {"setevalhintfilter", PythonSetEvalHintFilter, METH_VARARGS,
+    {"setevalhintfilter", PythonSetEvalHintFilterSerialised, METH_VARARGS,
      "return none \n" "    arguments: a list of movefilters\n" "    returns: none"}
     ,
-    {"gnubgid", PythonGnubgID, METH_VARARGS,
+    {"gnubgid", PythonGnubgIDSerialised, METH_VARARGS,
      "return GNUBGID from current position, or from board, cube-info, pos-info\n"
      "    arguments: [board, cube-info dictionary, pos-info dictionary]\n"
      "        board, cube-info: see 'cfevaluate'\n"
@@ -3313,7 +3792,7 @@ static PyMethodDef gnubgMethods[] = {
     {"positionfromkey", PythonPositionFromKey, METH_VARARGS,
      "return position from key\n" "    arguments: [ list of 10 ints] \n" "    returns: board ( see 'cfevaluate' )"}
     ,
-    {"match", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonMatch, METH_VARARGS | METH_KEYWORDS,
+    {"match", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonMatchSerialised, METH_VARARGS | METH_KEYWORDS,
      "Get the current match\n"
      "    arguments: [ include-analysis = 0/1, include-boards = 0/1,\n"
      "       include-statistics = 0/1, verbose = 0/1 ]\n"
@@ -3383,14 +3862,14 @@ static PyMethodDef gnubgMethods[] = {
      "          'result' =>0/1\n"
      "          'rules' = 'Crawford'/whatever\n" "          'variation' => 'Standard' or whatever\n"}
     ,
-    {"navigate", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonNavigate, METH_VARARGS | METH_KEYWORDS,
+    {"navigate", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonNavigateSerialised, METH_VARARGS | METH_KEYWORDS,
      "go to a position in a match or session'n"
      "    arguments: no args = go to start of match/session\n"
      "         [ game=offset] go forward/backward n games\n"
      "         [record=offset] go gorward/backward n moves'n"
      "    returns: None if no change, tuple( games moved, records moved)"}
     ,
-    {"nextturn", (PyCFunction) PythonNextTurn, METH_VARARGS,
+    {"nextturn", (PyCFunction) PythonNextTurnSerialised, METH_VARARGS,
      "play one turn\n" "    arguments: none\n" "    returns: None"}
     ,
     {"luckrating", (PyCFunction) PythonLuckRating, METH_VARARGS,
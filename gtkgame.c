@@ -593,6 +593,7 @@ typedef struct {
     GtkWidget *apwAnalysePlayers[2];
     GtkWidget *pwAutoDB;
     GtkWidget *pwBackgroundAnalysis;
+    GtkWidget *pwIncremental;
     GtkWidget *apwAnalyzeFileSetting[NUM_AnalyzeFileSettings];
 
     GtkWidget *pwScoreMap;
@@ -2778,6 +2779,7 @@ AnalysisOK(GtkWidget * pw, analysiswidget * paw)
     CHECKUPDATE(paw->apwAnalysePlayers[1], afAnalysePlayers[1], "set analysis player 1 analyse %s")
     CHECKUPDATE(paw->pwAutoDB, fAutoDB, "set automatic db %s")
     CHECKUPDATE(paw->pwBackgroundAnalysis, fBackgroundAnalysis, "set analysis background %s")
+    CHECKUPDATE(paw->pwIncremental, fAnalyseIncremental, "set analysis incremental %s")
 
     ADJUSTSKILLUPDATE(0, SKILL_DOUBTFUL, "set analysis threshold doubtful %s")
     ADJUSTSKILLUPDATE(1, SKILL_BAD, "set analysis threshold bad %s")
@@ -2895,6 +2897,7 @@ AnalysisSet(analysiswidget * paw)
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(paw->pwLuck), fAnalyseDice);
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(paw->pwAutoDB), fAutoDB);
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(paw->pwBackgroundAnalysis), fBackgroundAnalysis);
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(paw->pwIncremental), fAnalyseIncremental);
 
     for (i = 0; i < 2; ++i)
         gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(paw->apwAnalysePlayers[i]), afAnalysePlayers[i]);
@@ -3378,6 +3381,14 @@ append_analysis_options(analysiswidget * paw)
                                 "analysis is still running in the background. Some features may be "
                                 "disabled until the analysis is over."));
 
+    paw->pwIncremental = gtk_check_button_new_with_label(_("Keep the stored luck when reanalysing"));
+    gtk_box_pack_start(GTK_BOX(vbox3), paw->pwIncremental, FALSE, FALSE, 0);
+    gtk_widget_set_tooltip_text(paw->pwIncremental,
+                                _("Moves and cube decisions already analysed with the same or stronger "
+                                  "settings are never analysed again. This also keeps the luck of dice "
+                                  "rolls found by an earlier analysis, which makes reanalysing a match "
+                                  "much faster; turn it off after changing the luck analysis settings."));
+
     BuildRadioButtons(vbox3, paw->apwAnalyzeFileSetting,
         _("Select the default file analysis settings (hover for details):"), 
         _("- Batch analysis can analyze several files, but does not allow browsing the results at the same time\n "
@@ -7453,62 +7464,6 @@ GTKHelp(char *sz)
     gtk_tree_path_free(ptpExpand);
 }
 
-static void
-GTKBearoffProgressCancel(void)
-{
-    raise(SIGINT);
-    exit(EXIT_FAILURE);
-}
-
-/* Show a dialog box with a progress bar to be used during initialisation
- * if a heuristic bearoff database must be created.  Most of GNUbg hasn't
- * been initialised yet, so this function is restricted in many ways. */
-extern void
-GTKBearoffProgress(int i)
-{
-
-    static GtkWidget *pwDialog, *pw;
-    gchar *gsz;
-
-    if (!pwDialog) {
-#if !GTK_CHECK_VERSION(3,0,0)
-        static GtkWidget *pwAlign;
-#endif
-
-        pwDialog =
-            GTKCreateDialog(_("GNU Backgammon"), DT_INFO, NULL, DIALOG_FLAG_MODAL | DIALOG_FLAG_NOTIDY, NULL, NULL);
-        gtk_window_set_role(GTK_WINDOW(pwDialog), "progress");
-        gtk_window_set_type_hint(GTK_WINDOW(pwDialog), GDK_WINDOW_TYPE_HINT_DIALOG);
-        g_signal_connect(G_OBJECT(pwDialog), "destroy", G_CALLBACK(GTKBearoffProgressCancel), NULL);
-
-#if GTK_CHECK_VERSION(3,0,0)
-        gtk_box_pack_start(GTK_BOX(DialogArea(pwDialog, DA_MAIN)),
-		           pw = gtk_progress_bar_new(), TRUE, TRUE, 8);
-        gtk_widget_set_halign(pw, GTK_ALIGN_FILL);
-        gtk_widget_set_valign(pw, GTK_ALIGN_CENTER);
-#else
-        gtk_box_pack_start(GTK_BOX(DialogArea(pwDialog, DA_MAIN)),
-                           pwAlign = gtk_alignment_new(0.5, 0.5, 1, 0), TRUE, TRUE, 8);
-        gtk_container_add(GTK_CONTAINER(pwAlign), pw = gtk_progress_bar_new());
-#endif
-
-        gtk_widget_show_all(pwDialog);
-    }
-
-    gsz = g_strdup_printf(_("Generating bearoff database (%.0f %%)"), i / 542.64);
-    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(pw), gsz);
-    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(pw), i / 54264.0);
-    g_free(gsz);
-
-    if (i >= 54000) {
-        g_signal_handlers_disconnect_by_func(G_OBJECT(pwDialog), (gpointer) G_CALLBACK(GTKBearoffProgressCancel), NULL);
-
-        gtk_widget_destroy(pwDialog);
-    }
-
-    ProcessEvents();
-}
-
 static void enable_sub_menu(GtkWidget * pw, int f);     /* for recursion */
 
 static void
@@ -89,7 +89,6 @@ extern void GL_SetNames(void);
 extern void GTKAddGame(moverecord * pmr);
 extern void GTKAddMoveRecord(moverecord * pmr);
 extern void GTKAllowStdin(void);
-extern void GTKBearoffProgress(int i);
 extern void GTKCalibrationEnd(void *context);
 extern void *GTKCalibrationStart(void);
 extern void GTKCalibrationUpdate(void *context, float rEvalsPerSec);
@@ -556,7 +556,7 @@ append_game_options(optionswidget * pow)
     /* disable entries if hypergammon databases are not available */
 
     for (i = 0; i < 3; ++i)
-        gtk_widget_set_sensitive(GTK_WIDGET(pow->apwVariations[i + VARIATION_HYPERGAMMON_1]), apbcHyper[i] != NULL);
+        gtk_widget_set_sensitive(GTK_WIDGET(pow->apwVariations[i + VARIATION_HYPERGAMMON_1]), HyperDatabaseInstalled(i));
 }
 
 static void
@@ -1897,6 +1897,7 @@ OptionsOK(GtkWidget * pw, optionswidget * pow)
             "set rng isaac",
             "set rng md5",
             "set rng mersenne",
+            "set rng philox",
             "set rng manual",
             "set rng random.org",
             NULL,
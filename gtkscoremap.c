@@ -31,6 +31,8 @@
                     the equity of each decision and therefore the best decision as well,
                     and uses it to set the text for the corresponding quadrant (the best decision is stored in
                     psm->aaQuadrantData[i][j].decisionString). This text is displayed in step 5 below.
+                    The quadrants are calculated in parallel on the calculation threads (see CalcQuadrants()),
+                    and while they run, the quadrants that are done are already displayed as in steps 4-5.
                     In the move scoremap, FindMostFrequentMoves() finds the top-k most frequent distinct best moves
                     and assigns them distinct colors, as well as English descriptions (in the "alpha version" where
                     English description is allowed).
@@ -130,6 +132,7 @@ and come back, it works again. It may be a movelist construction issue.
 #include "drawboard.h"
 #include "format.h"
 #include "gtkwindows.h"
+#include "multithread.h"
 //#include "gtkoptions.h"  
 
 
@@ -270,6 +273,8 @@ typedef struct {
 
     // 3. specific to move scoremap:
     movelist ml; //scores ordered list of best moves  TODO (still relevant?): (1) replace with int anMove[8] (2) record index of this move in topKDecisions[]
+
+    int fPending; // set while a calculation thread owns this quadrant; read and cleared with g_atomic_int_*
 } quadrantdata;
 
 typedef struct {
@@ -290,6 +295,7 @@ typedef struct {
     // 1. shared b/w cube and move scoremaps:
     int cubeScoreMap; // whether we want a ScoreMap for cube or move (=1 for cube, =0 for move)
     const matchstate *pms; // state of the *true* match 
+    matchstate msTrue; // our copy of it, which the calculation threads can read while ms changes
     matchstate msTemp; // temp match state at some score (i,j)
     evalcontext ec; // The eval context (takes into account the selected ply)
     int tableSize; // This actually represents the max away score minus 1 (since we never show score=1)
@@ -342,6 +348,7 @@ typedef struct {
 // *******************************************************************
 
 static GtkWidget *pwDialog = NULL;
+static scoremap *psmCalc = NULL; // the scoremap whose quadrants are being calculated, if any
 
 //define desired number of output digits, i.e. precision, throughout the file (in equity text, hover text, etc)
 #define DIGITS MAX(MIN(fOutputDigits, MAX_OUTPUT_DIGITS),0)
@@ -511,6 +518,25 @@ In Move ScoreMap: Calculates the ordered best moves and their equities.
     }
 }
 
+typedef struct {
+/* A quadrant to calculate on one of the calculation threads */
+    Task task;
+    quadrantdata *pq;
+    const scoremap *psm;
+    int *pfCancel; // shared by the tasks of one CalcQuadrants() call
+} ScoreMapTask;
+
+static void
+CalcQuadrantMT(ScoreMapTask * pt)
+{
+    /* once the user stopped the calculation, the remaining quadrants of this map are skipped
+    (and left empty, as preset by CalcQuadrants()) */
+    if (!g_atomic_int_get(pt->pfCancel) && CalcQuadrantEquities(pt->pq, pt->psm, TRUE) < 0)
+        g_atomic_int_set(pt->pfCancel, TRUE);
+
+    g_atomic_int_set(&pt->pq->fPending, FALSE);
+}
+
 static int
 CompareDecisionFrequencies (const void *a, const void *b)
 {
@@ -551,13 +577,14 @@ FindMostFrequentMoves(scoremap *psm) {
     psm->topKDecisionsLength=0;
     // for all moves, add them to the list of frequent moves, i.e. either create a new frequent move or update the count of
     // the corresponding frequent move (this is implemented in AddFrequentMoveList())
+    // (quadrants still being calculated are skipped; there may be none left, e.g. at the start of a calculation)
     for (i=0; i<psm->tableSize; i++)
         for (j=0; j<psm->tableSize; j++)
-            if (psm->aaQuadrantData[i][j].isAllowedScore == ALLOWED)
+            if (psm->aaQuadrantData[i][j].isAllowedScore == ALLOWED && !g_atomic_int_get(&psm->aaQuadrantData[i][j].fPending))
                 AddFrequentMoveList(scoreMapDecisions,&psm->topKDecisionsLength,psm->aaQuadrantData[i][j].decisionString, psm->aaQuadrantData[i][j].ml.amMoves[0].anMove);
-    AddFrequentMoveList(scoreMapDecisions,&psm->topKDecisionsLength,psm->moneyQuadrantData.decisionString, psm->moneyQuadrantData.ml.amMoves[0].anMove);
+    if (!g_atomic_int_get(&psm->moneyQuadrantData.fPending))
+        AddFrequentMoveList(scoreMapDecisions,&psm->topKDecisionsLength,psm->moneyQuadrantData.decisionString, psm->moneyQuadrantData.ml.amMoves[0].anMove);
 
-    g_assert(psm->topKDecisionsLength > 0);
     if (psm->topKDecisionsLength <= 0)
         return;
 
@@ -1130,7 +1157,9 @@ Specifically: (1) The color of each square (2) The hover text of each square (3)
     int i, j, i2, j2;
 
     //start by the top-left money square 
-    ColourQuadrant(& psm->moneygQuadrant, & psm->moneyQuadrantData, psm);
+    // (here and below, quadrants that are still being calculated keep their previous look)
+    if (!g_atomic_int_get(&psm->moneyQuadrantData.fPending))
+        ColourQuadrant(& psm->moneygQuadrant, & psm->moneyQuadrantData, psm);
 
     // start by updating the score labels for each row/col and the color and hover text
     // i2, j2 = indices in the visual table (i.e., in aagQuadrant)
@@ -1145,6 +1174,7 @@ Specifically: (1) The color of each square (2) The hover text of each square (3)
         for (j2 = 0; j2 < psm->tableSize; ++j2) {
             j = (psm->labelBasedOn == LABEL_AWAY) ? j2 : psm->tableSize-1-j2;
             //if(i<=oldSize && j<=oldSize)
+            if (!g_atomic_int_get(&psm->aaQuadrantData[i][j].fPending))
                 ColourQuadrant(& psm->aagQuadrant[i2][j2], & psm->aaQuadrantData[i][j], psm);
         } // end of: for j2
 
@@ -1565,6 +1595,79 @@ InitQuadrantCubeInfo(scoremap * psm, int i, int j)
 // }
 
 
+static gboolean
+ScoreMapProgress(gpointer UNUSED(unused))
+{
+/* Called periodically while the quadrants are calculated: shows the quadrants that are done so far. */
+    ProgressValue(MT_GetDoneTasks());
+
+    if (psmCalc) {
+        if (!psmCalc->cubeScoreMap)
+            FindMostFrequentMoves(psmCalc);
+        UpdateScoreMapVisual(psmCalc);
+    }
+
+    return TRUE;
+}
+
+static void
+CalcQuadrants(scoremap * psm, quadrantdata * apq[], int c)
+/* Calculates the given quadrants on the calculation threads, in the given order.
+Each quadrant is flagged as pending until its task is done, so that the GUI leaves it alone in the meantime.
+If the user stops the calculation, the quadrants that were not reached are left as if their
+calculation had failed, i.e. with an empty decision.
+The calculation waits for the pool, so it is only started when nothing else (e.g. a background
+analysis) is using it; and the options are made insensitive meanwhile, since changing them would
+recalculate the quadrants the threads are still writing into. So are the dialog buttons (and with them
+the Escape key), since closing the window would free psm under the threads.
+*/
+{
+    int i;
+    int fCancel = FALSE;
+
+    if (!MT_PoolAvailable()) {
+        for (i = 0; i < c; i++)
+            strcpy(apq[i]->decisionString, "");
+        return;
+    }
+
+    for (i = 0; i < c; i++) {
+        quadrantdata *pq = apq[i];
+        ScoreMapTask *pt = (ScoreMapTask *) g_malloc(sizeof(ScoreMapTask));
+
+        strcpy(pq->decisionString, "");
+        if (psm->cubeScoreMap) {
+            pq->ndEquity = -1000;
+            pq->dtEquity = -1000;
+        } else {
+            pq->ml.cMoves = 0;
+            pq->ml.amMoves = NULL;
+        }
+        pq->fPending = TRUE;
+
+        pt->task.fun = (AsyncFun) CalcQuadrantMT;
+        pt->task.data = pt;
+        pt->task.pLinkedTask = NULL;
+        pt->pq = pq;
+        pt->psm = psm;
+        pt->pfCancel = &fCancel;
+        MT_AddTask((Task *) pt, TRUE);
+    }
+
+    ProgressStartValue(_("Finding correct decisions"), MAX(c, 1));
+
+    psmCalc = psm;
+    gtk_widget_set_sensitive(psm->pwOptionsBox, FALSE);
+    gtk_widget_set_sensitive(DialogArea(pwDialog, DA_BUTTONS), FALSE);
+    MT_WaitForTasks(ScoreMapProgress, 250, FALSE);
+    gtk_widget_set_sensitive(DialogArea(pwDialog, DA_BUTTONS), TRUE);
+    gtk_widget_set_sensitive(psm->pwOptionsBox, TRUE);
+    psmCalc = NULL;
+
+    for (i = 0; i < c; i++)
+        g_atomic_int_set(&apq[i]->fPending, FALSE);
+}
+
 static int
 CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
 
@@ -1626,18 +1729,16 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
         // g_message("new money cMoves=%d",psm->moneyQuadrantData.ml.cMoves);
     } else {
         //recompute fully (beyond oldSize); we only recompute the money equity when oldSize==0
-        ProgressStartValue(_("Finding correct decisions"), (oldSize==0)? psm->tableSize*psm->tableSize + 1 : MAX(psm->tableSize*psm->tableSize-oldSize*oldSize, 1) );
-        //g_print("Finding %d-ply cube equities:\n",pec->nPlies);
+        // apq lists the quadrants to calculate, in the order we want them done
+        quadrantdata *apq[MAX_TABLE_SIZE * MAX_TABLE_SIZE + 1];
+        int cQuadrants = 0;
 
         /* We start by computing the money-play value, since if the user stops the process
         in the middle, it's often the most useful to display and therefore to compute first*/
         //if(oldSize == 0 || oldSize == psm->tableSize)  //causes bug: it colors the cell in dark grey, and doesn't show a move
                             //maybe the moneyQuadrantData becomes empty?
         if (oldSize==0) {  //if the money square equity wasn't already computed [we are in the !updateMoneyOnly case]
-            CalcQuadrantEquities(&(psm->moneyQuadrantData), psm, TRUE);
-                    // g_message("new money cMoves=%d",psm->moneyQuadrantData.ml.cMoves);
-            /*careful: upon table scaling, ProgressValueAdd causes a redraw => a potential problem  in the pango markup text because it may not be ready yet!*/
-            ProgressValueAdd(1);//not sure if it should be included above, but probably minor
+            apq[cQuadrants++] = &psm->moneyQuadrantData;
         }
 
         /*
@@ -1659,22 +1760,18 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
         compute both at the same : (1) the cubeinfo and (2) the resulting equity values; so we need 
         to combine the (aux,aux2) indexation values (which are used for expanding squares) with the 
         (i,j) ones. 
+
+        In a fourth version, the cubeinfo values are again initialized first, which is quick, and the
+        quadrants are then calculated in parallel, still in growing squares, by CalcQuadrants().
         */
         if(!calcOnly) {
             psm->msTemp.nMatchTo = MATCH_SIZE(psm); // Set the match length
-            // psm->pmsTemp->nCube = abs(psm->signednCube); // Set the cube value
-            // if (psm->signednCube == 1) // Cube value 1: centre the cube
-            //     psm->pmsTemp->fCubeOwner = -1;
-            // else // Cube value > 1: Uncentre the cube. Ensure that the player on roll owns the cube (and thus can double)
-            //     psm->pmsTemp->fCubeOwner = (psm->signednCube > 0) ? (psm->pmsTemp->fMove) : (1 - psm->pmsTemp->fMove);
-
         }
         for (int aux=oldSize; aux<psm->tableSize; aux++) {
             for (int aux2=aux; aux2>=0; aux2--) {
                 /* first we free the malloc with the equity that may have been provided previously
                 */
                 if(!psm->cubeScoreMap && psm->aaQuadrantData[aux2][aux].ml.cMoves < IMPOSSIBLE_CMOVES) {
-                    // g_message("DELETED+FREED: aux2=%d, aux=%d, tableSize=%d, moves=%d......",aux2,aux,psm->tableSize,psm->aaQuadrantData[aux2][aux].ml.cMoves);
                     g_free(psm->aaQuadrantData[aux2][aux].ml.amMoves);
                     psm->aaQuadrantData[aux2][aux].ml.cMoves = IMPOSSIBLE_CMOVES;
                 }
@@ -1684,44 +1781,28 @@ CalcEquities(scoremap * psm, int oldSize, int updateMoneyOnly, int calcOnly)
                 */               
                 if(!calcOnly) // skip with ScoreMapPlyToggled
                     InitQuadrantCubeInfo(psm, aux2, aux);
-                if (psm->aaQuadrantData[aux2][aux].isAllowedScore == ALLOWED || psm->cubeScoreMap) {
-                    //Only running the line below when (i >= oldSize || j >= oldSize) 
-                    // [now aux>=oldSize] yields a bug with grey squares on resize
-                    // if(aux>=oldSize) {
-                        CalcQuadrantEquities(&psm->aaQuadrantData[aux2][aux], psm, (aux >= oldSize));
-                    // if (myDebug)
-                    //     g_print("i=%d,j=%d,FindnSaveBestMoves returned %d, %1.3f; decision: %s\n",i,j,psm->aaQuadrantData[i][j].ml.cMoves,psm->aaQuadrantData[i][j].ml.rBestScore,psm->aaQuadrantData[i][j].decisionString);
-                    // if (aux >= oldSize) // Only count the ones where equities are recomputed (other ones occur near-instantly)
-                        ProgressValueAdd(1);
-                    // }
-                }
-                else {
+                if (psm->aaQuadrantData[aux2][aux].isAllowedScore == ALLOWED || psm->cubeScoreMap)
+                    apq[cQuadrants++] = &psm->aaQuadrantData[aux2][aux];
+                else
                     strcpy(psm->aaQuadrantData[aux2][aux].decisionString, "");
-                    // psm->aaQuadrantData[aux2][aux].ml.cMoves=0; //also used for DestroyDialog
-                }
                 if (aux2<aux) {     //same as above but now doing the other side of the square, without the 
                                     //(aux,aux) vertex on the diagonal
                     if(!psm->cubeScoreMap && psm->aaQuadrantData[aux][aux2].ml.cMoves < IMPOSSIBLE_CMOVES) {
-                        // g_message("DELETED+FREED: aux=%d, aux2=%d, tableSize=%d, moves=%d......",aux,aux2,psm->tableSize,psm->aaQuadrantData[aux][aux2].ml.cMoves);
                         g_free(psm->aaQuadrantData[aux][aux2].ml.amMoves);
                         psm->aaQuadrantData[aux][aux2].ml.cMoves = IMPOSSIBLE_CMOVES;
                     }
                     if(!calcOnly) 
                         InitQuadrantCubeInfo(psm, aux, aux2);
-                    if (psm->aaQuadrantData[aux][aux2].isAllowedScore == ALLOWED || psm->cubeScoreMap) {
-                        // if(aux>=oldSize) {
-                            CalcQuadrantEquities(&psm->aaQuadrantData[aux][aux2], psm, (aux >= oldSize));
-                        // if (aux >= oldSize)
-                            ProgressValueAdd(1);
-                        // }
-                    }
-                    else {
+                    if (psm->aaQuadrantData[aux][aux2].isAllowedScore == ALLOWED || psm->cubeScoreMap)
+                        apq[cQuadrants++] = &psm->aaQuadrantData[aux][aux2];
+                    else
                         strcpy(psm->aaQuadrantData[aux][aux2].decisionString, "");
-                        //psm->aaQuadrantData[aux][aux2].ml.cMoves=0; //also used for DestroyDialog                        
-                    }
                 }
             }
         }
+
+        CalcQuadrants(psm, apq, cQuadrants);
+
         /* if we show the true score in the axes and not the away score: when we scale up a table, a "current" score in a 5-point match becomes a "similar" score
                 in a 7-pt match; but we don't currently check that, as DMP, GG, GS etc don't change => check this case only */
         for (int i = 0; i < psm->tableSize; i++) {
@@ -1871,7 +1952,7 @@ The function updates the decision text in each square.
     Version 2: we disregard scaling up the table and remove this condition.
     */
             // if ((! (psm->tempScaleUp && (i>=psm->oldTableSize || j>=psm->oldTableSize))) || (*pi < 0)) {
-    if (pq->isAllowedScore==ALLOWED) { // non-greyed quadrant
+    if (!g_atomic_int_get(&pq->fPending) && pq->isAllowedScore==ALLOWED) { // non-greyed quadrant, not being calculated
         // we start by cutting long decision strings into two rows; this is only relevant to the move scoremap
         CutTextTo(aux, pq->decisionString, 12);
 
@@ -2659,6 +2740,15 @@ BuildLabelFrame(scoremap *psm, GtkWidget * pwv, const char * frameTitle, const c
 //    return pwDefault;
 }
 
+static gboolean
+DeleteDialog(GtkWidget * UNUSED(pw), GdkEvent * UNUSED(pev), scoremap * psm)
+/* Called by gtk when the user asks to close the score map window.
+We keep it open while its quadrants are being calculated, since the calculation threads write into psm.
+*/
+{
+    return psm == psmCalc;
+}
+
 static void
 DestroyDialog(gpointer p, GObject * UNUSED(obj))
 /* Called by gtk when the score map window is closed.
@@ -2973,6 +3063,13 @@ if needed (this was initially planned for some explanation text, which was then
 
 */
 
+    /* the quadrants are calculated on the calculation threads, which must be free;
+    this also keeps a score map that is being calculated from being replaced */
+    if (!MT_PoolAvailable()) {
+        GTKMessage(_("The score map can't be calculated while another calculation is running."), DT_INFO);
+        return;
+    }
+
     /* dialog */
 
     // First, following feedback: making sure there is only one score map window open
@@ -3030,7 +3127,8 @@ if needed (this was initially planned for some explanation text, which was then
     psm->cubeScoreMap = cube;   // throughout this file: determines whether we want a cube scoremap or a move scoremap
     //colourBasedOn=ALL;     //default gauge; see also the option to set the starting gauge at the bottom
     // psm->describeUsing=DEFAULT_DESCRIPTION; //default description mode: NUMBERS, ENGLISH, BOTH -> moved to static variable
-    psm->pms = pms;
+    psm->msTrue = *pms;
+    psm->pms = &psm->msTrue;
     // matchstate ams = (*pms); // Make a copy of the "master" matchstate  
                 //[note: backgammon.h defines an extern ms => using a different name]
     psm->msTemp = *pms; 
@@ -3119,12 +3217,14 @@ if needed (this was initially planned for some explanation text, which was then
     for (int i=0;i<MAX_TABLE_SIZE; i++) {
         for (int j=0;j<MAX_TABLE_SIZE; j++) {
             psm->aaQuadrantData[i][j].ml.cMoves = IMPOSSIBLE_CMOVES;
+            psm->aaQuadrantData[i][j].fPending = FALSE;
         }
     }
     psm->moneyQuadrantData.isAllowedScore=YET_UNDEFINED; 
     psm->moneyQuadrantData.isTrueScore = NOT_TRUE_SCORE;
     psm->moneyQuadrantData.isSpecialScore = REGULAR; 
     psm->moneyQuadrantData.ml.cMoves = IMPOSSIBLE_CMOVES;
+    psm->moneyQuadrantData.fPending = FALSE;
 
 
 
@@ -3251,16 +3351,20 @@ if needed (this was initially planned for some explanation text, which was then
 // **************************************************************************************************
     /* calculate values and set colours/text in the table */
 
-    /* For each i,j, fill sm->aaQuadrantData[i][j].ci, find equities, and set the text*/
-    CalcEquities(psm,0,FALSE,FALSE);
-    UpdateScoreMapVisual(psm);     //Update: (1) The color of each square (2) The hover text of each square
-                                    //      (3) the row/col score labels (4) the gauge.
-
     /* modality */
 
     gtk_window_set_default_size(GTK_WINDOW(pwDialog), DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
     /* The DestroyDialog function frees the needed memory! */
     g_object_weak_ref(G_OBJECT(pwDialog), DestroyDialog, psm);
+    g_signal_connect(G_OBJECT(pwDialog), "delete_event", G_CALLBACK(DeleteDialog), psm);
+
+    /* show the window first, so that the quadrants appear as they are calculated */
+    gtk_widget_show_all(pwDialog);
+
+    /* For each i,j, fill sm->aaQuadrantData[i][j].ci, find equities, and set the text*/
+    CalcEquities(psm,0,FALSE,FALSE);
+    UpdateScoreMapVisual(psm);     //Update: (1) The color of each square (2) The hover text of each square
+                                    //      (3) the row/col score labels (4) the gauge.
 
     GTKRunDialog(pwDialog);
 }
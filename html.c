@@ -2260,7 +2260,7 @@ HTMLPrintMoveAnalysis(FILE * pf, matchstate * pms, moverecord * pmr,
                     printRolloutTable(pf, NULL, (float (*)[NUM_ROLLOUT_OUTPUTS])
                                       pmr->ml.amMoves[i].arEvalMove, (float (*)[NUM_ROLLOUT_OUTPUTS])
                                       pmr->ml.amMoves[i].arEvalStdDev,
-                                      &ci, 1, pmr->ml.amMoves[i].esMove.rc.fCubeful, FALSE, hecss);
+                                      &ci, 1, pmr->ml.amMoves[i].esMove.prc->fCubeful, FALSE, hecss);
                     break;
                 default:
                     break;
@@ -2279,7 +2279,7 @@ HTMLPrintMoveAnalysis(FILE * pf, matchstate * pms, moverecord * pmr,
 
             if (exsExport.afMovesParameters[pmr->ml.amMoves[i].esMove.et - 1]) {
 
-                evalsetup *pes = &pmr->ml.amMoves[i].esMove;
+                const moveevalsetup *pes = &pmr->ml.amMoves[i].esMove;
 
                 switch (pes->et) {
                 case EVAL_EVAL:
@@ -2305,7 +2305,8 @@ HTMLPrintMoveAnalysis(FILE * pf, matchstate * pms, moverecord * pmr,
 
                 case EVAL_ROLLOUT:
                     {
-                        char *szrc = g_strdup(OutputRolloutContext(NULL, &pes->rc));
+                        evalsetup es;
+                        char *szrc = g_strdup(OutputRolloutContext(NULL, &GetMoveEvalSetup(&es, pes)->rc));
                         char *pcS = szrc, *pcE;
 
                         while ((pcE = strstr(pcS, "\n"))) {
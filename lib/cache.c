@@ -22,6 +22,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#if defined(HAVE_POSIX_MEMALIGN) && defined(HAVE_MADVISE)
+#include <sys/mman.h>
+#endif
 
 #include "cache.h"
 #include "positionid.h"
@@ -29,48 +32,91 @@
 #if defined(USE_MULTITHREAD)
 #include "multithread.h"
 
-#if defined(__GNUC__) && ( \
-    (( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 ) \
-      && (defined (__i486) || defined (__x86_64))) \
-  || (( __GNUC__ * 100 + __GNUC_MINOR__ >= 404 ) \
-      && defined (__i386))			 \
-  )
+/* The seq field of a shared cache entry works as a sequence lock: an
+ * add makes it odd while it rewrites the entry and even again when it
+ * is done.  A lookup copies what it needs without taking the lock and
+ * starts over if seq was odd or has changed meanwhile. */
 
 static inline void
-cache_lock(evalCache * pc, uint32_t k)
+cache_pause(void)
 {
-    while (__sync_lock_test_and_set(&(pc->entries[k].lock), 1))
-        while (__sync_fetch_and_add(&pc->entries[k].lock, 0))
-            __asm__ __volatile__ ("pause":::"memory");
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__("pause":::"memory");
+#endif
 }
 
+#if defined(__ATOMIC_ACQUIRE)
+
 static inline void
-cache_unlock(evalCache * pc, uint32_t k)
+cache_lock(cacheNode * pn)
 {
-    __sync_lock_release(&(pc->entries[k].lock));
-}
+    int seq;
+
+    for (;;) {
+        seq = __atomic_load_n(&pn->seq, __ATOMIC_RELAXED);
+        if (!(seq & 1) && __atomic_compare_exchange_n(&pn->seq, &seq, seq + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+        cache_pause();
+    }
 
-#else	/* not x86 or older gcc: no suitable intrinsics */
+    /* a lookup that sees any of the new contents sees the odd seq too */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
 
 static inline void
-WaitForLock(volatile int *lock)
+cache_unlock(cacheNode * pn)
 {
-    do {
-        MT_SafeDec(lock);
-    } while (MT_SafeIncCheck(lock));
+    __atomic_store_n(&pn->seq, __atomic_load_n(&pn->seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
 }
 
+static inline int
+cache_read_begin(cacheNode * pn)
+{
+    int seq;
+
+    while ((seq = __atomic_load_n(&pn->seq, __ATOMIC_ACQUIRE)) & 1)
+        cache_pause();
+
+    return seq;
+}
+
+static inline int
+cache_read_retry(cacheNode * pn, int seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&pn->seq, __ATOMIC_RELAXED) != seq;
+}
+
+#else	/* no atomic builtins to validate a read with: lookups lock too */
+
 static inline void
-cache_lock(evalCache * pc, uint32_t k)
+cache_lock(cacheNode * pn)
 {
-    if (MT_SafeIncCheck(&(pc->entries[k].lock)))
-        WaitForLock(&(pc->entries[k].lock));
+    while (MT_SafeIncCheck(&pn->seq)) {
+        MT_SafeDec(&pn->seq);
+        cache_pause();
+    }
 }
 
 static inline void
-cache_unlock(evalCache * pc, uint32_t k)
+cache_unlock(cacheNode * pn)
 {
-    MT_SafeDec(&(pc->entries[k].lock));
+    MT_SafeDec(&pn->seq);
+}
+
+static inline int
+cache_read_begin(cacheNode * pn)
+{
+    cache_lock(pn);
+    return 0;
+}
+
+static inline int
+cache_read_retry(cacheNode * pn, int seq)
+{
+    (void) seq;
+    cache_unlock(pn);
+    return 0;
 }
 
 #endif
@@ -78,6 +124,31 @@ cache_unlock(evalCache * pc, uint32_t k)
 #endif                          /* USE_MULTITHREAD */
 
 
+/* A big cache is spread over so many pages that the TLB misses cost as
+ * much as the cache misses themselves; ask for huge pages where the
+ * system has them. */
+static cacheNode *
+AllocEntries(size_t cb)
+{
+#if defined(HAVE_POSIX_MEMALIGN) && defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+    const size_t cbHugePage = 2 * 1024 * 1024;
+
+    if (cb >= cbHugePage) {
+        void *p;
+
+        if (posix_memalign(&p, cbHugePage, cb) != 0)
+            return NULL;
+
+        /* only a hint; the cache works the same without */
+        madvise(p, cb, MADV_HUGEPAGE);
+
+        return (cacheNode *) p;
+    }
+#endif
+
+    return (cacheNode *) malloc(cb);
+}
+
 int
 CacheCreate(evalCache * pc, unsigned int s)
 {
@@ -91,6 +162,7 @@ CacheCreate(evalCache * pc, unsigned int s)
         return -1;
 
     pc->size = s;
+    pc->fShared = 0;
     /* adjust size to smallest power of 2 GE to s */
     while ((s & (s - 1)) != 0)
         s &= (s - 1);
@@ -98,7 +170,7 @@ CacheCreate(evalCache * pc, unsigned int s)
     pc->size = (s < pc->size) ? 2 * s : s;
     pc->hashMask = (pc->size >> 1) - 1;
 
-    pc->entries = (cacheNode *) malloc((pc->size / 2) * sizeof(*pc->entries));
+    pc->entries = AllocEntries((pc->size / 2) * sizeof(*pc->entries));
     if (pc->entries == NULL)
         return -1;
 
@@ -146,10 +218,17 @@ GetHashKey(uint32_t hashMask, const cacheNodeDetail * restrict e)
 }
 
 
+static inline int
+EqualDetails(const cacheNodeDetail * restrict pnd, const cacheNodeDetail * restrict e)
+{
+    return EqualKeys(pnd->key, e->key) && pnd->nEvalContext == e->nEvalContext;
+}
+
 uint32_t
-CacheLookupWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, float * restrict arOut, float * restrict arCubeful)
+CacheLookup(evalCache * restrict pc, const cacheNodeDetail * restrict e, float * restrict arOut, float * restrict arCubeful)
 {
     uint32_t const l = GetHashKey(pc->hashMask, e);
+    cacheNode *pn = &pc->entries[l];
 
 #if CACHE_STATS
 #if defined(USE_MULTITHREAD)
@@ -160,85 +239,77 @@ CacheLookupWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict
 #endif
 
 #if defined(USE_MULTITHREAD)
-    cache_lock(pc, l);
-#endif
-
-    if (!EqualKeys(pc->entries[l].nd_primary.key, e->key) || pc->entries[l].nd_primary.nEvalContext != e->nEvalContext) {       /* Not in primary slot */
-        if (!EqualKeys(pc->entries[l].nd_secondary.key, e->key) || pc->entries[l].nd_secondary.nEvalContext != e->nEvalContext) {       /* Cache miss */
-#if defined(USE_MULTITHREAD)
-            cache_unlock(pc, l);
-#endif
+    if (pc->fShared) {
+        float ar[6];
+        int seq, fHit;
+
+        do {
+            seq = cache_read_begin(pn);
+
+            if ((fHit = EqualDetails(&pn->nd_primary, e)))
+                memcpy(ar, pn->nd_primary.ar, sizeof(ar));
+            else if ((fHit = EqualDetails(&pn->nd_secondary, e)))
+                memcpy(ar, pn->nd_secondary.ar, sizeof(ar));
+        } while (cache_read_retry(pn, seq));
+
+        /* A hit in the secondary slot is not promoted here, since that
+         * would turn the lookup into a writer */
+        if (!fHit)
             return l;
-        } else {                /* Found in second slot, promote "hot" entry */
-            cacheNodeDetail tmp = pc->entries[l].nd_primary;
 
-            pc->entries[l].nd_primary = pc->entries[l].nd_secondary;
-            pc->entries[l].nd_secondary = tmp;
-        }
-    }
-    /* Cache hit */
-    memcpy(arOut, pc->entries[l].nd_primary.ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
-    if (arCubeful)
-        *arCubeful = pc->entries[l].nd_primary.ar[5];   /* Cubeful equity stored in slot 5 */
-
-#if defined(USE_MULTITHREAD)
-    cache_unlock(pc, l);
-#endif
+        memcpy(arOut, ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
+        if (arCubeful)
+            *arCubeful = ar[5];
 
 #if CACHE_STATS
-#if defined(USE_MULTITHREAD)
-    MT_SafeInc(&pc->cHit);
-#else
-    ++pc->cHit;
+        MT_SafeInc(&pc->cHit);
 #endif
+        return CACHEHIT;
+    }
 #endif
 
-    return CACHEHIT;
-}
-
-uint32_t
-CacheLookupNoLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, float *restrict arOut, float * restrict arCubeful)
-{
-    uint32_t const l = GetHashKey(pc->hashMask, e);
-
-#if CACHE_STATS
-    ++pc->cLookup;
-#endif
-    if (!EqualKeys(pc->entries[l].nd_primary.key, e->key) || pc->entries[l].nd_primary.nEvalContext != e->nEvalContext) {       /* Not in primary slot */
-        if (!EqualKeys(pc->entries[l].nd_secondary.key, e->key) || pc->entries[l].nd_secondary.nEvalContext != e->nEvalContext) {       /* Cache miss */
+    if (!EqualDetails(&pn->nd_primary, e)) {    /* Not in primary slot */
+        if (!EqualDetails(&pn->nd_secondary, e)) {      /* Cache miss */
             return l;
         } else {                /* Found in second slot, promote "hot" entry */
-            cacheNodeDetail tmp = pc->entries[l].nd_primary;
+            cacheNodeDetail tmp = pn->nd_primary;
 
-            pc->entries[l].nd_primary = pc->entries[l].nd_secondary;
-            pc->entries[l].nd_secondary = tmp;
+            pn->nd_primary = pn->nd_secondary;
+            pn->nd_secondary = tmp;
         }
     }
 
     /* Cache hit */
-    memcpy(arOut, pc->entries[l].nd_primary.ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
+    memcpy(arOut, pn->nd_primary.ar, sizeof(float) * 5 /*NUM_OUTPUTS */ );
     if (arCubeful)
-        *arCubeful = pc->entries[l].nd_primary.ar[5];   /* Cubeful equity stored in slot 5 */
+        *arCubeful = pn->nd_primary.ar[5];      /* Cubeful equity stored in slot 5 */
 
 #if CACHE_STATS
+#if defined(USE_MULTITHREAD)
+    MT_SafeInc(&pc->cHit);
+#else
     ++pc->cHit;
+#endif
 #endif
 
     return CACHEHIT;
 }
 
-void
-CacheAddWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e, uint32_t l)
+int
+CacheAddShared(evalCache * restrict pc, const cacheNodeDetail * restrict e, uint32_t l)
 {
+    int fEvict;
+
 #if defined(USE_MULTITHREAD)
-    cache_lock(pc, l);
+    cache_lock(&pc->entries[l]);
 #endif
 
+    fEvict = (pc->entries[l].nd_secondary.key.data[0] != (unsigned int) -1);
     pc->entries[l].nd_secondary = pc->entries[l].nd_primary;
     pc->entries[l].nd_primary = *e;
 
 #if defined(USE_MULTITHREAD)
-    cache_unlock(pc, l);
+    cache_unlock(&pc->entries[l]);
 #endif
 
 #if CACHE_STATS
@@ -248,9 +319,11 @@ CacheAddWithLocking(evalCache * restrict pc, const cacheNodeDetail * restrict e,
     ++pc->nAdds;
 #endif
 #endif
+
+    return fEvict;
 }
 
-/* CacheAddNoLocking() is inlined and in cache.h */
+/* CacheAdd() is inlined and in cache.h */
 
 void
 CacheDestroy(const evalCache * pc)
@@ -266,7 +339,7 @@ CacheFlush(const evalCache * pc)
         pc->entries[k].nd_primary.key.data[0] = (unsigned int) -1;
         pc->entries[k].nd_secondary.key.data[0] = (unsigned int) -1;
 #if defined(USE_MULTITHREAD)
-        pc->entries[k].lock = 0;
+        pc->entries[k].seq = 0;
 #endif
     }
 }
@@ -275,9 +348,12 @@ int
 CacheResize(evalCache * pc, unsigned int cNew)
 {
     if (cNew != pc->size) {
+        int fShared = pc->fShared;
+
         CacheDestroy(pc);
         if (CacheCreate(pc, cNew) != 0)
             return -1;
+        pc->fShared = fShared;
     }
 
     return (int) pc->size;
@@ -44,7 +44,7 @@ typedef struct {
     cacheNodeDetail nd_primary;
     cacheNodeDetail nd_secondary;
 #if defined(USE_MULTITHREAD)
-    int lock;
+    int seq;                    /* odd while the entry is being rewritten */
 #endif
 } cacheNode;
 
@@ -57,6 +57,12 @@ typedef struct {
     unsigned int size;
     uint32_t hashMask;
 
+    /* Set when several threads use the cache.  Lookups then read
+     * without locking and retry if an add raced with them; adds lock
+     * the entry they replace.  A cache used by a single thread pays
+     * for neither. */
+    int fShared;
+
 #if CACHE_STATS
     unsigned int nAdds;
     unsigned int cLookup;
@@ -64,6 +70,12 @@ typedef struct {
 #endif
 } evalCache;
 
+#if defined(HAVE_FUNC_ATTRIBUTE_PURE)
+uint32_t GetHashKey(uint32_t hashMask, const cacheNodeDetail * e) __attribute((pure));
+#else
+uint32_t GetHashKey(uint32_t hashMask, const cacheNodeDetail * e);
+#endif
+
 /* Cache size will be adjusted to a power of 2 */
 int CacheCreate(evalCache * pc, unsigned int size);
 int CacheResize(evalCache * pc, unsigned int cNew);
@@ -71,18 +83,44 @@ int CacheResize(evalCache * pc, unsigned int cNew);
 #define CACHEHIT ((uint32_t)-1)
 
 /* returns a value which is passed to CacheAdd (if a miss) */
-unsigned int CacheLookupWithLocking(evalCache * pc, const cacheNodeDetail * e, float *arOut, float *arCubeful);
-unsigned int CacheLookupNoLocking(evalCache * pc, const cacheNodeDetail * e, float *arOut, float *arCubeful);
+uint32_t CacheLookup(evalCache * pc, const cacheNodeDetail * e, float *arOut, float *arCubeful);
 
-void CacheAddWithLocking(evalCache * pc, const cacheNodeDetail * e, uint32_t l);
+int CacheAddShared(evalCache * pc, const cacheNodeDetail * e, uint32_t l);
 
-static inline void
-CacheAddNoLocking(evalCache * pc, const cacheNodeDetail * e, const uint32_t l)
+/* returns TRUE if a valid entry had to be dropped to make room */
+static inline int
+CacheAdd(evalCache * pc, const cacheNodeDetail * e, const uint32_t l)
 {
+    int fEvict;
+
+#if defined(USE_MULTITHREAD)
+    if (pc->fShared)
+        return CacheAddShared(pc, e, l);
+#endif
+
+    fEvict = (pc->entries[l].nd_secondary.key.data[0] != (unsigned int) -1);
+
     pc->entries[l].nd_secondary = pc->entries[l].nd_primary;
     pc->entries[l].nd_primary = *e;
 #if CACHE_STATS
     ++pc->nAdds;
+#endif
+    return fEvict;
+}
+
+/* Start loading the entry that a lookup of e will read, so that the
+ * lookups of a batch of positions can wait for memory together */
+static inline void
+CachePrefetch(const evalCache * pc, const cacheNodeDetail * e)
+{
+#if defined(__GNUC__)
+    const char *p = (const char *) &pc->entries[GetHashKey(pc->hashMask, e)];
+
+    __builtin_prefetch(p);
+    __builtin_prefetch(p + sizeof(cacheNode) - 1);
+#else
+    (void) pc;
+    (void) e;
 #endif
 }
 
@@ -93,10 +131,4 @@ void CacheDestroy(const evalCache * pc);
 void CacheStats(const evalCache * pc, unsigned int *pcLookup, unsigned int *pcHit, unsigned int *pcUsed);
 #endif
 
-#if defined(HAVE_FUNC_ATTRIBUTE_PURE)
-uint32_t GetHashKey(uint32_t hashMask, const cacheNodeDetail * e) __attribute((pure));
-#else
-uint32_t GetHashKey(uint32_t hashMask, const cacheNodeDetail * e);
-#endif
-
 #endif
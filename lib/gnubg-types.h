@@ -68,4 +68,11 @@ typedef union {
     unsigned char auch[10];
 } oldpositionkey;
 
+/* A board with one byte per point.  Each side is padded to 32 bytes (the
+ * points past the bar are always 0), so the board is 64 bytes and a side
+ * fills two SSE registers. */
+typedef struct {
+    unsigned char an[2][32];
+} packedboard;
+
 #endif
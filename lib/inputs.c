@@ -1,6 +1,6 @@
 /*
  * Copyright (C) 2006 Oystein Johansen <oystein@gnubg.org>
- * Copyright (C) 2011-2018 the AUTHORS
+ * Copyright (C) 2011-2026 the AUTHORS
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -236,3 +236,54 @@ baseInputs(const TanBoard anBoard, float arInput[])
     }
 }
 #endif
+
+/* Bit i of afOccupied[side] is set if anBoard[side][i] has a chequer,
+ * bit i of afMade[side] if it has two or more. */
+
+#if defined(USE_SIMD_INSTRUCTIONS) && (defined(USE_AVX) || defined(USE_SSE2))
+extern SIMD_STACKALIGN void
+pointMasks(const TanBoard anBoard, unsigned int afOccupied[2], unsigned int afMade[2])
+{
+    const __m128i vZero = _mm_setzero_si128();
+    const __m128i vOne = _mm_set1_epi32(1);
+    int side, i;
+
+    for (side = 0; side < 2; side++) {
+        const unsigned int *pB = anBoard[side];
+        unsigned int fOccupied = 0, fMade = 0;
+
+        for (i = 0; i < 24; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (pB + i));
+
+            fOccupied |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, vZero))) << i;
+            fMade |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, vOne))) << i;
+        }
+
+        /* bar */
+        fOccupied |= (unsigned int) (pB[24] > 0) << 24;
+        fMade |= (unsigned int) (pB[24] > 1) << 24;
+
+        afOccupied[side] = fOccupied;
+        afMade[side] = fMade;
+    }
+}
+#else
+extern void
+pointMasks(const TanBoard anBoard, unsigned int afOccupied[2], unsigned int afMade[2])
+{
+    int side, i;
+
+    for (side = 0; side < 2; side++) {
+        const unsigned int *pB = anBoard[side];
+        unsigned int fOccupied = 0, fMade = 0;
+
+        for (i = 0; i < 25; i++) {
+            fOccupied |= (unsigned int) (pB[i] > 0) << i;
+            fMade |= (unsigned int) (pB[i] > 1) << i;
+        }
+
+        afOccupied[side] = fOccupied;
+        afMade[side] = fMade;
+    }
+}
+#endif
@@ -42,6 +42,7 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
     pnn->rBetaHidden = rBetaHidden;
     pnn->rBetaOutput = rBetaOutput;
     pnn->nTrained = 0;
+    pnn->fMapped = FALSE;
 
     if ((pnn->arHiddenWeight = sse_malloc(cHidden * cInput * sizeof(float))) == NULL)
         return -1;
@@ -70,6 +71,14 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
 extern void
 NeuralNetDestroy(neuralnet * pnn)
 {
+    if (pnn->fMapped) {
+        /* owned by the mapping */
+        pnn->arHiddenWeight = pnn->arOutputWeight = NULL;
+        pnn->arHiddenThreshold = pnn->arOutputThreshold = NULL;
+        pnn->fMapped = FALSE;
+        return;
+    }
+
     sse_free(pnn->arHiddenWeight);
     pnn->arHiddenWeight = 0;
     sse_free(pnn->arOutputWeight);
@@ -301,6 +310,36 @@ NeuralNetLoad(neuralnet * pnn, FILE * pf)
     return 0;
 }
 
+/* Write pnn in the text format read by NeuralNetLoad. */
+extern int
+NeuralNetSave(const neuralnet * pnn, FILE * pf)
+{
+    unsigned int i;
+    const float *pr;
+
+    if (fprintf(pf, "%u %u %u %d %.7f %.7f\n", pnn->cInput, pnn->cHidden,
+                pnn->cOutput, pnn->nTrained, pnn->rBetaHidden, pnn->rBetaOutput) < 0)
+        return -1;
+
+    for (i = pnn->cInput * pnn->cHidden, pr = pnn->arHiddenWeight; i; i--)
+        if (fprintf(pf, "%.7f\n", *pr++) < 0)
+            return -1;
+
+    for (i = pnn->cHidden * pnn->cOutput, pr = pnn->arOutputWeight; i; i--)
+        if (fprintf(pf, "%.7f\n", *pr++) < 0)
+            return -1;
+
+    for (i = pnn->cHidden, pr = pnn->arHiddenThreshold; i; i--)
+        if (fprintf(pf, "%.7f\n", *pr++) < 0)
+            return -1;
+
+    for (i = pnn->cOutput, pr = pnn->arOutputThreshold; i; i--)
+        if (fprintf(pf, "%.7f\n", *pr++) < 0)
+            return -1;
+
+    return 0;
+}
+
 extern int
 NeuralNetLoadBinary(neuralnet * pnn, FILE * pf)
 {
@@ -359,6 +398,123 @@ NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf)
     return 0;
 }
 
+/*
+ * Weights image.
+ *
+ * Each net is a descriptor of NN_IMAGE_ALIGN bytes followed by its
+ * arrays, each starting on a NN_IMAGE_ALIGN boundary, so that a
+ * read-only mapping of the file can be evaluated in place.
+ */
+
+typedef struct {
+    unsigned int cInput;
+    unsigned int cHidden;
+    unsigned int cOutput;
+    int nTrained;
+    float rBetaHidden;
+    float rBetaOutput;
+    char pad[NN_IMAGE_ALIGN - 6 * 4];
+} nnimagedesc;
+
+static size_t
+ImageSize(size_t cFloats)
+{
+    size_t cb = cFloats * sizeof(float);
+
+    return (cb + NN_IMAGE_ALIGN - 1) / NN_IMAGE_ALIGN * NN_IMAGE_ALIGN;
+}
+
+static int
+WritePadded(const float *ar, size_t c, FILE * pf)
+{
+    static const char achZero[NN_IMAGE_ALIGN];
+    size_t cbPad = ImageSize(c) - c * sizeof(float);
+
+    if (fwrite(ar, sizeof(float), c, pf) < c)
+        return -1;
+    if (cbPad && fwrite(achZero, 1, cbPad, pf) < cbPad)
+        return -1;
+
+    return 0;
+}
+
+extern int
+NeuralNetSaveImage(const neuralnet * pnn, FILE * pf)
+{
+    nnimagedesc d;
+
+    memset(&d, 0, sizeof(d));
+    d.cInput = pnn->cInput;
+    d.cHidden = pnn->cHidden;
+    d.cOutput = pnn->cOutput;
+    d.nTrained = pnn->nTrained;
+    d.rBetaHidden = pnn->rBetaHidden;
+    d.rBetaOutput = pnn->rBetaOutput;
+
+    if (fwrite(&d, sizeof(d), 1, pf) < 1
+        || WritePadded(pnn->arHiddenWeight, pnn->cInput * pnn->cHidden, pf)
+        || WritePadded(pnn->arOutputWeight, pnn->cHidden * pnn->cOutput, pf)
+        || WritePadded(pnn->arHiddenThreshold, pnn->cHidden, pf)
+        || WritePadded(pnn->arOutputThreshold, pnn->cOutput, pf))
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Point pnn at the net stored at p, which must be aligned on
+ * NN_IMAGE_ALIGN and stay mapped while pnn is used.
+ *
+ * Returns the number of bytes used by the net, or 0 if the image is
+ * invalid or truncated.
+ */
+
+extern size_t
+NeuralNetFromImage(neuralnet * pnn, const void *p, size_t cb)
+{
+    const nnimagedesc *pd = p;
+    const char *pch = p;
+    size_t cbHiddenWeight, cbOutputWeight, cbHiddenThreshold, cbOutputThreshold;
+
+    if (((size_t) p) % NN_IMAGE_ALIGN || cb < sizeof(nnimagedesc)
+        || pd->cInput < 1 || pd->cHidden < 1 || pd->cOutput < 1
+        || pd->rBetaHidden <= 0.0f || pd->rBetaOutput <= 0.0f) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    cbHiddenWeight = ImageSize((size_t) pd->cInput * pd->cHidden);
+    cbOutputWeight = ImageSize((size_t) pd->cHidden * pd->cOutput);
+    cbHiddenThreshold = ImageSize(pd->cHidden);
+    cbOutputThreshold = ImageSize(pd->cOutput);
+
+    if (cb < sizeof(nnimagedesc) + cbHiddenWeight + cbOutputWeight + cbHiddenThreshold + cbOutputThreshold) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    pnn->cInput = pd->cInput;
+    pnn->cHidden = pd->cHidden;
+    pnn->cOutput = pd->cOutput;
+    pnn->nTrained = pd->nTrained;
+    pnn->rBetaHidden = pd->rBetaHidden;
+    pnn->rBetaOutput = pd->rBetaOutput;
+
+    /* the evaluation code does not write through these */
+    pch += sizeof(nnimagedesc);
+    pnn->arHiddenWeight = (float *) pch;
+    pch += cbHiddenWeight;
+    pnn->arOutputWeight = (float *) pch;
+    pch += cbOutputWeight;
+    pnn->arHiddenThreshold = (float *) pch;
+    pch += cbHiddenThreshold;
+    pnn->arOutputThreshold = (float *) pch;
+    pch += cbOutputThreshold;
+    pnn->fMapped = TRUE;
+
+    return (size_t) (pch - (const char *) p);
+}
+
 
 #if defined(USE_SIMD_INSTRUCTIONS)
 
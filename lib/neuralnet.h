@@ -35,8 +35,12 @@ typedef struct {
     float *arOutputWeight;
     float *arHiddenThreshold;
     float *arOutputThreshold;
+    int fMapped;                /* the arrays point into a weights image */
 } neuralnet;
 
+/* alignment of the nets and of their arrays in a weights image */
+#define NN_IMAGE_ALIGN 64
+
 typedef enum {
     NNEVAL_NONE,
     NNEVAL_SAVE,
@@ -58,6 +62,23 @@ typedef struct {
 #endif
 } NNState;
 
+/* Gradient of the squared error of a net's outputs, summed over the
+ * positions of a training batch.  The arrays are laid out as those of
+ * the net. */
+typedef struct {
+    unsigned int cInput;
+    unsigned int cHidden;
+    unsigned int cOutput;
+    float *arHiddenWeight;
+    float *arOutputWeight;
+    float *arHiddenThreshold;
+    float *arOutputThreshold;
+    float *arHidden;            /* scratch space for one position */
+    float *arHiddenDelta;
+    unsigned int cPositions;
+    double rError;              /* summed squared error of the outputs */
+} nngradient;
+
 extern void NeuralNetDestroy(neuralnet * pnn);
 #if !defined(USE_SIMD_INSTRUCTIONS)
 extern int NeuralNetEvaluate(const neuralnet * pnn, float arInput[], float arOutput[], NNState * pnState);
@@ -66,9 +87,18 @@ extern int NeuralNetEvaluateSSE(const neuralnet * pnn, float arInput[], float ar
 #endif
 extern int NeuralNetLoad(neuralnet * pnn, FILE * pf);
 extern int NeuralNetLoadBinary(neuralnet * pnn, FILE * pf);
+extern int NeuralNetSave(const neuralnet * pnn, FILE * pf);
 extern int NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf);
+extern int NeuralNetSaveImage(const neuralnet * pnn, FILE * pf);
+extern size_t NeuralNetFromImage(neuralnet * pnn, const void *p, size_t cb);
 extern int SIMD_Supported(void);
 
+extern int NeuralNetGradientCreate(nngradient * png, const neuralnet * pnn);
+extern void NeuralNetGradientDestroy(nngradient * png);
+extern void NeuralNetGradientClear(nngradient * png);
+extern void NeuralNetBackprop(const neuralnet * pnn, const float arInput[], const float arTarget[], nngradient * png);
+extern void NeuralNetApplyGradient(neuralnet * pnn, const nngradient * png, float rStep);
+
 /* Try to determine whether we are 64-bit or 32-bit */
 #if defined(_WIN32) || defined(_WIN64)
 #if defined(_WIN64)
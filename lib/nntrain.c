@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Backpropagation for the nets of neuralnet.c.
+ *
+ * NeuralNetBackprop() adds the gradient of the squared error for one
+ * position to an nngradient; a trainer sums a batch of positions (one
+ * nngradient per thread) and then steps the weights against it with
+ * NeuralNetApplyGradient().  The nets are evaluated here with an exact
+ * logistic function rather than the table approximation of sigmoid.h.
+ */
+
+#include "config.h"
+#include "common.h"
+
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "neuralnet.h"
+#include "simd.h"
+
+#if defined(USE_SIMD_INSTRUCTIONS)
+#if defined(USE_NEON)
+#include <arm_neon.h>
+#elif defined(USE_AVX)
+#include <immintrin.h>
+#elif defined(USE_SSE2)
+#include <emmintrin.h>
+#else
+#include <xmmintrin.h>
+#endif
+
+#if defined(USE_AVX)
+#define VSET1(a) _mm256_set1_ps(a)
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, v) _mm256_storeu_ps(p, v)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#if defined(USE_FMA3)
+#define VMADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define VMADD(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#define VZERO() _mm256_setzero_ps()
+#elif defined(USE_NEON)
+#define VSET1(a) vdupq_n_f32(a)
+#define VLOAD(p) vld1q_f32(p)
+#define VSTORE(p, v) vst1q_f32(p, v)
+#define VADD(a, b) vaddq_f32(a, b)
+#define VMADD(a, b, c) vmlaq_f32(c, a, b)
+#define VZERO() vdupq_n_f32(0.0f)
+#else
+#define VSET1(a) _mm_set1_ps(a)
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, v) _mm_storeu_ps(p, v)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VMADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define VZERO() _mm_setzero_ps()
+#endif
+#endif                          /* USE_SIMD_INSTRUCTIONS */
+
+/* ar[] += r * arX[] */
+static inline void
+AddScaled(float *restrict ar, const float *restrict arX, float r, unsigned int c)
+{
+    unsigned int i = 0;
+
+#if defined(USE_SIMD_INSTRUCTIONS)
+    float_vector vr = VSET1(r);
+
+    for (; i + VEC_SIZE <= c; i += VEC_SIZE)
+        VSTORE(ar + i, VMADD(vr, VLOAD(arX + i), VLOAD(ar + i)));
+#endif
+
+    for (; i < c; i++)
+        ar[i] += r * arX[i];
+}
+
+static inline float
+Dot(const float *restrict ar0, const float *restrict ar1, unsigned int c)
+{
+    unsigned int i = 0;
+    float r = 0.0f;
+
+#if defined(USE_SIMD_INSTRUCTIONS)
+    SSE_ALIGN(float arSum[VEC_SIZE]);
+    float_vector vSum = VZERO();
+    unsigned int j;
+
+    for (; i + VEC_SIZE <= c; i += VEC_SIZE)
+        vSum = VMADD(VLOAD(ar0 + i), VLOAD(ar1 + i), vSum);
+
+    VSTORE(arSum, vSum);
+    for (j = 0; j < VEC_SIZE; j++)
+        r += arSum[j];
+#endif
+
+    for (; i < c; i++)
+        r += ar0[i] * ar1[i];
+
+    return r;
+}
+
+static inline float
+Logistic(float r)
+{
+    return 1.0f / (1.0f + expf(-r));
+}
+
+extern int
+NeuralNetGradientCreate(nngradient * png, const neuralnet * pnn)
+{
+    png->cInput = pnn->cInput;
+    png->cHidden = pnn->cHidden;
+    png->cOutput = pnn->cOutput;
+
+    png->arHiddenWeight = sse_malloc(pnn->cInput * pnn->cHidden * sizeof(float));
+    png->arOutputWeight = sse_malloc(pnn->cOutput * pnn->cHidden * sizeof(float));
+    png->arHiddenThreshold = sse_malloc(pnn->cHidden * sizeof(float));
+    png->arOutputThreshold = sse_malloc(pnn->cOutput * sizeof(float));
+    png->arHidden = sse_malloc(pnn->cHidden * sizeof(float));
+    png->arHiddenDelta = sse_malloc(pnn->cHidden * sizeof(float));
+
+    if (!png->arHiddenWeight || !png->arOutputWeight || !png->arHiddenThreshold
+        || !png->arOutputThreshold || !png->arHidden || !png->arHiddenDelta) {
+        NeuralNetGradientDestroy(png);
+        return -1;
+    }
+
+    NeuralNetGradientClear(png);
+
+    return 0;
+}
+
+extern void
+NeuralNetGradientDestroy(nngradient * png)
+{
+    sse_free(png->arHiddenWeight);
+    sse_free(png->arOutputWeight);
+    sse_free(png->arHiddenThreshold);
+    sse_free(png->arOutputThreshold);
+    sse_free(png->arHidden);
+    sse_free(png->arHiddenDelta);
+
+    memset(png, 0, sizeof(*png));
+}
+
+extern void
+NeuralNetGradientClear(nngradient * png)
+{
+    memset(png->arHiddenWeight, 0, png->cInput * png->cHidden * sizeof(float));
+    memset(png->arOutputWeight, 0, png->cOutput * png->cHidden * sizeof(float));
+    memset(png->arHiddenThreshold, 0, png->cHidden * sizeof(float));
+    memset(png->arOutputThreshold, 0, png->cOutput * sizeof(float));
+
+    png->cPositions = 0;
+    png->rError = 0.0;
+}
+
+/* Add the gradient of the squared error of pnn's outputs for arInput
+ * against arTarget to png. */
+extern void
+NeuralNetBackprop(const neuralnet * pnn, const float arInput[], const float arTarget[], nngradient * png)
+{
+    const unsigned int cHidden = pnn->cHidden;
+    float *arHidden = png->arHidden, *arDelta = png->arHiddenDelta;
+    unsigned int i, j;
+
+    /* forward pass; most inputs are zero, as in Evaluate() */
+    memcpy(arHidden, pnn->arHiddenThreshold, cHidden * sizeof(float));
+
+    for (i = 0; i < pnn->cInput; i++)
+        if (arInput[i] != 0.0f)
+            AddScaled(arHidden, pnn->arHiddenWeight + i * cHidden, arInput[i], cHidden);
+
+    for (j = 0; j < cHidden; j++)
+        arHidden[j] = Logistic(pnn->rBetaHidden * arHidden[j]);
+
+    memset(arDelta, 0, cHidden * sizeof(float));
+
+    for (i = 0; i < pnn->cOutput; i++) {
+        const float *arWeight = pnn->arOutputWeight + i * cHidden;
+        float rOutput = Logistic(pnn->rBetaOutput * (pnn->arOutputThreshold[i] + Dot(arWeight, arHidden, cHidden)));
+        float rError = rOutput - arTarget[i];
+        float rDelta = rError * pnn->rBetaOutput * rOutput * (1.0f - rOutput);
+
+        png->rError += rError * rError;
+
+        AddScaled(png->arOutputWeight + i * cHidden, arHidden, rDelta, cHidden);
+        png->arOutputThreshold[i] += rDelta;
+
+        /* error propagated back to the hidden nodes */
+        AddScaled(arDelta, arWeight, rDelta, cHidden);
+    }
+
+    for (j = 0; j < cHidden; j++)
+        arDelta[j] *= pnn->rBetaHidden * arHidden[j] * (1.0f - arHidden[j]);
+
+    for (j = 0; j < cHidden; j++)
+        png->arHiddenThreshold[j] += arDelta[j];
+
+    for (i = 0; i < pnn->cInput; i++)
+        if (arInput[i] != 0.0f)
+            AddScaled(png->arHiddenWeight + i * cHidden, arDelta, arInput[i], cHidden);
+
+    png->cPositions++;
+}
+
+/* Move the weights of pnn by -rStep times the gradient. */
+extern void
+NeuralNetApplyGradient(neuralnet * pnn, const nngradient * png, float rStep)
+{
+    g_assert(!pnn->fMapped);
+
+    AddScaled(pnn->arHiddenWeight, png->arHiddenWeight, -rStep, pnn->cInput * pnn->cHidden);
+    AddScaled(pnn->arOutputWeight, png->arOutputWeight, -rStep, pnn->cOutput * pnn->cHidden);
+    AddScaled(pnn->arHiddenThreshold, png->arHiddenThreshold, -rStep, pnn->cHidden);
+    AddScaled(pnn->arOutputThreshold, png->arOutputThreshold, -rStep, pnn->cOutput);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Operations on packedboard.  The position key holds one nibble per
+ * point, the low nibble first, so on a little-endian machine a key is
+ * just the bytes of the board with each pair of points merged.  The SSE2
+ * versions below do that a side at a time.
+ *
+ * Only move generation works on packed boards.  Classification, the
+ * neural net inputs and the evaluation cache take the TanBoard or key
+ * that their callers already hold, so a packed board there would only
+ * add a conversion.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "packedboard.h"
+#include "simd.h"
+
+#if defined(USE_SIMD_INSTRUCTIONS) && (defined(USE_AVX) || defined(USE_SSE2))
+#define PACKED_SSE2 1
+#if defined(USE_AVX)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
+
+extern void
+PackBoard(const TanBoard anBoard, packedboard * ppb)
+{
+    unsigned int i;
+
+    memset(ppb, 0, sizeof(*ppb));
+
+    for (i = 0; i < 25; i++) {
+        ppb->an[0][i] = (unsigned char) anBoard[0][i];
+        ppb->an[1][i] = (unsigned char) anBoard[1][i];
+    }
+}
+
+#if defined(PACKED_SSE2)
+
+/* The 32 points of a side, two to a byte. */
+static inline __m128i
+PackSide(const unsigned char *an)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i x0 = _mm_loadu_si128((const __m128i *) an);
+    __m128i x1 = _mm_loadu_si128((const __m128i *) (an + 16));
+
+    /* each 16 bit lane holds points 2k and 2k+1; merge them in its low byte */
+    x0 = _mm_and_si128(_mm_or_si128(x0, _mm_srli_epi16(x0, 4)), mask);
+    x1 = _mm_and_si128(_mm_or_si128(x1, _mm_srli_epi16(x1, 4)), mask);
+
+    return _mm_packus_epi16(x0, x1);
+}
+
+extern void
+PackedPositionKey(const packedboard * ppb, positionkey * pkey)
+{
+    unsigned char ach0[16], ach1[16];
+
+    _mm_storeu_si128((__m128i *) ach0, PackSide(ppb->an[0]));
+    _mm_storeu_si128((__m128i *) ach1, PackSide(ppb->an[1]));
+
+    /* points 0 to 23 of each side, then both bars */
+    memcpy(pkey->data, ach1, 12);
+    memcpy(pkey->data + 3, ach0, 12);
+    pkey->data[6] = ach0[12] | ((unsigned int) ach1[12] << 4);
+}
+
+#else
+
+extern void
+PackedPositionKey(const packedboard * ppb, positionkey * pkey)
+{
+    unsigned int i, j, k;
+
+    for (i = 0, j = 0; i < 3; i++, j += 8) {
+        pkey->data[i] = pkey->data[i + 3] = 0;
+        for (k = 0; k < 8; k++) {
+            pkey->data[i] |= (unsigned int) ppb->an[1][j + k] << (4 * k);
+            pkey->data[i + 3] |= (unsigned int) ppb->an[0][j + k] << (4 * k);
+        }
+    }
+    pkey->data[6] = ppb->an[0][24] | ((unsigned int) ppb->an[1][24] << 4);
+}
+
+#endif
@@ -1,6 +1,5 @@
 /*
- * Copyright (C) 2009 Michael Petch <mpetch@gnubg.org>
- * Copyright (C) 2009 Christian Anthon <anthon@kiku.dk>
+ * Copyright (C) 2026 the AUTHORS
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -14,14 +13,16 @@
  *
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
- *
- * $Id: evallock.c,v 1.3 2013/06/16 02:16:11 mdpetch Exp $
  */
 
-#include "config.h"
-#if USE_MULTITHREAD
-#define LOCKING_VERSION 1
+#ifndef PACKEDBOARD_H
+#define PACKEDBOARD_H
+
+#include "gnubg-types.h"
+
+extern void PackBoard(const TanBoard anBoard, packedboard * ppb);
+
+/* the same key as PositionKey() */
+extern void PackedPositionKey(const packedboard * ppb, positionkey * pkey);
 
-#include "eval.c"
-#include "rollout.c"
 #endif
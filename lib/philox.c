@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "philox.h"
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U   /* golden ratio */
+#define PHILOX_W1 0xBB67AE85U   /* sqrt(3) - 1 */
+#define PHILOX_ROUNDS 10
+
+extern void
+philox4x32(const philoxblock * pCounter, const philoxkey * pKey, philoxblock * pResult)
+{
+    uint32_t x0 = pCounter->an[0], x1 = pCounter->an[1], x2 = pCounter->an[2], x3 = pCounter->an[3];
+    uint32_t k0 = pKey->an[0], k1 = pKey->an[1];
+    int i;
+
+    for (i = 0; i < PHILOX_ROUNDS; i++) {
+        uint64_t p0 = (uint64_t) PHILOX_M0 * x0;
+        uint64_t p1 = (uint64_t) PHILOX_M1 * x2;
+
+        x0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+        x1 = (uint32_t) p1;
+        x2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+        x3 = (uint32_t) p0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    pResult->an[0] = x0;
+    pResult->an[1] = x1;
+    pResult->an[2] = x2;
+    pResult->an[3] = x3;
+}
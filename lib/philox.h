@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Philox4x32-10, the counter-based generator of Salmon, Moraes, Dror
+ * and Shaw, "Parallel Random Numbers: As Easy as 1, 2, 3" (SC11).
+ *
+ * The output is a pure function of a 128 bit counter and a 64 bit key:
+ * any block can be computed directly, without stepping through the
+ * ones before it, and there is no state to seed.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdint.h>
+
+#define PHILOX_N 4
+
+typedef struct {
+    uint32_t an[PHILOX_N];
+} philoxblock;
+
+typedef struct {
+    uint32_t an[2];
+} philoxkey;
+
+extern void philox4x32(const philoxblock * pCounter, const philoxkey * pKey, philoxblock * pResult);
+
+#endif
@@ -1378,7 +1378,7 @@ main(int argc, char **argv)
             }
         }
 
-        if (szOldBearoff && !(pbc = BearoffInit(szOldBearoff, BO_NONE, NULL))) {
+        if (szOldBearoff && !(pbc = BearoffInit(szOldBearoff, BO_NONE))) {
             g_printerr(_("Error initialising old bearoff database!\n"));
             exit(2);
         }
@@ -1430,7 +1430,7 @@ main(int argc, char **argv)
         g_printerr("%-37s: %12s %s\n", _("Reuse old bearoff database"), szOldBearoff ? _("yes") : _("no"),
                 szOldBearoff ? szOldBearoff : "");
         /* initialise old bearoff database */
-        if (szOldBearoff && !(pbc = BearoffInit(szOldBearoff, BO_NONE, NULL))) {
+        if (szOldBearoff && !(pbc = BearoffInit(szOldBearoff, BO_NONE))) {
             g_printerr(_("Error initialising old bearoff database!\n"));
             exit(2);
         }
@@ -22,6 +22,8 @@
 
 #include "config.h"
 #include "multithread.h"
+#include "mttrace.h"
+#include "numa.h"
 
 #include <stdlib.h>
 #if defined (DEBUG_MULTITHREADED)
@@ -49,6 +51,8 @@ MT_CreateThreadLocalData(int id)
     tld->pnnState[CLASS_CONTACT - CLASS_RACE].savedIBase = g_malloc0(nnContact.cInput * sizeof(float));
 
     tld->aMoves = (move *) g_malloc0(sizeof(move) * MAX_INCOMPLETE_MOVES);
+    tld->pes = EngineStatsSlot(id);
+    tld->pnnNode = fNuma ? NumaNets(NumaNodeOfThread(id)) : NULL;
     return tld;
 }
 
@@ -89,6 +93,16 @@ TLSSetValue(TLSItem pItem, size_t value)
     g_private_set(pItem, (gpointer) pNew);
 }
 
+/* Thread local data of the calling thread, or NULL for a thread that
+ * was not started by us (a Python thread, for instance) */
+extern ThreadLocalData *
+MT_TryGetTLD(void)
+{
+    size_t *p = (size_t *) g_private_get(td.tlsItem);
+
+    return p ? (ThreadLocalData *) *p : NULL;
+}
+
 extern void
 InitManualEvent(ManualEvent * pME)
 {
@@ -308,14 +322,18 @@ MT_Close(void)
 extern void
 MT_Exclusive(void)
 {
+    gint64 t = MTTraceNow();
+
     multi_debug("exclusive asks lock (multiLock)");
     Mutex_Lock(&td.multiLock);
     multi_debug("exclusive gets lock (multiLock)");
+    MTTraceLockWait(t);
 }
 
 extern void
 MT_Release(void)
 {
+    MTTraceLockRelease();
     Mutex_Release(&td.multiLock);
     multi_debug("release unlocks (multiLock)");
 }
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Thread pool tracing in Chrome trace-event format.
+ */
+
+#include "config.h"
+
+#if defined(USE_MULTITHREAD)
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "multithread.h"
+#include "mttrace.h"
+
+/* events beyond this are dropped, to bound memory on long rollouts */
+#define MTTRACE_MAX_EVENTS (1 << 20)
+
+typedef struct {
+    const char *szName;         /* static string */
+    gint64 ts;                  /* start, us */
+    gint64 dur;                 /* duration, us; -1 for an instant event */
+} traceevent;
+
+typedef struct {
+    GArray *pa;
+    gint64 tHold;               /* when MT_Exclusive() was acquired */
+    unsigned int cDropped;
+} traceslot;
+
+int fMTTrace = FALSE;
+
+static char *szTraceFile = NULL;
+static gint64 tBase;
+
+/* slot 0 is used by the main thread (id -1), slot n+1 by worker n and
+ * the last slot is shared by threads we did not create */
+#define FOREIGN_SLOT (MT_FOREIGN_THREAD_ID + 1)
+static traceslot ats[MAX_NUMTHREADS + 2];
+G_LOCK_DEFINE_STATIC(foreignslot);
+
+static traceslot *
+GetSlot(void)
+{
+    ThreadLocalData *ptld = MT_TryGetTLD();
+
+    return ptld ? &ats[ptld->id + 1] : &ats[FOREIGN_SLOT];
+}
+
+static void
+AddEvent(traceslot * pts, const char *szName, gint64 ts, gint64 dur)
+{
+    traceevent te;
+    int fForeign = pts == &ats[FOREIGN_SLOT];
+
+    /* each of our threads only touches its own slot, so only the
+     * shared foreign slot needs locking */
+    if (fForeign)
+        G_LOCK(foreignslot);
+
+    if (!pts->pa)
+        pts->pa = g_array_sized_new(FALSE, FALSE, sizeof(traceevent), 4096);
+
+    if (pts->pa->len >= MTTRACE_MAX_EVENTS)
+        pts->cDropped++;
+    else {
+        te.szName = szName;
+        te.ts = ts;
+        te.dur = dur;
+        g_array_append_val(pts->pa, te);
+    }
+
+    if (fForeign)
+        G_UNLOCK(foreignslot);
+}
+
+static void
+ResetSlots(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < G_N_ELEMENTS(ats); i++) {
+        if (ats[i].pa)
+            g_array_set_size(ats[i].pa, 0);
+        ats[i].cDropped = 0;
+    }
+    tBase = g_get_monotonic_time();
+}
+
+extern void
+MTTraceSetFile(const char *szFile)
+{
+    g_free(szTraceFile);
+    szTraceFile = (szFile && *szFile) ? g_strdup(szFile) : NULL;
+
+    ResetSlots();
+    fMTTrace = szTraceFile != NULL;
+}
+
+extern const char *
+MTTraceGetFile(void)
+{
+    return szTraceFile;
+}
+
+extern void
+MTTraceInstant(const char *szName)
+{
+    if (!fMTTrace)
+        return;
+
+    AddEvent(GetSlot(), szName, g_get_monotonic_time(), -1);
+}
+
+extern void
+MTTraceComplete(const char *szName, gint64 tStart)
+{
+    if (!fMTTrace || !tStart)
+        return;
+
+    AddEvent(GetSlot(), szName, tStart, g_get_monotonic_time() - tStart);
+}
+
+/* called with multiLock just acquired; tStart is when we asked for it */
+extern void
+MTTraceLockWait(gint64 tStart)
+{
+    traceslot *pts;
+    gint64 t;
+
+    if (!fMTTrace || !tStart)
+        return;
+
+    pts = GetSlot();
+    t = g_get_monotonic_time();
+    AddEvent(pts, "exclusive wait", tStart, t - tStart);
+    pts->tHold = t;
+}
+
+/* called just before multiLock is released */
+extern void
+MTTraceLockRelease(void)
+{
+    traceslot *pts;
+
+    if (!fMTTrace)
+        return;
+
+    pts = GetSlot();
+    if (pts->tHold) {
+        AddEvent(pts, "exclusive hold", pts->tHold, g_get_monotonic_time() - pts->tHold);
+        pts->tHold = 0;
+    }
+}
+
+/*
+ * Write the events recorded since the previous write to the trace
+ * file and start over. Must be called from the main thread while the
+ * workers are idle, i.e. after MT_WaitForTasks() has returned.
+ *
+ * Returns the number of events written, or -1 with errno set.
+ */
+
+extern int
+MTTraceWrite(const char *szWhat, unsigned int *pcDropped)
+{
+    FILE *pf;
+    unsigned int i, j;
+    unsigned int cEvents = 0, cDropped = 0;
+    const char *szSep = "";
+    int fOK;
+
+    if (!fMTTrace)
+        return 0;
+
+    if (!(pf = g_fopen(szTraceFile, "w")))
+        return -1;
+
+    fputs("{\"traceEvents\":[\n", pf);
+
+    for (i = 0; i < G_N_ELEMENTS(ats); i++) {
+        const traceslot *pts = &ats[i];
+
+        if (!pts->pa || !pts->pa->len)
+            continue;
+
+        if (i == 0)
+            fprintf(pf, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                    "\"args\":{\"name\":\"main\"}}", szSep);
+        else if (i == FOREIGN_SLOT)
+            fprintf(pf, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                    "\"args\":{\"name\":\"other threads\"}}", szSep, i);
+        else
+            fprintf(pf, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                    "\"args\":{\"name\":\"worker %u\"}}", szSep, i, i - 1);
+        szSep = ",\n";
+
+        for (j = 0; j < pts->pa->len; j++) {
+            const traceevent *pte = &g_array_index(pts->pa, traceevent, j);
+
+            if (pte->dur < 0)
+                fprintf(pf, ",\n{\"name\":\"%s\",\"cat\":\"mt\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"ts\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%u}", pte->szName, pte->ts - tBase, i);
+            else
+                fprintf(pf, ",\n{\"name\":\"%s\",\"cat\":\"mt\",\"ph\":\"X\","
+                        "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%u}",
+                        pte->szName, pte->ts - tBase, pte->dur, i);
+        }
+
+        cEvents += pts->pa->len;
+        cDropped += pts->cDropped;
+    }
+
+    fprintf(pf, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"operation\":\"%s\",\"dropped\":%u}}\n",
+            szWhat, cDropped);
+
+    fOK = !ferror(pf);
+    if (fclose(pf) || !fOK)
+        return -1;
+
+    ResetSlots();
+
+    if (pcDropped)
+        *pcDropped = cDropped;
+
+    return (int) cEvents;
+}
+
+#endif
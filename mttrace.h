@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MTTRACE_H
+#define MTTRACE_H
+
+#include <glib.h>
+
+/*
+ * Thread pool tracing.
+ *
+ * When a trace file is set, the thread pool records task enqueues,
+ * task execution, MT_Exclusive() waits and holds and MT_WaitForTasks()
+ * barriers in per-thread buffers. MT_WriteTrace() saves them as Chrome
+ * trace-event JSON, which can be loaded in Perfetto or chrome://tracing.
+ */
+
+#if defined(USE_MULTITHREAD)
+
+extern int fMTTrace;
+
+extern void MTTraceSetFile(const char *szFile);
+extern const char *MTTraceGetFile(void);
+extern void MTTraceInstant(const char *szName);
+extern void MTTraceComplete(const char *szName, gint64 tStart);
+extern void MTTraceLockWait(gint64 tStart);
+extern void MTTraceLockRelease(void);
+extern int MTTraceWrite(const char *szWhat, unsigned int *pcDropped);
+
+/* cheap when tracing is off: no clock read */
+#define MTTraceNow() (fMTTrace ? g_get_monotonic_time() : 0)
+
+#else
+
+#define MTTraceNow() 0
+#define MTTraceInstant(x)
+#define MTTraceComplete(x, t)
+#define MTTraceLockWait(t)
+#define MTTraceLockRelease()
+#define MTTraceWrite(x, p) 0
+
+#endif
+
+#endif
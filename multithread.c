@@ -30,6 +30,8 @@
 #endif
 
 #include "multithread.h"
+#include "mttrace.h"
+#include "numa.h"
 #include "rollout.h"
 #include "util.h"
 #include "drawboard.h" /*for FormatMove()*/
@@ -56,6 +58,7 @@ MT_CloseThreads(void)
         g_print(_("Error closing threads!\n"));
     for (i = 0; i < td.numThreads; i++)
         g_thread_join(thread[i]);
+    NumaStop();
 }
 
 static void
@@ -92,6 +95,25 @@ MT_GetTask(void)
     return task;
 }
 
+/* Can the calling thread queue tasks and wait for them? Only the main
+ * thread can, and only when no other operation is using the pool:
+ * waits don't nest and the task counters are shared. */
+extern int
+MT_PoolAvailable(void)
+{
+    ThreadLocalData *ptld = MT_TryGetTLD();
+    int fIdle;
+
+    if (!ptld || ptld->id != -1)
+        return FALSE;
+
+    Mutex_Lock(&td.queueLock);
+    fIdle = td.addedTasks == 0;
+    Mutex_Release(&td.queueLock);
+
+    return fIdle;
+}
+
 extern void
 MT_AbortTasks(void)
 {
@@ -104,7 +126,7 @@ MT_AbortTasks(void)
 }
 
 static SIMD_STACKALIGN gpointer
-MT_WorkerThreadFunction(void *tld)
+MT_WorkerThreadFunction(void *id)
 {
 #if 0
     /* why do we need this align ? - because of a gcc bug */
@@ -122,7 +144,14 @@ MT_WorkerThreadFunction(void *tld)
 
 #endif
     {
-        ThreadLocalData *pTLD = (ThreadLocalData *) tld;
+        ThreadLocalData *pTLD;
+
+        /* pin the thread before it allocates, so that its own data is
+         * placed on its node */
+        if (fNuma && NumaBindThread(GPOINTER_TO_INT(id)) != 0)
+            g_print(_("Failed to pin thread %d to its NUMA node\n"), GPOINTER_TO_INT(id));
+
+        pTLD = MT_CreateThreadLocalData(GPOINTER_TO_INT(id));
         TLSSetValue(td.tlsItem, (size_t) pTLD);
 
         MT_SafeInc(&td.result);
@@ -132,7 +161,10 @@ MT_WorkerThreadFunction(void *tld)
             WaitForManualEvent(td.activity);
             task = MT_GetTask();
             if (task) {
+                gint64 t = MTTraceNow();
+
                 task->fun(task->data);
+                MTTraceComplete("task", t);
                 MT_TaskDone(task);
             }
         } while (MT_SafeCompare(&td.closingThreads, FALSE));
@@ -167,13 +199,12 @@ MT_CreateThreads(void)
 #endif
     MT_SafeSet(&td.result, 0);
     MT_SafeSet(&td.closingThreads, FALSE);
+    NumaStart(td.numThreads);
     for (i = 0; i < td.numThreads; i++) {
-        ThreadLocalData *pTLD = MT_CreateThreadLocalData(i);
-
 #if GLIB_CHECK_VERSION (2,32,0)
-        if (!(thread[i] = g_thread_try_new(NULL, MT_WorkerThreadFunction, pTLD, NULL)))
+        if (!(thread[i] = g_thread_try_new(NULL, MT_WorkerThreadFunction, GINT_TO_POINTER(i), NULL)))
 #else
-        if (!(thread[i] = g_thread_create(MT_WorkerThreadFunction, pTLD, TRUE, NULL)))
+        if (!(thread[i] = g_thread_create(MT_WorkerThreadFunction, GINT_TO_POINTER(i), TRUE, NULL)))
 #endif
             printf(_("Failed to create thread\n"));
 #if defined(DEBUG_MULTITHREADED)
@@ -198,23 +229,21 @@ MT_SetNumThreads(unsigned int num)
             MT_CloseThreads();
         td.numThreads = num;
         MT_CreateThreads();
-        if (num == 1) {         /* No locking in evals */
-            EvaluatePosition = EvaluatePositionNoLocking;
-            GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
-            GeneralEvaluationE = GeneralEvaluationENoLocking;
-            ScoreMove = ScoreMoveNoLocking;
-            FindBestMove = FindBestMoveNoLocking;
-            FindnSaveBestMoves = FindnSaveBestMovesNoLocking;
-            BasicCubefulRollout = BasicCubefulRolloutNoLocking;
-        } else {                /* Locking version of evals */
-            EvaluatePosition = EvaluatePositionWithLocking;
-            GeneralCubeDecisionE = GeneralCubeDecisionEWithLocking;
-            GeneralEvaluationE = GeneralEvaluationEWithLocking;
-            ScoreMove = ScoreMoveWithLocking;
-            FindBestMove = FindBestMoveWithLocking;
-            FindnSaveBestMoves = FindnSaveBestMovesWithLocking;
-            BasicCubefulRollout = BasicCubefulRolloutWithLocking;
-        }
+        /* a single worker has the evaluation caches to itself */
+        EvalCacheSetShared(num > 1);
+    }
+}
+
+/* Turn NUMA placement on or off, recreating the threads to apply it */
+void
+MT_SetNuma(int f)
+{
+    if (f != fNuma) {
+        if (td.numThreads != 0)
+            MT_CloseThreads();
+        fNuma = f;
+        if (td.numThreads != 0)
+            MT_CreateThreads();
     }
 }
 
@@ -244,6 +273,7 @@ MT_AddTask(Task * pt, gboolean lock)
         MT_SafeSet(&td.result, 0);          /* Reset result for new tasks */
     td.addedTasks++;
     td.tasks = g_list_append(td.tasks, pt);
+    MTTraceInstant("enqueue");
     if (g_list_length(td.tasks) == 1) { /* New tasks */
         SetManualEvent(td.activity);
     }
@@ -315,6 +345,7 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     int start2 = 1;
     //int myPage;
     int i=0;
+    gint64 tWait = MTTraceNow();
 
     /* Set total tasks to wait for */
     td.totalTasks = td.addedTasks;
@@ -333,6 +364,7 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
             waits = 0;
             pCallback(NULL);
         }
+        EngineStatsLogTick();
         ProcessEvents();
         /* 
         VERSION 1: When analysis runs in the background:
@@ -429,6 +461,7 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
         save_autosave(NULL);
     }
     multi_debug("done waiting for all tasks");
+    MTTraceComplete("wait for tasks", tWait);
 
     MT_SafeSet(&td.doneTasks, 0);
     td.addedTasks = 0;
@@ -440,6 +473,26 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     return MT_SafeGet(&td.result);
 }
 
+/* Save the thread pool trace, if enabled, at the end of an operation */
+extern void
+MT_WriteTrace(const char *szWhat)
+{
+    unsigned int cDropped = 0;
+    int n;
+
+    if (!fMTTrace)
+        return;
+
+    if ((n = MTTraceWrite(szWhat, &cDropped)) < 0) {
+        outputerr(MTTraceGetFile());
+        return;
+    }
+
+    outputf(_("Thread trace of %s (%d events) written to %s\n"), szWhat, n, MTTraceGetFile());
+    if (cDropped)
+        outputf(_("%u events were dropped; the trace buffer is full.\n"), cDropped);
+}
+
 extern void
 MT_SetResultFailed(void)
 {
@@ -560,6 +613,7 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
         task->fun(task->data);
         g_free(task->pLinkedTask);
         g_free(task);
+        EngineStatsLogTick();
         ProcessEvents();
     }
     g_list_free(td.tasks);
@@ -577,6 +631,13 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
     return td.result;
 }
 
+extern int
+MT_PoolAvailable(void)
+{
+    /* tasks run in turn inside MT_WaitForTasks() */
+    return td.tasks == NULL;
+}
+
 extern void
 MT_AbortTasks(void)
 {
@@ -36,6 +36,7 @@
 #endif
 
 #include "backgammon.h"
+#include "enginestats.h"
 
 /* #define DEBUG_MULTITHREADED 1 */
 
@@ -63,6 +64,8 @@ typedef struct {
     int id;
     move *aMoves;
     NNState *pnnState;
+    enginestats *pes;
+    const neuralnet *pnnNode;   /* the nets of the thread's NUMA node, or NULL */
 } ThreadLocalData;
 
 typedef struct {
@@ -106,6 +109,7 @@ typedef struct {
 
 extern int MT_GetDoneTasks(void);
 extern void MT_AbortTasks(void);
+extern int MT_PoolAvailable(void);
 extern void MT_AddTask(Task * pt, gboolean lock);
 extern void mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked);
 extern int MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave);
@@ -136,21 +140,28 @@ extern void FreeMutex(Mutex * mutex);
 #define MAX_NUMTHREADS 48
 #endif
 
+/* id of the thread local data shared by threads we did not start */
+#define MT_FOREIGN_THREAD_ID MAX_NUMTHREADS
+
 extern void MT_Release(void);
 extern void MT_Exclusive(void);
 extern void MT_StartThreads(void);
 extern void MT_SetNumThreads(unsigned int num);
+extern void MT_SetNuma(int f);
 extern void MT_SyncInit(void);
 extern void MT_SyncStart(void);
 extern double MT_SyncEnd(void);
 extern void MT_SetResultFailed(void);
+extern void MT_WriteTrace(const char *szWhat);
 extern void TLSCreate(TLSItem * pItem);
 extern unsigned int MT_GetNumThreads(void);
+extern ThreadLocalData *MT_TryGetTLD(void);
 
 #define MT_GetTLD() ((ThreadLocalData *)TLSGet(td.tlsItem))
 #define MT_GetThreadID() ((ThreadLocalData *)TLSGet(td.tlsItem))->id
 #define MT_Get_nnState() ((ThreadLocalData *)TLSGet(td.tlsItem))->pnnState
 #define MT_Get_aMoves() ((ThreadLocalData *)TLSGet(td.tlsItem))->aMoves
+#define MT_Get_engineStats() ((ThreadLocalData *)TLSGet(td.tlsItem))->pes
 
 #if GLIB_CHECK_VERSION (2,30,0)
 #define MT_SafeIncValue(x) (g_atomic_int_add(x, 1) + 1)
@@ -180,6 +191,7 @@ extern int asyncRet;
 #define MT_Release() {}
 #define MT_GetNumThreads() 1
 #define MT_SetResultFailed() asyncRet = -1
+#define MT_WriteTrace(x)
 #define MT_SafeInc(x) (++(*x))
 #define MT_SafeIncValue(x) (++(*x))
 #define MT_SafeIncCheck(x) ((*x)++)
@@ -192,7 +204,9 @@ extern int asyncRet;
 #define MT_GetThreadID() 0
 #define MT_Get_nnState() td.tld->pnnState
 #define MT_Get_aMoves() td.tld->aMoves
+#define MT_Get_engineStats() td.tld->pes
 #define MT_GetTLD() td.tld
+#define MT_TryGetTLD() td.tld
 
 #endif
 
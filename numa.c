@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * NUMA placement of the calculation threads, see numa.h.
+ *
+ * No libnuma is needed: the nodes and their CPUs come from
+ * /sys/devices/system/node, threads are pinned with
+ * sched_setaffinity() and memory is placed with the mbind() system
+ * call.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "backgammon.h"
+#include "eval.h"
+#include "enginestats.h"
+#include "multithread.h"
+#include "numa.h"
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(CPU_SET)
+#define NUMA_LINUX 1
+
+/* from <numaif.h>, which is only installed with libnuma */
+#if !defined(MPOL_PREFERRED)
+#define MPOL_PREFERRED 1
+#endif
+#if !defined(MPOL_INTERLEAVE)
+#define MPOL_INTERLEAVE 3
+#endif
+#if !defined(MPOL_MF_MOVE)
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+#endif
+
+#define NODEMASK_LONGS (MAX_NUMA_NODES / (8 * sizeof(unsigned long)))
+
+int fNuma = FALSE;
+
+/* nodes with CPUs, in order of their kernel numbers; 0 until probed */
+static unsigned int cNodes = 0;
+static int anNodeId[MAX_NUMA_NODES];
+static char *aszNodeCPUs[MAX_NUMA_NODES];
+#if defined(NUMA_LINUX)
+static cpu_set_t acsNode[MAX_NUMA_NODES];
+#endif
+
+/* per node copies of the nets, valid while the threads run in NUMA mode */
+static unsigned int cReplicas = 0;
+static neuralnet aannNode[MAX_NUMA_NODES][NUMA_NETS];
+static void *apNodeBlock[MAX_NUMA_NODES];
+static size_t cbNodeBlock;
+
+/* evaluations per worker when the threads were placed */
+static guint64 acEvalStart[MAX_NUMTHREADS];
+static gint64 tStart;
+static unsigned int cStartThreads;
+
+#if defined(NUMA_LINUX)
+
+static int
+CompareInt(const void *p0, const void *p1)
+{
+    return *(const int *) p0 - *(const int *) p1;
+}
+
+/* Parse a cpulist such as "0-7,16-23"; returns the number of CPUs */
+static int
+ParseCPUList(const char *sz, cpu_set_t * pcs)
+{
+    int c = 0;
+
+    CPU_ZERO(pcs);
+
+    while (*sz) {
+        char *pch;
+        long i, n0, n1;
+
+        n0 = n1 = strtol(sz, &pch, 10);
+        if (pch == sz)
+            break;
+        if (*pch == '-')
+            n1 = strtol(pch + 1, &pch, 10);
+
+        for (i = n0; i <= n1 && i < CPU_SETSIZE; i++, c++)
+            CPU_SET(i, pcs);
+
+        sz = (*pch == ',') ? pch + 1 : pch;
+    }
+
+    return c;
+}
+
+static void
+NodeMask(unsigned long aul[NODEMASK_LONGS], unsigned int iNode, unsigned int cNode)
+{
+    unsigned int i;
+
+    memset(aul, 0, NODEMASK_LONGS * sizeof(unsigned long));
+
+    for (i = iNode; i < iNode + cNode; i++)
+        aul[anNodeId[i] / (8 * sizeof(unsigned long))] |= 1UL << (anNodeId[i] % (8 * sizeof(unsigned long)));
+}
+
+static long
+Mbind(void *p, size_t cb, int mode, const unsigned long aul[NODEMASK_LONGS], unsigned int flags)
+{
+    return syscall(SYS_mbind, p, cb, mode, aul, (unsigned long) MAX_NUMA_NODES + 1, flags);
+}
+
+#endif
+
+static void
+ProbeNodes(void)
+{
+#if defined(NUMA_LINUX)
+    const char *szDir = "/sys/devices/system/node";
+    GDir *pd;
+    const char *szName;
+    unsigned int i;
+
+    if (cNodes)
+        return;
+
+    if ((pd = g_dir_open(szDir, 0, NULL)) != NULL) {
+        while ((szName = g_dir_read_name(pd)) != NULL && cNodes < MAX_NUMA_NODES) {
+            int n;
+
+            if (sscanf(szName, "node%d", &n) == 1 && n >= 0 && n < MAX_NUMA_NODES)
+                anNodeId[cNodes++] = n;
+        }
+        g_dir_close(pd);
+    }
+
+    qsort(anNodeId, cNodes, sizeof(anNodeId[0]), CompareInt);
+
+    /* keep the nodes that have CPUs; memory only nodes get no threads */
+    for (i = 0; i < cNodes;) {
+        char *szFile = g_strdup_printf("%s/node%d/cpulist", szDir, anNodeId[i]);
+        char *sz = NULL;
+
+        if (g_file_get_contents(szFile, &sz, NULL, NULL) && ParseCPUList(g_strstrip(sz), &acsNode[i]) > 0) {
+            aszNodeCPUs[i] = sz;
+            i++;
+        } else {
+            g_free(sz);
+            memmove(anNodeId + i, anNodeId + i + 1, (cNodes - i - 1) * sizeof(anNodeId[0]));
+            cNodes--;
+        }
+        g_free(szFile);
+    }
+#endif
+
+    if (!cNodes) {
+        cNodes = 1;
+        anNodeId[0] = 0;
+        aszNodeCPUs[0] = NULL;
+    }
+}
+
+extern unsigned int
+NumaNodes(void)
+{
+    ProbeNodes();
+
+    return cNodes;
+}
+
+/* Workers are dealt out to the nodes in turn; the main thread (id -1)
+ * belongs to none. */
+extern int
+NumaNodeOfThread(int id)
+{
+    if (id < 0)
+        return -1;
+
+    return id % (int) NumaNodes();
+}
+
+/* Pin the calling thread, worker id, to the CPUs of its node */
+extern int
+NumaBindThread(int id)
+{
+#if defined(NUMA_LINUX)
+    int node = NumaNodeOfThread(id);
+
+    if (node < 0 || cNodes < 2)
+        return 0;
+
+    return sched_setaffinity(0, sizeof(cpu_set_t), &acsNode[node]);
+#else
+    (void) id;
+    return 0;
+#endif
+}
+
+extern const neuralnet *
+NumaNets(int node)
+{
+    if (node < 0 || (unsigned int) node >= cReplicas)
+        return NULL;
+
+    return aannNode[node];
+}
+
+/* Interleave the pages of p over all nodes, moving those already
+ * touched */
+extern void
+NumaInterleave(void *p, size_t cb)
+{
+#if defined(NUMA_LINUX)
+    unsigned long aul[NODEMASK_LONGS];
+    size_t cbPage = (size_t) sysconf(_SC_PAGESIZE);
+    char *pch = (char *) (((size_t) p + cbPage - 1) & ~(cbPage - 1));
+
+    if (!fNuma || NumaNodes() < 2 || !p || pch >= (char *) p + cb)
+        return;
+
+    cb = (((char *) p + cb) - pch) & ~(cbPage - 1);
+    NodeMask(aul, 0, cNodes);
+    (void) Mbind(pch, cb, MPOL_INTERLEAVE, aul, MPOL_MF_MOVE);
+#else
+    (void) p;
+    (void) cb;
+#endif
+}
+
+#if defined(NUMA_LINUX)
+
+static size_t
+NetSize(const neuralnet * pnn)
+{
+    size_t acb[4], cb = 0;
+    unsigned int i;
+
+    acb[0] = pnn->cInput * pnn->cHidden * sizeof(float);
+    acb[1] = pnn->cHidden * pnn->cOutput * sizeof(float);
+    acb[2] = pnn->cHidden * sizeof(float);
+    acb[3] = pnn->cOutput * sizeof(float);
+
+    for (i = 0; i < 4; i++)
+        cb += (acb[i] + NN_IMAGE_ALIGN - 1) & ~((size_t) NN_IMAGE_ALIGN - 1);
+
+    return cb;
+}
+
+/* Copy pnn into pch, which must hold NetSize(pnn) bytes; returns the
+ * end of the copy */
+static char *
+CopyNet(neuralnet * pnnCopy, const neuralnet * pnn, char *pch)
+{
+    float **aparCopy[4];
+    const float *apar[4];
+    size_t acb[4];
+    unsigned int i;
+
+    *pnnCopy = *pnn;
+    /* the arrays belong to the node's block, not to the net */
+    pnnCopy->fMapped = TRUE;
+
+    aparCopy[0] = &pnnCopy->arHiddenWeight;
+    aparCopy[1] = &pnnCopy->arOutputWeight;
+    aparCopy[2] = &pnnCopy->arHiddenThreshold;
+    aparCopy[3] = &pnnCopy->arOutputThreshold;
+    apar[0] = pnn->arHiddenWeight;
+    apar[1] = pnn->arOutputWeight;
+    apar[2] = pnn->arHiddenThreshold;
+    apar[3] = pnn->arOutputThreshold;
+    acb[0] = pnn->cInput * pnn->cHidden * sizeof(float);
+    acb[1] = pnn->cHidden * pnn->cOutput * sizeof(float);
+    acb[2] = pnn->cHidden * sizeof(float);
+    acb[3] = pnn->cOutput * sizeof(float);
+
+    for (i = 0; i < 4; i++) {
+        *aparCopy[i] = (float *) pch;
+        memcpy(pch, apar[i], acb[i]);
+        pch += (acb[i] + NN_IMAGE_ALIGN - 1) & ~((size_t) NN_IMAGE_ALIGN - 1);
+    }
+
+    return pch;
+}
+
+static void
+ReplicateNets(unsigned int cNode)
+{
+    const neuralnet *apnn[NUMA_NETS];
+    unsigned long aul[NODEMASK_LONGS];
+    unsigned int i, j;
+
+    apnn[NUMA_NET_CONTACT] = &nnContact;
+    apnn[NUMA_NET_RACE] = &nnRace;
+    apnn[NUMA_NET_CRASHED] = &nnCrashed;
+    apnn[NUMA_NET_PCONTACT] = &nnpContact;
+    apnn[NUMA_NET_PCRASHED] = &nnpCrashed;
+    apnn[NUMA_NET_PRACE] = &nnpRace;
+
+    for (cbNodeBlock = 0, j = 0; j < NUMA_NETS; j++)
+        cbNodeBlock += NetSize(apnn[j]);
+
+    for (i = 0; i < cNode; i++) {
+        char *pch = mmap(NULL, cbNodeBlock, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (pch == MAP_FAILED)
+            break;
+
+        /* set the policy before the copy touches the pages */
+        NodeMask(aul, i, 1);
+        (void) Mbind(pch, cbNodeBlock, MPOL_PREFERRED, aul, 0);
+
+        apNodeBlock[i] = pch;
+        for (j = 0; j < NUMA_NETS; j++)
+            pch = CopyNet(&aannNode[i][j], apnn[j], pch);
+    }
+
+    /* the nodes without a copy use the shared nets */
+    cReplicas = i;
+}
+
+#endif
+
+/* Prepare NUMA placement for cThreads workers; called before they
+ * are created */
+extern void
+NumaStart(unsigned int cThreads)
+{
+    unsigned int i;
+
+    NumaStop();
+
+    if (!fNuma || NumaNodes() < 2)
+        return;
+
+#if defined(NUMA_LINUX)
+    ReplicateNets(MIN(cNodes, cThreads));
+#endif
+
+    NumaInterleave(cEval.entries, (cEval.size / 2) * sizeof(cacheNode));
+    NumaInterleave(cpEval.entries, (cpEval.size / 2) * sizeof(cacheNode));
+
+    cStartThreads = MIN(cThreads, MAX_NUMTHREADS);
+    for (i = 0; i < cStartThreads; i++) {
+        const enginestats *pes = EngineStatsSlot((int) i);
+        unsigned int j;
+
+        for (acEvalStart[i] = 0, j = 0; j < N_CLASSES; j++)
+            acEvalStart[i] += pes->acEval[j];
+    }
+    tStart = g_get_monotonic_time();
+}
+
+/* Release the per node copies; the workers must have stopped */
+extern void
+NumaStop(void)
+{
+#if defined(NUMA_LINUX)
+    unsigned int i;
+
+    for (i = 0; i < cReplicas; i++)
+        munmap(apNodeBlock[i], cbNodeBlock);
+#endif
+
+    cReplicas = 0;
+    cStartThreads = 0;
+}
+
+/* A description of the nodes and the evaluations done on each since
+ * the threads were placed, to be freed with g_free() */
+extern char *
+NumaFormat(void)
+{
+    GString *gs = g_string_new(NULL);
+    unsigned int i, node;
+    double rSeconds = (double) (g_get_monotonic_time() - tStart) / 1e6;
+
+    if (!fNuma) {
+        g_string_append_printf(gs, _("NUMA mode is off (%u node(s) found).\n"), NumaNodes());
+        return g_string_free(gs, FALSE);
+    }
+
+    g_string_append(gs, _("NUMA mode is on.\n"));
+
+    if (NumaNodes() < 2) {
+        g_string_append(gs, _("Only one NUMA node was found; threads are not pinned.\n"));
+        return g_string_free(gs, FALSE);
+    }
+
+    g_string_append_printf(gs, _("The neural nets are %s.\n"), cReplicas ? _("copied to each node") : _("shared"));
+
+    for (node = 0; node < cNodes; node++) {
+        unsigned int cThreads = 0;
+        guint64 cEvals = 0;
+
+        for (i = node; i < cStartThreads; i += cNodes) {
+            const enginestats *pes = EngineStatsSlot((int) i);
+            guint64 c = 0;
+            unsigned int j;
+
+            for (j = 0; j < N_CLASSES; j++)
+                c += pes->acEval[j];
+
+            /* the counters may have been reset since */
+            cEvals += (c >= acEvalStart[i]) ? c - acEvalStart[i] : c;
+            cThreads++;
+        }
+
+        g_string_append_printf(gs, _("Node %d (CPUs %s): %u thread(s), %" G_GUINT64_FORMAT
+                                     " evaluations, %.0f evaluations/second\n"),
+                               anNodeId[node], aszNodeCPUs[node] ? aszNodeCPUs[node] : "?", cThreads, cEvals,
+                               rSeconds > 0.0 ? (double) cEvals / rSeconds : 0.0);
+    }
+
+    return g_string_free(gs, FALSE);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stddef.h>
+
+#include "lib/neuralnet.h"
+
+/*
+ * NUMA placement of the calculation threads.
+ *
+ * In NUMA mode the workers are spread round robin over the nodes and
+ * pinned to the CPUs of their node, each node gets its own copy of the
+ * neural nets, and the evaluation caches are interleaved over all
+ * nodes.  The topology is read from /sys, so this only does anything
+ * on Linux; elsewhere there is a single node and the mode is inert.
+ */
+
+#define MAX_NUMA_NODES 64
+
+/* the nets in a node's copy, in this order */
+enum {
+    NUMA_NET_CONTACT,
+    NUMA_NET_RACE,
+    NUMA_NET_CRASHED,
+    NUMA_NET_PCONTACT,
+    NUMA_NET_PCRASHED,
+    NUMA_NET_PRACE,
+    NUMA_NETS
+};
+
+extern int fNuma;
+
+extern unsigned int NumaNodes(void);
+extern int NumaNodeOfThread(int id);
+extern int NumaBindThread(int id);
+extern const neuralnet *NumaNets(int node);
+extern void NumaStart(unsigned int cThreads);
+extern void NumaStop(void);
+extern void NumaInterleave(void *p, size_t cb);
+extern char *NumaFormat(void);
+
+#endif
@@ -31,15 +31,35 @@
 #include "eval.h"
 #include "positionid.h"
 #include "SFMT.h"
+#include "multithread.h"
 #include "osr.h"
 
 #define MAX_PROBS        32
 #define MAX_GAMMON_PROBS 15
 
-static sfmt_t sfmt;
+/* Games are simulated in shards of OSR_SHARD games, each with its own
+ * random number generator seeded with the shard number.  The shards
+ * can then be played on any thread, in any order, and the result is
+ * the same.  The quasi-random first two rolls depend on the game
+ * number only, so they stay stratified whatever the shard size; 216
+ * splits the default of 1296 games in six. */
+#define OSR_SHARD 216
+
+/* recently computed one sided rollouts */
+#define OSR_CACHE_SIZE 1024
+
+typedef struct {
+    unsigned char auch[25];     /* the one sided position */
+    unsigned int nGames;        /* 0 if the entry is unused */
+    float arProbs[MAX_PROBS];
+    float arGammonProbs[MAX_GAMMON_PROBS];
+} osrcacheentry;
+
+static osrcacheentry aOSRCache[OSR_CACHE_SIZE];
 
 static void
-OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames, unsigned int anDice[2])
+OSRQuasiRandomDice(sfmt_t * psfmt, const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames,
+                   unsigned int anDice[2])
 {
     if (!iTurn && !(cGames % 36)) {
         anDice[0] = (iGame % 6) + 1;
@@ -48,8 +68,8 @@ OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const uns
         anDice[0] = ((iGame / 36) % 6) + 1;
         anDice[1] = ((iGame / 216) % 6) + 1;
     } else {
-        anDice[0] = (unsigned int) (sfmt_genrand_uint32(&sfmt) % 6) + 1;
-        anDice[1] = (unsigned int) (sfmt_genrand_uint32(&sfmt) % 6) + 1;
+        anDice[0] = (unsigned int) (sfmt_genrand_uint32(psfmt) % 6) + 1;
+        anDice[1] = (unsigned int) (sfmt_genrand_uint32(psfmt) % 6) + 1;
     }
 }
 
@@ -554,7 +574,7 @@ FindBestMoveOSR(unsigned int anBoard[25], const unsigned int anDice[2], unsigned
  */
 
 static unsigned int
-osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGames, unsigned int nOut)
+osr(sfmt_t * psfmt, unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGames, unsigned int nOut)
 {
     unsigned int iTurn = 0;
     unsigned int anDice[2];
@@ -563,7 +583,7 @@ osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGame
 
     while (nOut) {
         /* roll dice */
-        OSRQuasiRandomDice(iTurn, iGame, nGames, anDice);
+        OSRQuasiRandomDice(psfmt, iTurn, iGame, nGames, anDice);
 
         if (anDice[0] < anDice[1])
             swap_us(anDice, anDice + 1);
@@ -578,47 +598,39 @@ osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGame
 }
 
 
-/*
- * RollOSR: perform onesided rollout
- *
- * Input:
- *   nGames: number of simulations
- *   anBoard: the board 
- *   nOut: number of chequers outside home quadrant
- *
- * Output:
- *   arProbs[ nMaxProbs ]: probabilities
- *   arGammonProbs[ nMaxGammonProbs ]: gammon probabilities
- *
- */
+typedef struct {
+    const unsigned int *anBoard;
+    unsigned int nGames;
+    unsigned int nOut;
+    unsigned int cShards;
+    int iNext;                  /* next shard to play */
+    float (*aarProbs)[MAX_PROBS];       /* results of each shard */
+    unsigned int (*aanCounts)[MAX_GAMMON_PROBS];
+} osrshards;
 
 static void
-rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigned int nOut,
-        float arProbs[], const unsigned int nMaxProbs, float arGammonProbs[], const unsigned int nMaxGammonProbs)
+rollOSRShard(const osrshards * pos, const unsigned int iShard)
 {
-
     unsigned int an[25];
     unsigned short int anProb[32];
     unsigned int i;
-    unsigned int iGame;
-
-    int *anCounts = (int *) g_alloca(nMaxGammonProbs * sizeof(int));
+    unsigned int iGame, iEnd = MIN((iShard + 1) * OSR_SHARD, pos->nGames);
+    float *arProbs = pos->aarProbs[iShard];
+    unsigned int *anCounts = pos->aanCounts[iShard];
+    sfmt_t sfmt;
 
-    memset(anCounts, 0, sizeof(int) * nMaxGammonProbs);
-
-    for (i = 0; i < nMaxProbs; ++i)
-        arProbs[i] = 0.0f;
+    /* seeded to ensure that OSR are reproducible */
 
-    /* perform rollouts */
+    sfmt_init_gen_rand(&sfmt, iShard);
 
-    for (iGame = 0; iGame < nGames; ++iGame) {
+    for (iGame = iShard * OSR_SHARD; iGame < iEnd; ++iGame) {
         unsigned int n, m;
 
-        memcpy(an, anBoard, sizeof(an));
+        memcpy(an, pos->anBoard, sizeof(an));
 
         /* do actual rollout */
 
-        n = osr(an, iGame, nGames, nOut);
+        n = osr(&sfmt, an, iGame, pos->nGames, pos->nOut);
 
         /* number of chequers in home quadrant */
 
@@ -628,32 +640,123 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
 
         /* update counts */
 
-        ++anCounts[MIN(m == 15 ? n + 1 : n, nMaxGammonProbs - 1)];
+        ++anCounts[MIN(m == 15 ? n + 1 : n, MAX_GAMMON_PROBS - 1)];
 
         /* get prob. from bearoff1 */
 
         getBearoffProbs(PositionBearoff(an, pbc1->nPoints, pbc1->nChequers), anProb);
 
         for (i = 0; i < 32; ++i)
-            arProbs[MIN(n + i, nMaxProbs - 1)] += anProb[i] / 65535.0f;
+            arProbs[MIN(n + i, MAX_PROBS - 1)] += anProb[i] / 65535.0f;
+
+    }
+}
+
+static void
+rollOSRShards(osrshards * pos)
+{
+    unsigned int iShard;
+
+    while ((iShard = (unsigned int) MT_SafeIncValue(&pos->iNext) - 1) < pos->cShards)
+        rollOSRShard(pos, iShard);
+}
+
+static unsigned int
+OSRCacheHash(const unsigned char auch[25], const unsigned int nGames)
+{
+    unsigned int i, h = 2166136261u ^ nGames;
 
+    for (i = 0; i < 25; ++i)
+        h = (h ^ auch[i]) * 16777619u;
+
+    return h % OSR_CACHE_SIZE;
+}
+
+/*
+ * RollOSR: perform onesided rollout
+ *
+ * Input:
+ *   nGames: number of simulations
+ *   anBoard: the board 
+ *   nOut: number of chequers outside home quadrant
+ *
+ * Output:
+ *   arProbs[ MAX_PROBS ]: probabilities
+ *   arGammonProbs[ MAX_GAMMON_PROBS ]: gammon probabilities
+ *
+ * The shards are spread over the worker threads when called from the
+ * main thread while the pool is idle, and played in turn on the
+ * calling thread otherwise (from a task, from background analysis or
+ * while another operation is waiting for the pool).
+ */
+
+static void
+rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigned int nOut,
+        float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
+{
+    osrshards os;
+    unsigned int anCounts[MAX_GAMMON_PROBS];
+    unsigned char auch[25];
+    unsigned int i, j, h;
+
+    for (i = 0; i < 25; ++i)
+        auch[i] = (unsigned char) anBoard[i];
+
+    h = OSRCacheHash(auch, nGames);
+
+    MT_Exclusive();
+    if (aOSRCache[h].nGames == nGames && !memcmp(aOSRCache[h].auch, auch, sizeof(auch))) {
+        memcpy(arProbs, aOSRCache[h].arProbs, sizeof(aOSRCache[h].arProbs));
+        memcpy(arGammonProbs, aOSRCache[h].arGammonProbs, sizeof(aOSRCache[h].arGammonProbs));
+        MT_Release();
+        return;
     }
+    MT_Release();
+
+    os.anBoard = anBoard;
+    os.nGames = nGames;
+    os.nOut = nOut;
+    os.cShards = (nGames + OSR_SHARD - 1) / OSR_SHARD;
+    os.iNext = 0;
+    os.aarProbs = g_malloc0(os.cShards * sizeof(*os.aarProbs));
+    os.aanCounts = g_malloc0(os.cShards * sizeof(*os.aanCounts));
 
-    /* scale resulting probabilities */
+    if (os.cShards > 1 && MT_GetNumThreads() > 1 && MT_PoolAvailable()) {
+        mt_add_tasks(MIN(MT_GetNumThreads(), os.cShards), (AsyncFun) rollOSRShards, &os, NULL);
+        MT_WaitForTasks(NULL, 10, FALSE);
+    } else
+        rollOSRShards(&os);
 
-    for (i = 0; i < (unsigned int) nMaxProbs; ++i) {
-        arProbs[i] /= (float)nGames;
-        /* printf ( "arProbs[%d]=%f\n", i, arProbs[ i ] ); */
+    /* add up the shards in order, so that the sums don't depend on
+     * which thread finished first, and scale */
+
+    memset(anCounts, 0, sizeof(anCounts));
+
+    for (i = 0; i < MAX_PROBS; ++i) {
+        arProbs[i] = 0.0f;
+        for (j = 0; j < os.cShards; ++j)
+            arProbs[i] += os.aarProbs[j][i];
+        arProbs[i] /= (float) nGames;
     }
 
     /* calculate gammon probs. 
      * (prob. of getting inside home quadrant in i rolls */
 
-    for (i = 0; i < nMaxGammonProbs; ++i) {
-        arGammonProbs[i] = (float)anCounts[i] / (float)nGames;
-        /* printf ( "arGammonProbs[%d]=%f\n", i, arGammonProbs[ i ] ); */
+    for (i = 0; i < MAX_GAMMON_PROBS; ++i) {
+        for (j = 0; j < os.cShards; ++j)
+            anCounts[i] += os.aanCounts[j][i];
+        arGammonProbs[i] = (float) anCounts[i] / (float) nGames;
     }
 
+    g_free(os.aarProbs);
+    g_free(os.aanCounts);
+
+    MT_Exclusive();
+    memcpy(aOSRCache[h].auch, auch, sizeof(auch));
+    aOSRCache[h].nGames = nGames;
+    memcpy(aOSRCache[h].arProbs, arProbs, sizeof(aOSRCache[h].arProbs));
+    memcpy(aOSRCache[h].arGammonProbs, arGammonProbs, sizeof(aOSRCache[h].arGammonProbs));
+    MT_Release();
 }
 
 
@@ -698,7 +801,7 @@ osp(const unsigned int anBoard[25], const unsigned int nGames,
 
     if (nOut > 0)
         /* chequers outside home: do one sided rollout */
-        rollOSR(nGames, an, nOut, arProbs, MAX_PROBS, arGammonProbs, MAX_GAMMON_PROBS);
+        rollOSR(nGames, an, nOut, arProbs, arGammonProbs);
     else {
         /* chequers inside home: use BEAROFF2 */
 
@@ -819,10 +922,6 @@ raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_
 
     float w, s;
 
-    /* Seed set to ensure that OSR are reproducible */
-
-    sfmt_init_gen_rand(&sfmt, 0);
-
     for (i = 0; i < NUM_OUTPUTS; ++i)
         arOutput[i] = 0.0f;
 
@@ -2847,6 +2847,7 @@ FreeMatch(void)
 {
     PopGame(lMatch.plNext->p, TRUE);
     IniStatcontext(&scMatch);
+    ClearRolloutContexts();
 }
 
 extern void
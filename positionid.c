@@ -125,6 +125,21 @@ PositionFromKeySwapped(TanBoard anBoard, const positionkey * pkey)
     anBoard[0][24] = (anpBoard[6] >> 4) & 0x0f;
 }
 
+/* The key of the position with the sides swapped, without decoding it:
+ * the two halves of the key change places and so do the two bars. */
+
+extern void
+PositionKeySwapped(const positionkey * pkey, positionkey * pkeySwapped)
+{
+    unsigned int i;
+
+    for (i = 0; i < 3; i++) {
+        pkeySwapped->data[i] = pkey->data[i + 3];
+        pkeySwapped->data[i + 3] = pkey->data[i];
+    }
+    pkeySwapped->data[6] = ((pkey->data[6] & 0x0f) << 4) | ((pkey->data[6] >> 4) & 0x0f);
+}
+
 static inline void
 addBits(unsigned char auchKey[10], unsigned int bitPos, unsigned int nBits)
 {
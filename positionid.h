@@ -36,6 +36,7 @@ unsigned int PositionBearoff(const unsigned int anBoard[], unsigned int nPoints,
 
 extern void PositionFromKey(TanBoard anBoard, const positionkey * pkey);
 extern void PositionFromKeySwapped(TanBoard anBoard, const positionkey * pkey);
+extern void PositionKeySwapped(const positionkey * pkey, positionkey * pkeySwapped);
 
 /* Return 1 for success, 0 for invalid id */
 extern int PositionFromID(TanBoard anBoard, const char *szID);
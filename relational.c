@@ -151,28 +151,47 @@ MatchResult(int nMatchTo)
 }
 
 #define NS(x) (x == NULL) ? "NULL" : x
-#define APPENDF(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%s', ", g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, y));}
-#define APPENDI(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%i', ", y);}
-#define APPENDU(x,y) {g_string_append_printf(column, "%s, ", x); \
-        g_string_append_printf(value, "'%u', ", y);}
 
-static int
-AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *table, int nMatchTo, statcontext * sc)
+/* One matchstat or gamestat row. The columns are the same for every
+ * row, whatever the statistics available, so that the row can be bound
+ * to a single prepared statement. */
+#define MAX_STAT_COLUMNS 96
+
+typedef struct {
+    int c;
+    const char *aszColumn[MAX_STAT_COLUMNS];
+    DBValue av[MAX_STAT_COLUMNS];
+} statrow;
+
+static DBValue *
+AppendColumn(statrow * psr, const char *szColumn, DBValueType type)
+{
+    DBValue *pv;
+
+    g_assert(psr->c < MAX_STAT_COLUMNS);
+
+    psr->aszColumn[psr->c] = szColumn;
+    pv = &psr->av[psr->c++];
+    pv->type = type;
+    return pv;
+}
+
+#define APPENDF(x,y) AppendColumn(psr, x, DBVAL_DOUBLE)->v.d = (double) (y)
+#define APPENDI(x,y) AppendColumn(psr, x, DBVAL_INT)->v.i = (int) (y)
+#define APPENDU(x,y) APPENDI(x, y)
+#define APPENDNULL(x) AppendColumn(psr, x, DBVAL_NULL)
+
+static void
+FillStats(statrow * psr, int gms_id, int gm_id, int player_id, int player, const char *table, int nMatchTo,
+          const statcontext * sc)
 {
-    gchar *buf;
-    GString *column, *value;
     int totalmoves, unforced;
     float errorcost, errorskill;
     float aaaar[3][2][2][2];
     float r;
-    int ret;
-    char tmpf[G_ASCII_DTOSTR_BUF_SIZE];
+    int fRating;
 
-    int gms_id = GetNextId(pdb, table);
-    if (gms_id == -1)
-        return FALSE;
+    psr->c = 0;
 
     totalmoves = sc->anTotalMoves[player];
     unforced = sc->anUnforcedMoves[player];
@@ -181,10 +200,6 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
     errorskill = aaaar[CUBEDECISION][PERMOVE][player][NORMALISED];
     errorcost = aaaar[CUBEDECISION][PERMOVE][player][UNNORMALISED];
 
-    column = g_string_new(NULL);
-    value = g_string_new(NULL);
-
-
     if (strcmp("matchstat", table) == 0) {
         APPENDI("matchstat_id", gms_id);
         APPENDI("session_id", gm_id);
@@ -270,19 +285,28 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
     r = 0.5f + scMatch.arActualResult[player] - scMatch.arLuck[player][1] + scMatch.arLuck[!player][1];
     if (nMatchTo && r > 0.0f && r < 1.0f)
         APPENDF("luck_based_fibs_rating_diff", relativeFibsRating(r, nMatchTo));
-    if (nMatchTo && (scMatch.fCube || scMatch.fMoves)) {
+    else
+        APPENDNULL("luck_based_fibs_rating_diff");
+
+    fRating = nMatchTo && (scMatch.fCube || scMatch.fMoves);
+    if (fRating)
         APPENDF("error_based_fibs_rating", absoluteFibsRating(aaaar[CHEQUERPLAY][PERMOVE]
                                                               [player][NORMALISED], aaaar[CUBEDECISION][PERMOVE]
                                                               [player][NORMALISED], nMatchTo, rRatingOffset));
-        if (scMatch.anUnforcedMoves[player])
-            APPENDF("chequer_rating_loss", absoluteFibsRatingChequer(aaaar[CHEQUERPLAY]
-                                                                     [PERMOVE][player]
-                                                                     [NORMALISED], nMatchTo));
-        if (scMatch.anCloseCube[player])
-            APPENDF("cube_rating_loss", absoluteFibsRatingCube(aaaar[CUBEDECISION]
-                                                               [PERMOVE][player]
-                                                               [NORMALISED], nMatchTo));
-    }
+    else
+        APPENDNULL("error_based_fibs_rating");
+    if (fRating && scMatch.anUnforcedMoves[player])
+        APPENDF("chequer_rating_loss", absoluteFibsRatingChequer(aaaar[CHEQUERPLAY]
+                                                                 [PERMOVE][player]
+                                                                 [NORMALISED], nMatchTo));
+    else
+        APPENDNULL("chequer_rating_loss");
+    if (fRating && scMatch.anCloseCube[player])
+        APPENDF("cube_rating_loss", absoluteFibsRatingCube(aaaar[CUBEDECISION]
+                                                           [PERMOVE][player]
+                                                           [NORMALISED], nMatchTo));
+    else
+        APPENDNULL("cube_rating_loss");
 
     /* for money sessions only */
     if (scMatch.fDice && !nMatchTo && scMatch.nGames > 1) {
@@ -291,6 +315,42 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
         APPENDF("actual_advantage_ci", 1.95996f * sqrtf(scMatch.arVarianceActual[player] / (float) scMatch.nGames));
         APPENDF("luck_adjusted_advantage", scMatch.arLuckAdj[player] / (float) scMatch.nGames);
         APPENDF("luck_adjusted_advantage_ci", 1.95996f * sqrtf(scMatch.arVarianceLuckAdj[player] / (float) scMatch.nGames));
+    } else {
+        APPENDNULL("actual_advantage");
+        APPENDNULL("actual_advantage_ci");
+        APPENDNULL("luck_adjusted_advantage");
+        APPENDNULL("luck_adjusted_advantage_ci");
+    }
+}
+
+static int
+AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *table, int nMatchTo, statcontext * sc)
+{
+    gchar *buf;
+    GString *column, *value;
+    statrow sr;
+    int i, ret;
+    char tmpf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    int gms_id = GetNextId(pdb, table);
+    if (gms_id == -1)
+        return FALSE;
+
+    FillStats(&sr, gms_id, gm_id, player_id, player, table, nMatchTo, sc);
+
+    column = g_string_new(NULL);
+    value = g_string_new(NULL);
+
+    for (i = 0; i < sr.c; i++) {
+        const DBValue *pv = &sr.av[i];
+
+        g_string_append_printf(column, "%s, ", sr.aszColumn[i]);
+        if (pv->type == DBVAL_NULL)
+            g_string_append(value, "NULL, ");
+        else if (pv->type == DBVAL_INT)
+            g_string_append_printf(value, "'%i', ", pv->v.i);
+        else
+            g_string_append_printf(value, "'%s', ", g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, pv->v.d));
     }
 
     g_string_truncate(column, column->len - 2);
@@ -517,6 +577,479 @@ CommandRelationalAddMatch(char *sz)
     pdb->Disconnect();
 }
 
+/*
+ * Bulk loading: a directory of matches is added in a few large
+ * transactions through prepared statements. Player ids and the
+ * checksums of the matches already stored are read once, and ids are
+ * handed out locally and written back to the control table when each
+ * batch is committed, instead of a round trip per row.
+ */
+
+typedef enum {
+    BULK_PLAYER,
+    BULK_SESSION,
+    BULK_MATCHSTAT,
+    BULK_GAME,
+    BULK_GAMESTAT,
+    NUM_BULK_TABLES
+} bulktable;
+
+/* in dependency order, which is also the order statements are finalised in */
+static const char *aszBulkTable[NUM_BULK_TABLES] = { "player", "session", "matchstat", "game", "gamestat" };
+
+typedef struct {
+    DBProvider *pdb;
+    GHashTable *phPlayer;       /* name -> player id */
+    GHashTable *phChecksum;     /* checksums of the sessions in the database */
+    int anLastId[NUM_BULK_TABLES];      /* last id handed out */
+    int anStoredId[NUM_BULK_TABLES];    /* next_id in the control table, -1 if no row */
+    void *apStmt[NUM_BULK_TABLES];
+} bulkload;
+
+static void
+BulkLoadInit(bulkload * pbl, DBProvider * pdb)
+{
+    RowSet *rs;
+    size_t i;
+    int t;
+
+    memset(pbl, 0, sizeof(bulkload));
+    pbl->pdb = pdb;
+    pbl->phPlayer = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    pbl->phChecksum = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    for (t = 0; t < NUM_BULK_TABLES; t++) {
+        char *buf = g_strdup_printf("next_id FROM control WHERE tablename = '%s'", aszBulkTable[t]);
+        pbl->anStoredId[t] = RunQueryValue(pdb, buf);
+        pbl->anLastId[t] = MAX(pbl->anStoredId[t], 0);
+        g_free(buf);
+    }
+
+    /* the first row of a rowset holds the column names */
+    if ((rs = pdb->Select("player_id, name FROM player")) != NULL) {
+        for (i = 1; i < rs->rows; i++)
+            g_hash_table_insert(pbl->phPlayer, g_strdup(rs->data[i][1]),
+                                GINT_TO_POINTER((int) strtol(rs->data[i][0], NULL, 0)));
+        FreeRowset(rs);
+    }
+
+    if ((rs = pdb->Select("checksum FROM session")) != NULL) {
+        for (i = 1; i < rs->rows; i++)
+            g_hash_table_insert(pbl->phChecksum, g_strdup(rs->data[i][0]), GINT_TO_POINTER(1));
+        FreeRowset(rs);
+    }
+}
+
+static void
+BulkLoadFree(bulkload * pbl)
+{
+    g_hash_table_destroy(pbl->phPlayer);
+    g_hash_table_destroy(pbl->phChecksum);
+}
+
+static void *
+BulkStatement(bulkload * pbl, bulktable t, const statrow * psr)
+{
+    GString *column, *value;
+    int i;
+
+    if (pbl->apStmt[t])
+        return pbl->apStmt[t];
+
+    switch (t) {
+    case BULK_PLAYER:
+        pbl->apStmt[t] = pbl->pdb->Prepare("INSERT INTO player(player_id,name,notes) VALUES (?, ?, '')");
+        break;
+
+    case BULK_SESSION:
+        pbl->apStmt[t] = pbl->pdb->Prepare("INSERT INTO session(session_id, checksum, player_id0, player_id1, "
+                                           "result, length, added, rating0, rating1, event, round, place, "
+                                           "annotator, comment, date) "
+                                           "VALUES (?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP, ?, ?, ?, ?, ?, ?, ?, ?)");
+        break;
+
+    case BULK_GAME:
+        pbl->apStmt[t] = pbl->pdb->Prepare("INSERT INTO game(game_id, session_id, player_id0, player_id1, "
+                                           "score_0, score_1, result, added, game_number, crawford) "
+                                           "VALUES (?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP, ?, ?)");
+        break;
+
+    case BULK_MATCHSTAT:
+    case BULK_GAMESTAT:
+        g_assert(psr);
+        column = g_string_new(NULL);
+        value = g_string_new(NULL);
+        for (i = 0; i < psr->c; i++) {
+            g_string_append_printf(column, i ? ", %s" : "%s", psr->aszColumn[i]);
+            g_string_append(value, i ? ", ?" : "?");
+        }
+        {
+            char *buf = g_strdup_printf("INSERT INTO %s (%s) VALUES(%s)", aszBulkTable[t], column->str, value->str);
+            pbl->apStmt[t] = pbl->pdb->Prepare(buf);
+            g_free(buf);
+        }
+        g_string_free(column, TRUE);
+        g_string_free(value, TRUE);
+        break;
+
+    default:
+        g_assert_not_reached();
+    }
+
+    return pbl->apStmt[t];
+}
+
+static int
+BulkInsert(bulkload * pbl, bulktable t, const statrow * psr, const DBValue * av, int cValues)
+{
+    void *stmt = BulkStatement(pbl, t, psr);
+
+    if (!stmt)
+        return FALSE;
+
+    return psr ? pbl->pdb->Execute(stmt, psr->av, psr->c) : pbl->pdb->Execute(stmt, av, cValues);
+}
+
+static void
+SetInt(DBValue * pv, int n)
+{
+    pv->type = DBVAL_INT;
+    pv->v.i = n;
+}
+
+static void
+SetText(DBValue * pv, const char *sz)
+{
+    pv->type = DBVAL_TEXT;
+    pv->v.sz = sz;
+}
+
+/* Look up or add a player; names added are prepended to *pplAdded so
+ * that they can be forgotten again if the match is rolled back */
+static int
+BulkAddPlayer(bulkload * pbl, const char *name, GSList ** pplAdded)
+{
+    gpointer p;
+    DBValue av[2];
+    int id;
+
+    if (g_hash_table_lookup_extended(pbl->phPlayer, name, NULL, &p))
+        return GPOINTER_TO_INT(p);
+
+    id = ++pbl->anLastId[BULK_PLAYER];
+    SetInt(&av[0], id);
+    SetText(&av[1], name);
+    if (!BulkInsert(pbl, BULK_PLAYER, NULL, av, 2))
+        return -1;
+
+    g_hash_table_insert(pbl->phPlayer, g_strdup(name), GINT_TO_POINTER(id));
+    *pplAdded = g_slist_prepend(*pplAdded, g_strdup(name));
+    return id;
+}
+
+static int
+BulkAddStats(bulkload * pbl, bulktable t, int gm_id, int player_id, int player, statcontext * sc)
+{
+    statrow sr;
+
+    FillStats(&sr, ++pbl->anLastId[t], gm_id, player_id, player, aszBulkTable[t], ms.nMatchTo, sc);
+    return BulkInsert(pbl, t, &sr, NULL, 0);
+}
+
+static int
+BulkAddGames(bulkload * pbl, int session_id, int player_id0, int player_id1)
+{
+    int gamenum = 0;
+    listOLD *plg, *pl;
+
+    for (pl = lMatch.plNext; (plg = pl->p) != NULL; pl = pl->plNext) {
+        moverecord *pmr = plg->plNext->p;
+        xmovegameinfo *pmgi = &pmr->g;
+        int game_id = ++pbl->anLastId[BULK_GAME];
+        DBValue av[9];
+        int result = 0;
+
+        if (pmgi->fWinner == 0)
+            result = pmgi->nPoints;
+        else if (pmgi->fWinner == 1)
+            result = -pmgi->nPoints;
+
+        SetInt(&av[0], game_id);
+        SetInt(&av[1], session_id);
+        SetInt(&av[2], player_id0);
+        SetInt(&av[3], player_id1);
+        SetInt(&av[4], pmgi->anScore[0]);
+        SetInt(&av[5], pmgi->anScore[1]);
+        SetInt(&av[6], result);
+        SetInt(&av[7], ++gamenum);
+        SetInt(&av[8], pmgi->fCrawfordGame);
+
+        if (!BulkInsert(pbl, BULK_GAME, NULL, av, 9) ||
+            !BulkAddStats(pbl, BULK_GAMESTAT, game_id, player_id0, 0, &pmgi->sc) ||
+            !BulkAddStats(pbl, BULK_GAMESTAT, game_id, player_id1, 1, &pmgi->sc))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Add the current match. Returns 1 if added, 0 if already in the database, -1 on error.
+ * Each match is added inside a savepoint so that a failure part way
+ * through leaves neither rows nor used ids behind in the batch. */
+static int
+BulkAddMatch(bulkload * pbl)
+{
+    const char *szChecksum = GetMatchCheckSum();
+    int session_id, player_id0, player_id1;
+    int anLastId[NUM_BULK_TABLES], acBuffered[NUM_BULK_TABLES];
+    GSList *plAdded = NULL, *pl;
+    char *date;
+    DBValue av[14];
+    int ok, t;
+
+    if (g_hash_table_lookup(pbl->phChecksum, szChecksum))
+        return 0;
+
+    if (!pbl->pdb->UpdateCommand("SAVEPOINT bulk_match"))
+        return -1;
+    memcpy(anLastId, pbl->anLastId, sizeof(anLastId));
+    for (t = 0; t < NUM_BULK_TABLES; t++)
+        acBuffered[t] = pbl->apStmt[t] && pbl->pdb->Buffered ? pbl->pdb->Buffered(pbl->apStmt[t]) : 0;
+
+    player_id0 = BulkAddPlayer(pbl, ap[0].szName, &plAdded);
+    player_id1 = player_id0 == -1 ? -1 : BulkAddPlayer(pbl, ap[1].szName, &plAdded);
+    if (player_id1 == -1) {
+        ok = FALSE;
+        goto done;
+    }
+
+    session_id = ++pbl->anLastId[BULK_SESSION];
+
+    if (mi.nYear)
+        date = g_strdup_printf("%04u-%02u-%02u", mi.nYear, mi.nMonth, mi.nDay);
+    else
+        date = NULL;
+
+    updateStatisticsMatch(&lMatch);
+
+    SetInt(&av[0], session_id);
+    SetText(&av[1], szChecksum);
+    SetInt(&av[2], player_id0);
+    SetInt(&av[3], player_id1);
+    SetInt(&av[4], MatchResult(ms.nMatchTo));
+    SetInt(&av[5], ms.nMatchTo);
+    SetText(&av[6], NS(mi.pchRating[0]));
+    SetText(&av[7], NS(mi.pchRating[1]));
+    SetText(&av[8], NS(mi.pchEvent));
+    SetText(&av[9], NS(mi.pchRound));
+    SetText(&av[10], NS(mi.pchPlace));
+    SetText(&av[11], NS(mi.pchAnnotator));
+    SetText(&av[12], NS(mi.pchComment));
+    SetText(&av[13], NS(date));
+
+    ok = BulkInsert(pbl, BULK_SESSION, NULL, av, 14) &&
+        BulkAddStats(pbl, BULK_MATCHSTAT, session_id, player_id0, 0, &scMatch) &&
+        BulkAddStats(pbl, BULK_MATCHSTAT, session_id, player_id1, 1, &scMatch) &&
+        (!storeGameStats || BulkAddGames(pbl, session_id, player_id0, player_id1));
+    g_free(date);
+
+  done:
+    if (ok) {
+        pbl->pdb->UpdateCommand("RELEASE SAVEPOINT bulk_match");
+        g_hash_table_insert(pbl->phChecksum, g_strdup(szChecksum), GINT_TO_POINTER(1));
+    } else {
+        pbl->pdb->UpdateCommand("ROLLBACK TO SAVEPOINT bulk_match");
+        pbl->pdb->UpdateCommand("RELEASE SAVEPOINT bulk_match");
+        /* rows the provider has not sent yet are not covered by the
+         * savepoint */
+        for (t = 0; t < NUM_BULK_TABLES; t++)
+            if (pbl->apStmt[t] && pbl->pdb->Truncate)
+                pbl->pdb->Truncate(pbl->apStmt[t], acBuffered[t]);
+        memcpy(pbl->anLastId, anLastId, sizeof(anLastId));
+        for (pl = plAdded; pl; pl = pl->next)
+            g_hash_table_remove(pbl->phPlayer, pl->data);
+    }
+    g_slist_free_full(plAdded, g_free);
+
+    return ok ? 1 : -1;
+}
+
+/* Finalise the pending statements, store the ids used and commit.  If
+ * any rows could not be written, roll the batch back instead and reread
+ * what is in the database. */
+static int
+BulkCommit(bulkload * pbl)
+{
+    int t, ok = TRUE;
+
+    for (t = 0; t < NUM_BULK_TABLES; t++)
+        if (pbl->apStmt[t]) {
+            if (!pbl->pdb->Finalize(pbl->apStmt[t]))
+                ok = FALSE;
+            pbl->apStmt[t] = NULL;
+        }
+
+    if (!ok) {
+        DBProvider *pdb = pbl->pdb;
+
+        /* the players, sessions and ids of the batch are gone again */
+        pdb->UpdateCommand("ROLLBACK");
+        BulkLoadFree(pbl);
+        BulkLoadInit(pbl, pdb);
+        return FALSE;
+    }
+
+    for (t = 0; t < NUM_BULK_TABLES; t++) {
+        char *buf;
+
+        if (pbl->anLastId[t] == MAX(pbl->anStoredId[t], 0))
+            continue;
+
+        if (pbl->anStoredId[t] == -1)
+            buf = g_strdup_printf("INSERT INTO control (tablename,next_id) VALUES ('%s',%d)",
+                                  aszBulkTable[t], pbl->anLastId[t]);
+        else
+            buf = g_strdup_printf("UPDATE control SET next_id = %d WHERE tablename = '%s'",
+                                  pbl->anLastId[t], aszBulkTable[t]);
+        if (pbl->pdb->UpdateCommand(buf))
+            pbl->anStoredId[t] = pbl->anLastId[t];
+        else
+            ok = FALSE;
+        g_free(buf);
+    }
+
+    pbl->pdb->Commit();
+    return ok;
+}
+
+static gint
+CompareFilenames(gconstpointer a, gconstpointer b)
+{
+    return strcmp(a, b);
+}
+
+extern void
+CommandRelationalAddDirectory(char *sz)
+{
+    DBProvider *pdb;
+    bulkload bl;
+    GDir *dir;
+    GError *error = NULL;
+    GList *plFiles = NULL, *pl;
+    const char *szName;
+    char *szDir, *pch;
+    int nBatch = 100, cBatch = 0;
+    int cFiles, cDone = 0, cAdded = 0, cBatchAdded = 0, cExisting = 0, cFailed = 0;
+    int fSaveConfirmNew;
+
+    if (!(szDir = NextToken(&sz))) {
+        outputl(_("You must specify a directory to add matches from (see `help relational add directory')."));
+        return;
+    }
+
+    if ((pch = NextToken(&sz)) && (nBatch = ParseNumber(&pch)) < 1) {
+        outputl(_("The batch size must be a positive number of matches."));
+        return;
+    }
+
+    if (!(dir = g_dir_open(szDir, 0, &error))) {
+        outputerrf("%s", error->message);
+        g_error_free(error);
+        return;
+    }
+    while ((szName = g_dir_read_name(dir)) != NULL) {
+        size_t len = strlen(szName);
+
+        if (len > 4 && !StrCaseCmp(szName + len - 4, ".sgf"))
+            plFiles = g_list_prepend(plFiles, g_build_filename(szDir, szName, NULL));
+    }
+    g_dir_close(dir);
+
+    if (!plFiles) {
+        outputf(_("No SGF files found in %s.\n"), szDir);
+        return;
+    }
+    plFiles = g_list_sort(plFiles, CompareFilenames);
+    cFiles = (int) g_list_length(plFiles);
+
+    if (!get_input_discard()) {
+        g_list_free_full(plFiles, g_free);
+        return;
+    }
+
+    if ((pdb = ConnectToDB(dbProviderType)) == NULL) {
+        outputerrf(_("Error opening database"));
+        g_list_free_full(plFiles, g_free);
+        return;
+    }
+    if (!pdb->Prepare) {
+        outputl(_("The database provider does not support bulk loading."));
+        pdb->Disconnect();
+        g_list_free_full(plFiles, g_free);
+        return;
+    }
+
+    BulkLoadInit(&bl, pdb);
+    pdb->Begin();
+
+    fSaveConfirmNew = fConfirmNew;
+    fConfirmNew = FALSE;
+
+    for (pl = plFiles; pl && !fInterrupt; pl = pl->next) {
+        char *szQuoted = g_strdup_printf("\"%s\"", (char *) pl->data);
+
+        /* a file that fails to load leaves an empty match */
+        FreeMatch();
+        ClearMatch();
+        CommandLoadMatch(szQuoted);
+        g_free(szQuoted);
+
+        if (ListEmpty(&lMatch))
+            cFailed++;
+        else
+            switch (BulkAddMatch(&bl)) {
+            case 1:
+                cBatchAdded++;
+                break;
+            case 0:
+                cExisting++;
+                break;
+            default:
+                outputerrf(_("Error adding %s to the database"), (char *) pl->data);
+                cFailed++;
+            }
+
+        cDone++;
+        if (++cBatch >= nBatch && pl->next) {
+            if (BulkCommit(&bl))
+                cAdded += cBatchAdded;
+            else {
+                outputerrf(_("Error committing to the database"));
+                cFailed += cBatchAdded;
+            }
+            cBatchAdded = 0;
+            pdb->Begin();
+            cBatch = 0;
+            outputf(_("%d of %d files processed.\n"), cDone, cFiles);
+            outputx();
+        }
+    }
+
+    if (BulkCommit(&bl))
+        cAdded += cBatchAdded;
+    else {
+        outputerrf(_("Error committing to the database"));
+        cFailed += cBatchAdded;
+    }
+
+    fConfirmNew = fSaveConfirmNew;
+    BulkLoadFree(&bl);
+    pdb->Disconnect();
+    g_list_free_full(plFiles, g_free);
+
+    outputf(_("%d matches added, %d already in the database, %d files could not be added.\n"),
+            cAdded, cExisting, cFailed);
+}
+
 const char *
 TestDB(DBProviderType dbType)
 {
@@ -218,6 +218,14 @@ iclamp(unsigned int u)
         return (unsigned char) u;
 }
 
+/* x / 0xFF for 0 <= x <= 0xFF * 0xFF without a division, which lets
+ * the compiler vectorise the blending loops below */
+static inline unsigned int
+div255(unsigned int x)
+{
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
 static int
 intersects(int x0, int y0, int cx0, int cy0, int x1, int y1, int cx1, int cy1)
 {
@@ -392,18 +400,13 @@ AlphaBlendBase(unsigned char *puchDest, int nDestStride,
 {
     int x;
 
-    nDestStride -= cx * 3;
-    nBackStride -= cx * 3;
-    nForeStride -= cx * 4;
-
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
-            unsigned int a = puchFore[3];
+        for (x = 0; x < cx; x++) {
+            unsigned int a = puchFore[4 * x + 3];
 
-            *puchDest++ = iclamp((*puchBack++ * a) / 0xFF + *puchFore++);
-            *puchDest++ = iclamp((*puchBack++ * a) / 0xFF + *puchFore++);
-            *puchDest++ = iclamp((*puchBack++ * a) / 0xFF + *puchFore++);
-            puchFore++;         /* skip the alpha channel */
+            puchDest[3 * x] = iclamp(div255(puchBack[3 * x] * a) + puchFore[4 * x]);
+            puchDest[3 * x + 1] = iclamp(div255(puchBack[3 * x + 1] * a) + puchFore[4 * x + 1]);
+            puchDest[3 * x + 2] = iclamp(div255(puchBack[3 * x + 2] * a) + puchFore[4 * x + 2]);
         }
         puchDest += nDestStride;
         puchBack += nBackStride;
@@ -468,18 +471,13 @@ AlphaBlend2(unsigned char *puchDest, int nDestStride,
 
     int x;
 
-    nDestStride -= cx * 3;
-    nBackStride -= cx * 3;
-    nForeStride -= cx * 4;
-
     for (; cy; cy--) {
-        for (x = cx; x; x--) {
-            unsigned int a = puchFore[3];
+        for (x = 0; x < cx; x++) {
+            unsigned int a = puchFore[4 * x + 3];
 
-            *puchDest++ = iclamp((*puchBack++ * (0xFF - a)) / 0xFF + (*puchFore++ * a) / 0xFF);
-            *puchDest++ = iclamp((*puchBack++ * (0xFF - a)) / 0xFF + (*puchFore++ * a) / 0xFF);
-            *puchDest++ = iclamp((*puchBack++ * (0xFF - a)) / 0xFF + (*puchFore++ * a) / 0xFF);
-            puchFore++;         /* skip the alpha channel */
+            puchDest[3 * x] = iclamp(div255(puchBack[3 * x] * (0xFF - a)) + div255(puchFore[4 * x] * a));
+            puchDest[3 * x + 1] = iclamp(div255(puchBack[3 * x + 1] * (0xFF - a)) + div255(puchFore[4 * x + 1] * a));
+            puchDest[3 * x + 2] = iclamp(div255(puchBack[3 * x + 2] * (0xFF - a)) + div255(puchFore[4 * x + 2] * a));
         }
         puchDest += nDestStride;
         puchBack += nBackStride;
@@ -553,9 +551,9 @@ RefractBlend(unsigned char *puchDest, int nDestStride,
             unsigned int a = puchFore[3];
             unsigned char *puch = puchBack + (*psRefract >> 8) * nBackStride + (*psRefract & 0xFF) * 3;
 
-            *puchDest++ = iclamp((puch[0] * a) / 0xFF + *puchFore++);
-            *puchDest++ = iclamp((puch[1] * a) / 0xFF + *puchFore++);
-            *puchDest++ = iclamp((puch[2] * a) / 0xFF + *puchFore++);
+            *puchDest++ = iclamp(div255(puch[0] * a) + *puchFore++);
+            *puchDest++ = iclamp(div255(puch[1] * a) + *puchFore++);
+            *puchDest++ = iclamp(div255(puch[2] * a) + *puchFore++);
             puchFore++;         /* skip the alpha channel */
             psRefract++;
         }
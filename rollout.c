@@ -26,12 +26,21 @@
 #include <string.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <signal.h>
 #include <time.h>
+#if defined(WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "backgammon.h"
 #if defined(USE_GTK)
 #include "gtkgame.h"
 #endif
+#include "matchequity.h"
 #include "matchid.h"
 #include "positionid.h"
 #include "format.h"
@@ -41,11 +50,6 @@
 
 #define LogCubeClamped(n) (n < (1 << STAT_MAXCUBE) ? LogCube(n) : (STAT_MAXCUBE - 1))
 
-#if !defined(LOCKING_VERSION)
-
-f_BasicCubefulRollout BasicCubefulRollout = BasicCubefulRolloutNoLocking;
-#define BasicCubefulRollout BasicCubefulRolloutNoLocking
-
 int log_rollouts = 0;
 char *log_file_name = 0;
 static unsigned int initial_game_count;
@@ -114,8 +118,8 @@ board_to_sgf(FILE * logfp, const unsigned int anBoard[25], int direction)
         fprintf(logfp, "[y]");
 }
 
-static FILE *
-log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard anBoard)
+extern FILE *
+log_game_start(const char *name, const cubeinfo * pci, int fCubeful, int fCrawfordRule, TanBoard anBoard)
 {
     time_t t = time(0);
 #if defined(USE_MULTITHREAD) && defined(HAVE_LOCALTIME_R)
@@ -143,8 +147,8 @@ log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard an
     } else {
         if (!fCubeful) {
             rule = "RU[NoCube:Crawford]";
-        } else if (fAutoCrawford) {
-            rule = (ms.fCrawford) ? "RU[Crawford:CrawfordGame]" : "RU[Crawford]";
+        } else if (fCrawfordRule) {
+            rule = pci->fCrawford ? "RU[Crawford:CrawfordGame]" : "RU[Crawford]";
         } else {
             rule = "";
         }
@@ -177,7 +181,7 @@ log_game_start(const char *name, const cubeinfo * pci, int fCubeful, TanBoard an
     return logfp;
 }
 
-static void
+extern void
 log_game_over(FILE * logfp)
 {
     if (!logfp)
@@ -242,6 +246,14 @@ RolloutDice(int iTurn, int iGame,
                     break;
             }
 
+            return 0;
+        } else if (*rngx == RNG_PHILOX) {
+            unsigned int iDraw = 0;
+
+            do
+                RollDiceAt(anDice, rngctx, (unsigned int) iGame, 0, iDraw++);
+            while (anDice[0] == anDice[1]);
+
             return 0;
         } else {
             do {
@@ -263,6 +275,10 @@ RolloutDice(int iTurn, int iGame,
         anDice[0] = j / 6 + 1;
         anDice[1] = j % 6 + 1;
         return 0;
+    } else if (*rngx == RNG_PHILOX) {
+        /* every roll is addressed by trial and turn, so nothing to reseed */
+        RollDiceAt(anDice, rngctx, (unsigned int) iGame, (unsigned int) iTurn, 0);
+        return 0;
     } else
         return RollDice(anDice, rngx, rngctx);
 }
@@ -288,17 +304,7 @@ ClosedBoard(int afClosedBoard[2], const TanBoard anBoard)
 
 }
 
-#else
-
-#define BasicCubefulRollout BasicCubefulRolloutWithLocking
-
-static volatile unsigned int initial_game_count;
-
-#endif
-
-#if !defined(LOCKING_VERSION)
 static void initRolloutstat(rolloutstat * prs);
-#endif
 
 /* called with 
  * cube decision                  move rollout
@@ -843,8 +849,6 @@ BasicCubefulRollout(unsigned int aanBoard[][2][25],
     return 0;
 }
 
-#if !defined(LOCKING_VERSION)
-
 /* called with a collection of moves or a cube decision to be rolled out.
  * when called with a cube decision, the number of alternatives is always 2
  * (nodouble/double or take/drop). Otherwise the number of moves is
@@ -939,6 +943,7 @@ static int **ro_apCubeDecTop;
 static rolloutstat(*ro_aarsStatistics)[2];
 static int ro_fCubeRollout;
 static int ro_fInvert;
+static int ro_fAutoCrawford;
 static int ro_NextTrial;
 static unsigned int *altGameCount;
 static int *altTrialCount;
@@ -1124,16 +1129,99 @@ check_sds(int *active)
 
 }
 
+/* Play out one trial of alternative alt, adding its statistics to *pars
+ * if that is not NULL. */
+static void
+RolloutTrial(int alt, int trial, float aar[NUM_ROLLOUT_OUTPUTS], rolloutstat(*pars)[2], perArray * pdicePerms,
+             rngcontext * rngctx)
+{
+    TanBoard anBoardEval;
+    FILE *logfp = NULL;
+    rolloutcontext *prc = &ro_apes[alt]->rc;
+
+    /* get the dice generator set up... */
+    if (prc->fRotate)
+        QuasiRandomSeed(pdicePerms, (int) prc->nSeed);
+
+    MT_SafeSet(&nSkip, 0);      /* not multi-thread safe do quasi random dice for initial positions */
+
+    /* ... and the RNG; a counter-based one is only keyed by the
+     * seed, as its rolls are addressed by trial and turn */
+    if (prc->rngRollout == RNG_PHILOX)
+        InitRNGSeed((unsigned int) prc->nSeed, prc->rngRollout, rngctx);
+    else if (prc->rngRollout != RNG_MANUAL)
+        InitRNGSeed((unsigned int) (prc->nSeed + (trial << 8)), prc->rngRollout, rngctx);
+
+    memcpy(&anBoardEval, ro_apBoard[alt], sizeof(anBoardEval));
+
+    /* roll something out */
+    if (log_rollouts && log_file_name) {
+        char *log_name = g_strdup_printf("%s-%7.7d-%c.sgf", log_file_name, trial, alt + 'a');
+        logfp = log_game_start(log_name, ro_apci[alt], prc->fCubeful, ro_fAutoCrawford, anBoardEval);
+        g_free(log_name);
+    }
+    BasicCubefulRollout(&anBoardEval, (float (*)[NUM_ROLLOUT_OUTPUTS]) aar, 0, trial, ro_apci[alt],
+                        ro_apCubeDecTop[alt], 1, prc, pars,
+                        aciLocal[ro_fCubeRollout ? 0 : alt].nCube, pdicePerms, rngctx, logfp);
+
+    if (logfp) {
+        log_game_over(logfp);
+    }
+}
+
+/* Add the outcome of one trial to the results of alternative alt.
+ * Must be called with the exclusive lock held. */
+static void
+AddTrialResult(int alt, float aar[NUM_ROLLOUT_OUTPUTS])
+{
+    rolloutcontext *prc = &ro_apes[alt]->rc;
+    unsigned int j;
+
+    altGameCount[alt]++;
+
+    if (ro_fInvert)
+        InvertEvaluationR(aar, ro_apci[alt]);
+
+    /* apply the results */
+    for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
+        float rMuNew;
+
+        aarResult[alt][j] += aar[j];
+        rMuNew = aarResult[alt][j] / (float) altGameCount[alt];
+
+        if (altGameCount[alt] > 1) {    /* for i == 0 aarVariance is not defined */
+            float rDelta = rMuNew - aarMu[alt][j];
+
+            aarVariance[alt][j] =
+                aarVariance[alt][j] * (1.0f - 1.0f / (float) (altGameCount[alt] - 1)) +
+                (float) (altGameCount[alt]) * rDelta * rDelta;
+        }
+
+        aarMu[alt][j] = rMuNew;
+
+        if (j < OUTPUT_EQUITY) {
+            if (aarMu[alt][j] < 0.0f)
+                aarMu[alt][j] = 0.0f;
+            else if (aarMu[alt][j] > 1.0f)
+                aarMu[alt][j] = 1.0f;
+        }
+
+        aarSigma[alt][j] = sqrtf(aarVariance[alt][j] / (float) altGameCount[alt]);
+    }                           /* for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++ ) */
+
+    /* For normal alternatives nGamesDone and altGameCount will be equal. For cube decisions,
+     * however, the two may differ by the number of threads minus 1. So we cheat a little bit, but
+     * it would be better if the double and nodouble alternatives weren't linked */
+    if (prc->nGamesDone < altGameCount[alt])
+        prc->nGamesDone = altGameCount[alt];
+}
+
 extern void
 RolloutLoopMT(void *UNUSED(unused))
 {
-    TanBoard anBoardEval;
     float aar[NUM_ROLLOUT_OUTPUTS];
     int active_alternatives;
-    unsigned int j;
     int alt;
-    FILE *logfp = NULL;
-    rolloutcontext *prc = NULL;
     /* Each thread gets a copy of the rngctxRollout */
     rngcontext *rngctxMTRollout = CopyRNGContext(rngctxRollout);
     perArray dicePerms;
@@ -1152,79 +1240,15 @@ RolloutLoopMT(void *UNUSED(unused))
                 continue;
             }
 
-
-            prc = &ro_apes[alt]->rc;
-
-            /* get the dice generator set up... */
-            if (prc->fRotate)
-                QuasiRandomSeed(&dicePerms, (int) prc->nSeed);
-
-            MT_SafeSet(&nSkip, 0);      /* not multi-thread safe do quasi random dice for initial positions */
-
-            /* ... and the RNG */
-            if (prc->rngRollout != RNG_MANUAL)
-                InitRNGSeed((unsigned int) (prc->nSeed + (trial << 8)), prc->rngRollout, rngctxMTRollout);
-
-            memcpy(&anBoardEval, ro_apBoard[alt], sizeof(anBoardEval));
-
-            /* roll something out */
-            if (log_rollouts && log_file_name) {
-                char *log_name = g_strdup_printf("%s-%7.7d-%c.sgf", log_file_name, trial, alt + 'a');
-                logfp = log_game_start(log_name, ro_apci[alt], prc->fCubeful, anBoardEval);
-                g_free(log_name);
-            }
-            BasicCubefulRollout(&anBoardEval, &aar, 0, trial, ro_apci[alt],
-                                ro_apCubeDecTop[alt], 1, prc,
-                                ro_aarsStatistics ? ro_aarsStatistics + alt : NULL,
-                                aciLocal[ro_fCubeRollout ? 0 : alt].nCube, &dicePerms, rngctxMTRollout, logfp);
-
-            if (logfp) {
-                log_game_over(logfp);
-            }
+            RolloutTrial(alt, trial, aar, ro_aarsStatistics ? ro_aarsStatistics + alt : NULL, &dicePerms,
+                         rngctxMTRollout);
 
             if (MT_SafeGet(&fInterrupt))
                 break;
 
             multi_debug("exclusive lock: update result for alternative");
             MT_Exclusive();
-            altGameCount[alt]++;
-
-            if (ro_fInvert)
-                InvertEvaluationR(aar, ro_apci[alt]);
-
-            /* apply the results */
-            for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++) {
-                float rMuNew;
-
-                aarResult[alt][j] += aar[j];
-                rMuNew = aarResult[alt][j] / (float) altGameCount[alt];
-
-                if (altGameCount[alt] > 1) {    /* for i == 0 aarVariance is not defined */
-                    float rDelta = rMuNew - aarMu[alt][j];
-
-                    aarVariance[alt][j] =
-                        aarVariance[alt][j] * (1.0f - 1.0f / (float) (altGameCount[alt] - 1)) +
-                        (float) (altGameCount[alt]) * rDelta * rDelta;
-                }
-
-                aarMu[alt][j] = rMuNew;
-
-                if (j < OUTPUT_EQUITY) {
-                    if (aarMu[alt][j] < 0.0f)
-                        aarMu[alt][j] = 0.0f;
-                    else if (aarMu[alt][j] > 1.0f)
-                        aarMu[alt][j] = 1.0f;
-                }
-
-                aarSigma[alt][j] = sqrtf(aarVariance[alt][j] / (float) altGameCount[alt]);
-            }                   /* for (j = 0; j < NUM_ROLLOUT_OUTPUTS; j++ ) */
-
-            /* For normal alternatives nGamesDone and altGameCount will be equal. For cube decisions,
-             * however, the two may differ by the number of threads minus 1. So we cheat a little bit, but
-             * it would be better if the double and nodouble alternatives weren't linked */
-            if (prc->nGamesDone < altGameCount[alt])
-                prc->nGamesDone = altGameCount[alt];
-
+            AddTrialResult(alt, aar);
             MT_Release();
             multi_debug("exclusive release: update result for alternative");
 
@@ -1286,6 +1310,603 @@ UpdateProgress(gpointer UNUSED(unused))
     return TRUE;
 }
 
+/*
+ * Sharded rollouts.
+ *
+ * Given its seed, every trial of a rollout is played the same way
+ * whichever thread or process plays it, so the trials can be shared out
+ * between worker processes.  The coordinator starts nRolloutShards
+ * workers with szRolloutShardCommand (by default this program with
+ * --rollout-worker), sends each the job on its standard input and reads
+ * the outputs of its trials back from its standard output.  Worker i
+ * plays trials i, i + n, i + 2n, ... so that all of them contribute to
+ * the results from the start.
+ *
+ * The coordinator adds the trials to the results in trial order,
+ * whichever worker finishes first, so the result does not depend on the
+ * number of workers and is the one a single thread would give.  The job
+ * is made of raw structures and the workers must be the same build; the
+ * header records the version and the sizes to catch a mismatch.
+ *
+ * The results are read here without blocking, so the rollout can be
+ * stopped at any time.  If a worker fails, the trials that are missing
+ * are played here once the others are done, so the rollout always
+ * completes.
+ *
+ * The stopping rules need the results as they come in and are not used:
+ * a sharded rollout plays all its trials.
+ */
+
+unsigned int nRolloutShards = 0;
+char *szRolloutShardCommand = NULL;
+
+#define SHARD_MAGIC "gnubg-shard"
+
+typedef struct {
+    char szMagic[12];
+    char szVersion[20];
+    unsigned int acb[3];        /* sizes of shardheader, shardalternative, rolloutstat */
+    int alternatives;
+    int fInvert, fCubeRollout, fStatistics;
+    int iFirst, iStep, iLast;   /* trials iFirst, iFirst + iStep, ... below iLast */
+    unsigned int cchMET;        /* length of the MET file name that follows */
+} shardheader;
+
+typedef struct {
+    TanBoard anBoard;
+    cubeinfo ci;
+    evalsetup es;
+    int fCubeDecTop;
+    int nDone;                  /* trials played already */
+} shardalternative;
+
+typedef struct {
+    int fd;                     /* results, -1 once closed */
+    int iFirst;
+    int fDone;                  /* all trials came in */
+    GByteArray *pba;            /* received and not parsed yet */
+} shard;
+
+static int nShardFirstTrial;
+static int *anShardDone;
+static float (*aarShardTrials)[NUM_ROLLOUT_OUTPUTS];
+static unsigned char *afShardTrials;
+static rolloutstat(**apShardStatistics)[2];     /* of trials not merged yet */
+static int iShardMerge;
+
+/* rolloutstat only holds counters */
+static void
+AddRolloutStatistics(rolloutstat * prs, const rolloutstat * prsAdd)
+{
+    int *pn = (int *) prs;
+    const int *pnAdd = (const int *) prsAdd;
+    size_t i;
+
+    for (i = 0; i < sizeof(rolloutstat) / sizeof(int); i++)
+        pn[i] += pnAdd[i];
+}
+
+static void
+ShardHeader(shardheader * psh, int alternatives)
+{
+    memset(psh, 0, sizeof(*psh));
+    strcpy(psh->szMagic, SHARD_MAGIC);
+    g_strlcpy(psh->szVersion, VERSION, sizeof(psh->szVersion));
+    psh->acb[0] = sizeof(shardheader);
+    psh->acb[1] = sizeof(shardalternative);
+    psh->acb[2] = sizeof(rolloutstat);
+    psh->alternatives = alternatives;
+}
+
+/* Add the trials that have come in to the results, in order.  Must be
+ * called with the exclusive lock held. */
+static void
+MergeShardTrials(void)
+{
+    int alt;
+
+    while (iShardMerge < cGames && afShardTrials[iShardMerge - nShardFirstTrial]) {
+        rolloutstat(**paars)[2] = apShardStatistics ? apShardStatistics + iShardMerge - nShardFirstTrial : NULL;
+
+        for (alt = 0; alt < ro_alternatives; ++alt)
+            if (iShardMerge >= anShardDone[alt]) {
+                AddTrialResult(alt, aarShardTrials[(iShardMerge - nShardFirstTrial) * ro_alternatives + alt]);
+                if (paars) {
+                    AddRolloutStatistics(&ro_aarsStatistics[alt][0], &(*paars)[alt][0]);
+                    AddRolloutStatistics(&ro_aarsStatistics[alt][1], &(*paars)[alt][1]);
+                }
+            }
+
+        if (paars) {
+            g_free(*paars);
+            *paars = NULL;
+        }
+        iShardMerge++;
+    }
+}
+
+/* Take the complete records received from a worker: a trial number, the
+ * outputs of the trial for each alternative and, if they are kept, its
+ * statistics for each alternative; or -1 once all its trials are played.
+ * The statistics of a trial are only added when it is merged, so those
+ * of trials that are played again here after a worker failed do not
+ * count twice.  Returns -1 if the worker sent something else. */
+static int
+ParseShard(shard * psh)
+{
+    const size_t cbTrial = ro_alternatives * sizeof(aarShardTrials[0]);
+    const size_t cbStatistics = ro_aarsStatistics ? ro_alternatives * sizeof(rolloutstat[2]) : 0;
+    size_t i = 0;
+    int trial;
+
+    while (!psh->fDone && psh->pba->len - i >= sizeof(trial)) {
+        const guint8 *pch = psh->pba->data + i + sizeof(trial);
+        const size_t cbLeft = psh->pba->len - i - sizeof(trial);
+
+        memcpy(&trial, psh->pba->data + i, sizeof(trial));
+
+        if (trial < 0) {
+            psh->fDone = TRUE;
+            i += sizeof(trial);
+        } else {
+            if (trial < nShardFirstTrial || trial >= cGames)
+                return -1;
+            if (cbLeft < cbTrial + cbStatistics)
+                break;
+
+            MT_Exclusive();
+            memcpy(aarShardTrials[(trial - nShardFirstTrial) * ro_alternatives], pch, cbTrial);
+            if (cbStatistics && !afShardTrials[trial - nShardFirstTrial]) {
+                apShardStatistics[trial - nShardFirstTrial] = g_malloc(cbStatistics);
+                memcpy(apShardStatistics[trial - nShardFirstTrial], pch + cbTrial, cbStatistics);
+            }
+            afShardTrials[trial - nShardFirstTrial] = TRUE;
+            MergeShardTrials();
+            MT_Release();
+            i += sizeof(trial) + cbTrial + cbStatistics;
+        }
+    }
+
+    g_byte_array_remove_range(psh->pba, 0, (guint) i);
+
+    return psh->fDone && psh->pba->len ? -1 : 0;
+}
+
+/* Read what a worker has sent, without blocking.  Returns 1 if something
+ * was read, 0 if nothing was waiting and -1 at the end of its output. */
+static int
+ReadShard(shard * psh)
+{
+    guint8 ach[65536];
+    long cb;
+
+#if defined(WIN32)
+    DWORD cbAvail;
+
+    if (!PeekNamedPipe((HANDLE) _get_osfhandle(psh->fd), NULL, 0, NULL, &cbAvail, NULL))
+        return -1;
+    if (!cbAvail)
+        return 0;
+    cb = _read(psh->fd, ach, MIN(cbAvail, sizeof(ach)));
+#else
+    cb = read(psh->fd, ach, sizeof(ach));
+    if (cb < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+#endif
+    if (cb <= 0)
+        return -1;
+
+    g_byte_array_append(psh->pba, ach, (guint) cb);
+    return 1;
+}
+
+static void
+CloseShard(shard * psh)
+{
+    if (psh->fd >= 0) {
+        /* closing the pipe stops a worker that is still playing */
+        close(psh->fd);
+        psh->fd = -1;
+    }
+}
+
+/* Wait up to 100 ms for any of the workers to send something */
+static void
+WaitForShards(shard * ash, unsigned int cShards)
+{
+#if defined(WIN32)
+    (void) ash;
+    (void) cShards;
+    g_usleep(20000);
+#else
+    GPollFD *apfd = g_newa(GPollFD, cShards);
+    unsigned int i, c = 0;
+
+    for (i = 0; i < cShards; ++i)
+        if (ash[i].fd >= 0) {
+            apfd[c].fd = ash[i].fd;
+            apfd[c].events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+            apfd[c++].revents = 0;
+        }
+
+    g_poll(apfd, c, 100);
+#endif
+}
+
+/* Read the results of the workers as they come in, until they are all
+ * done or the user stops the rollout.  This runs on the calling thread,
+ * so it does not need a thread per worker and never blocks on a pipe. */
+static void
+CollectShards(shard * ash, unsigned int cShards)
+{
+    guint as_source = 0;
+    gint64 tProgress = g_get_monotonic_time();
+    unsigned int i, cOpen = 0;
+
+    for (i = 0; i < cShards; ++i)
+        if (ash[i].fd >= 0)
+            cOpen++;
+
+#if defined(USE_GTK)
+    GTKSuspendInput();
+#endif
+    if (fAutoSaveRollout)
+        as_source = g_timeout_add(nAutoSaveTime * 60000, save_autosave, NULL);
+
+    while (cOpen && !MT_SafeGet(&fInterrupt)) {
+        WaitForShards(ash, cShards);
+
+        for (i = 0; i < cShards; ++i) {
+            shard *psh = ash + i;
+            int n;
+
+            if (psh->fd < 0)
+                continue;
+
+            while ((n = ReadShard(psh)) > 0)
+                if (ParseShard(psh) < 0) {
+                    n = -1;
+                    break;
+                }
+
+            if (n < 0 || psh->fDone) {
+                CloseShard(psh);
+                cOpen--;
+            }
+        }
+
+        if (g_get_monotonic_time() - tProgress >= 2000000) {
+            UpdateProgress(NULL);
+            tProgress = g_get_monotonic_time();
+        }
+        ProcessEvents();
+    }
+
+    for (i = 0; i < cShards; ++i)
+        CloseShard(ash + i);
+
+    if (fAutoSaveRollout) {
+        g_source_remove(as_source);
+        save_autosave(NULL);
+    }
+#if defined(USE_GTK)
+    GTKResumeInput();
+#endif
+}
+
+static int
+StartShard(shard * psh, const shardheader * pshJob, const shardalternative * asa)
+{
+    gchar **argv;
+    GError *error = NULL;
+    int fdJob, fdResults;
+    size_t cch = pshJob->cchMET;
+    FILE *pfJob;
+    int f;
+#if !defined(WIN32)
+    psighandler sh;
+#endif
+
+    if (szRolloutShardCommand) {
+        if (!g_shell_parse_argv(szRolloutShardCommand, NULL, &argv, &error)) {
+            outputerrf(_("Cannot parse the rollout worker command: %s\n"), error->message);
+            g_error_free(error);
+            return -1;
+        }
+    } else {
+        argv = g_new0(gchar *, 3);
+        argv[0] = g_strdup(szProgramPath);
+        argv[1] = g_strdup("--rollout-worker");
+    }
+
+    f = g_spawn_async_with_pipes(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, &fdJob, &fdResults, NULL, &error);
+    g_strfreev(argv);
+
+    if (!f) {
+        outputerrf(_("Cannot start a rollout worker: %s\n"), error->message);
+        g_error_free(error);
+        return -1;
+    }
+#if defined(WIN32)
+    _setmode(fdJob, _O_BINARY);
+    _setmode(fdResults, _O_BINARY);
+#else
+    fcntl(fdResults, F_SETFL, fcntl(fdResults, F_GETFL) | O_NONBLOCK);
+#endif
+
+    pfJob = fdopen(fdJob, "wb");
+    psh->fd = fdResults;
+    psh->fDone = FALSE;
+
+#if !defined(WIN32)
+    PortableSignal(SIGPIPE, SIG_IGN, &sh, FALSE);
+#endif
+    f = fwrite(pshJob, sizeof(*pshJob), 1, pfJob) == 1
+        && fwrite(miCurrent.szFileName, 1, cch, pfJob) == cch
+        && fwrite(asa, sizeof(*asa), pshJob->alternatives, pfJob) == (size_t) pshJob->alternatives;
+    f = !fclose(pfJob) && f;
+#if !defined(WIN32)
+    PortableSignalRestore(SIGPIPE, &sh);
+#endif
+
+    if (!f) {
+        outputerrf(_("Cannot send the rollout to a worker: %s\n"), g_strerror(errno));
+        CloseShard(psh);
+    }
+
+    return f ? 0 : -1;
+}
+
+/* Play trials nFirstTrial to cGames - 1 in worker processes, one shard
+ * of trials per worker.  The trials of workers that fail are played
+ * here.  Returns -1 if the rollout cannot be sharded and should be
+ * played here. */
+static int
+RolloutSharded(int nFirstTrial)
+{
+    const int alternatives = ro_alternatives;
+    const int cTrials = cGames - nFirstTrial;
+    unsigned int cShards = nRolloutShards;
+    shardheader sh;
+    shardalternative *asa;
+    shard *ash;
+    unsigned int i;
+    int alt;
+
+    /* the workers cannot ask for dice, and cannot share a dice file, the
+     * state of a Blum, Blum and Shub generator or the random.org buffer */
+    for (alt = 0; alt < alternatives; ++alt)
+        switch (ro_apes[alt]->rc.rngRollout) {
+        case RNG_MANUAL:
+        case RNG_FILE:
+        case RNG_BBS:
+        case RNG_RANDOM_DOT_ORG:
+            return -1;
+        default:
+            break;
+        }
+
+    if (cTrials <= 0)
+        return 0;
+
+    if (cShards > (unsigned int) cTrials)
+        cShards = (unsigned int) cTrials;
+
+    asa = g_new0(shardalternative, alternatives);
+    anShardDone = g_new(int, alternatives);
+
+    for (alt = 0; alt < alternatives; ++alt) {
+        memcpy(asa[alt].anBoard, ro_apBoard[alt], sizeof(TanBoard));
+        asa[alt].ci = *ro_apci[alt];
+        asa[alt].es = *ro_apes[alt];
+        asa[alt].fCubeDecTop = ro_apCubeDecTop[alt][0];
+        asa[alt].nDone = anShardDone[alt] = fNoMore[alt] ? cGames : (int) altGameCount[alt];
+    }
+
+    ShardHeader(&sh, alternatives);
+    sh.fInvert = ro_fInvert;
+    sh.fCubeRollout = ro_fCubeRollout;
+    sh.fStatistics = ro_aarsStatistics != NULL;
+    sh.iStep = (int) cShards;
+    sh.iLast = cGames;
+    sh.cchMET = (unsigned int) strlen(miCurrent.szFileName);
+
+    nShardFirstTrial = iShardMerge = nFirstTrial;
+    aarShardTrials = g_malloc((gsize) cTrials * alternatives * sizeof(*aarShardTrials));
+    afShardTrials = g_new0(unsigned char, cTrials);
+    apShardStatistics = ro_aarsStatistics ? g_malloc0((gsize) cTrials * sizeof(*apShardStatistics)) : NULL;
+    ash = g_new0(shard, cShards);
+
+    for (i = 0; i < cShards; ++i) {
+        sh.iFirst = ash[i].iFirst = nFirstTrial + (int) i;
+        ash[i].pba = g_byte_array_new();
+        if (StartShard(ash + i, &sh, asa) != 0)
+            ash[i].fd = -1;
+    }
+
+    CollectShards(ash, cShards);
+
+    if (!MT_SafeGet(&fInterrupt) && iShardMerge < cGames) {
+        for (i = 0; i < cShards; ++i)
+            if (!ash[i].fDone)
+                outputerrf(_("The rollout worker for trials %d, %d, ... failed.\n"), ash[i].iFirst + 1,
+                           ash[i].iFirst + 1 + (int) cShards);
+        outputf(_("Playing trials %d to %d here.\n"), iShardMerge + 1, cGames);
+
+        /* carry on from the first missing trial as a local rollout would */
+        for (alt = 0; alt < alternatives; ++alt)
+            altTrialCount[alt] = (int) altGameCount[alt];
+        ro_NextTrial = iShardMerge;
+        mt_add_tasks(MT_GetNumThreads(), RolloutLoopMT, NULL, NULL);
+        MT_WaitForTasks(UpdateProgress, 2000, fAutoSaveRollout);
+    }
+
+    for (i = 0; i < cShards; ++i)
+        g_byte_array_free(ash[i].pba, TRUE);
+    g_free(ash);
+    if (apShardStatistics) {
+        /* those of trials after a gap that were played again here */
+        for (i = 0; i < (unsigned int) cTrials; ++i)
+            g_free(apShardStatistics[i]);
+        g_free(apShardStatistics);
+        apShardStatistics = NULL;
+    }
+    g_free(afShardTrials);
+    g_free(aarShardTrials);
+    g_free(anShardDone);
+    g_free(asa);
+
+    return 0;
+}
+
+static gboolean
+ShardWorkerIdle(gpointer UNUSED(unused))
+{
+    return TRUE;
+}
+
+static int nShardFirst, nShardStep;
+
+static void
+ShardWorkerLoop(void *p)
+{
+    FILE *pf = p;
+    float (*aar)[NUM_ROLLOUT_OUTPUTS] = g_malloc0(ro_alternatives * sizeof(*aar));
+    rolloutstat(*aars)[2] = ro_aarsStatistics ? g_malloc(ro_alternatives * sizeof(*aars)) : NULL;
+    rngcontext *rngctx = CopyRNGContext(rngctxRollout);
+    perArray dicePerms;
+    int trial, alt;
+
+    dicePerms.nPermutationSeed = -1;
+
+    while ((trial = nShardFirst + (MT_SafeIncValue(&ro_NextTrial) - 1) * nShardStep) < cGames) {
+        /* the statistics go with the trial, so that the parent only
+         * counts those of the trials it uses */
+        if (aars)
+            memset(aars, 0, ro_alternatives * sizeof(*aars));
+
+        for (alt = 0; alt < ro_alternatives; ++alt)
+            if (trial >= (int) altGameCount[alt])
+                RolloutTrial(alt, trial, aar[alt], aars ? aars + alt : NULL, &dicePerms, rngctx);
+
+        MT_Exclusive();
+        fwrite(&trial, sizeof(trial), 1, pf);
+        fwrite(aar, sizeof(aar[0]), ro_alternatives, pf);
+        if (aars)
+            fwrite(aars, sizeof(aars[0]), ro_alternatives, pf);
+        fflush(pf);
+        MT_Release();
+    }
+
+    g_free(aars);
+    g_free(rngctx);
+    g_free(aar);
+}
+
+/* The worker side: read a job from pfJob, play its trials and write their
+ * outputs to pfResults. */
+extern int
+RolloutWorker(FILE * pfJob, FILE * pfResults)
+{
+    shardheader sh, shExpected;
+    shardalternative *asa;
+    ConstTanBoard *apBoard;
+    const cubeinfo **apci;
+    evalsetup **apes;
+    int **apCubeDecTop;
+    rolloutstat(*aars)[2] = NULL;
+    char *szMET;
+    int alt, trial = -1;
+
+#if defined(WIN32)
+    _setmode(_fileno(pfJob), _O_BINARY);
+    _setmode(_fileno(pfResults), _O_BINARY);
+#endif
+
+    ShardHeader(&shExpected, 0);
+
+    if (fread(&sh, sizeof(sh), 1, pfJob) != 1 || memcmp(sh.szMagic, shExpected.szMagic, sizeof(sh.szMagic))) {
+        outputerrf(_("This is not a rollout job.\n"));
+        return -1;
+    }
+    if (memcmp(sh.szVersion, shExpected.szVersion, sizeof(sh.szVersion))
+        || memcmp(sh.acb, shExpected.acb, sizeof(sh.acb))) {
+        outputerrf(_("The rollout job comes from a different build of GNU Backgammon.\n"));
+        return -1;
+    }
+    if (sh.alternatives < 1 || sh.iStep < 1) {
+        outputerrf(_("This is not a rollout job.\n"));
+        return -1;
+    }
+
+    szMET = g_malloc(sh.cchMET + 1);
+    asa = g_new(shardalternative, sh.alternatives);
+    if (fread(szMET, 1, sh.cchMET, pfJob) != sh.cchMET
+        || fread(asa, sizeof(*asa), sh.alternatives, pfJob) != (size_t) sh.alternatives) {
+        outputerrf(_("The rollout job is incomplete.\n"));
+        g_free(szMET);
+        g_free(asa);
+        return -1;
+    }
+    szMET[sh.cchMET] = 0;
+
+    if (strcmp(szMET, miCurrent.szFileName))
+        InitMatchEquity(szMET);
+    g_free(szMET);
+
+    apBoard = g_new(ConstTanBoard, sh.alternatives);
+    apci = g_new(const cubeinfo *, sh.alternatives);
+    apes = g_new(evalsetup *, sh.alternatives);
+    apCubeDecTop = g_new(int *, sh.alternatives);
+    aciLocal = g_new(cubeinfo, sh.alternatives);
+    altGameCount = g_new(unsigned int, sh.alternatives);
+    if (sh.fStatistics)
+        aars = g_malloc0(sh.alternatives * sizeof(*aars));
+
+    for (alt = 0; alt < sh.alternatives; ++alt) {
+        apBoard[alt] = (ConstTanBoard) asa[alt].anBoard;
+        apci[alt] = &asa[alt].ci;
+        apes[alt] = &asa[alt].es;
+        apCubeDecTop[alt] = &asa[alt].fCubeDecTop;
+        aciLocal[alt] = asa[alt].ci;
+        if (sh.fInvert)
+            aciLocal[alt].fMove = !aciLocal[alt].fMove;
+        altGameCount[alt] = (unsigned int) asa[alt].nDone;
+    }
+
+    ro_alternatives = sh.alternatives;
+    ro_apBoard = apBoard;
+    ro_apci = apci;
+    ro_apes = apes;
+    ro_apCubeDecTop = apCubeDecTop;
+    ro_aarsStatistics = aars;
+    ro_fCubeRollout = sh.fCubeRollout;
+    ro_fInvert = sh.fInvert;
+    ro_fAutoCrawford = fAutoCrawford;
+    ro_NextTrial = 0;
+    nShardFirst = sh.iFirst;
+    nShardStep = sh.iStep;
+    cGames = sh.iLast;
+
+    mt_add_tasks(MT_GetNumThreads(), ShardWorkerLoop, pfResults, NULL);
+    MT_WaitForTasks(ShardWorkerIdle, 2000, FALSE);
+
+    fwrite(&trial, sizeof(trial), 1, pfResults);
+
+    ro_alternatives = -1;
+
+    g_free(aars);
+    g_free(altGameCount);
+    g_free(aciLocal);
+    g_free(apCubeDecTop);
+    g_free(apes);
+    g_free(apci);
+    g_free(apBoard);
+    g_free(asa);
+
+    return fflush(pfResults) ? -1 : 0;
+}
+
 extern int
 RolloutGeneral(ConstTanBoard * apBoard,
                float (*apOutput[])[NUM_ROLLOUT_OUTPUTS],
@@ -1456,6 +2077,7 @@ RolloutGeneral(ConstTanBoard * apBoard,
     ro_aarsStatistics = aarsStatistics;
     ro_fCubeRollout = fCubeRollout;
     ro_fInvert = fInvert;
+    ro_fAutoCrawford = fAutoCrawford;
     ro_NextTrial = nFirstTrial;
     ro_pfProgress = pfProgress;
     ro_pUserData = pUserData;
@@ -1475,13 +2097,20 @@ RolloutGeneral(ConstTanBoard * apBoard,
 
     UpdateProgress(NULL);
 
-    if (active_alternatives > 1 || (!rcRollout.fStopOnJsd && active_alternatives > 0)) {
+    if (nRolloutShards > 0 && (active_alternatives > 1 || (!rcRollout.fStopOnJsd && active_alternatives > 0))
+        && RolloutSharded(nFirstTrial) == 0) {
+        MT_Exclusive();
+        if (show_jsds)
+            check_jsds(&active_alternatives);
+        MT_Release();
+    } else if (active_alternatives > 1 || (!rcRollout.fStopOnJsd && active_alternatives > 0)) {
         multi_debug("rollout adding tasks");
         mt_add_tasks(MT_GetNumThreads(), RolloutLoopMT, NULL, NULL);
 
         multi_debug("rollout waiting for tasks to complete");
         MT_WaitForTasks(UpdateProgress, 2000, fAutoSaveRollout);
         multi_debug("rollout finished waiting for tasks to complete");
+        MT_WriteTrace("rollout");
     }
 
     /* Make sure final output is up to date */
@@ -1827,6 +2456,7 @@ ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves, rolloutprogressfunc
     float (**apOutput)[NUM_ROLLOUT_OUTPUTS] = g_alloca(cMoves * NUM_ROLLOUT_OUTPUTS * sizeof(float));
     float (**apStdDev)[NUM_ROLLOUT_OUTPUTS] = g_alloca(cMoves * NUM_ROLLOUT_OUTPUTS * sizeof(float));
     evalsetup(**apes) = g_alloca(cMoves * sizeof(evalsetup *));
+    evalsetup *aes = g_alloca(cMoves * sizeof(evalsetup));
     const cubeinfo(**apci) = g_alloca(cMoves * sizeof(cubeinfo *));
     cubeinfo(*aci) = g_alloca(cMoves * sizeof(cubeinfo));
     int (**apCubeDecTop) = g_alloca(cMoves * sizeof(int *));
@@ -1836,7 +2466,7 @@ ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves, rolloutprogressfunc
         apBoard[i] = (ConstTanBoard) (anBoard + i);
         apOutput[i] = &ppm[i]->arEvalMove;
         apStdDev[i] = &ppm[i]->arEvalStdDev;
-        apes[i] = &ppm[i]->esMove;
+        apes[i] = GetMoveEvalSetup(aes + i, &ppm[i]->esMove);
         apci[i] = aci + i;
         memcpy(aci + i, ppci[i], sizeof(cubeinfo));
         apCubeDecTop[i] = &fCubeDecTop;
@@ -1852,9 +2482,10 @@ ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves, rolloutprogressfunc
     nGamesDone = RolloutGeneral(apBoard,
                                 apOutput, apStdDev, NULL, apes, apci, apCubeDecTop, cMoves, TRUE, FALSE,
                                 pfRolloutProgress, pUserData);
-    /* put fMove back again */
+    /* put fMove back again, and store the rollout setups with the moves */
     for (i = 0; i < cMoves; ++i) {
         aci[i].fMove = !aci[i].fMove;
+        SetMoveEvalSetup(&ppm[i]->esMove, apes[i]);
     }
 
     if (nGamesDone < 0)
@@ -1897,5 +2528,3 @@ InvertStdDev(float ar[NUM_ROLLOUT_OUTPUTS])
     ar[OUTPUT_WINBACKGAMMON] = ar[OUTPUT_LOSEBACKGAMMON];
     ar[OUTPUT_LOSEBACKGAMMON] = r;
 }
-
-#endif
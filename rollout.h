@@ -128,6 +128,11 @@ ScoreMoveRollout(move ** ppm, cubeinfo ** ppci, int cMoves,
 
 extern void RolloutLoopMT(void *unused);
 
+extern unsigned int nRolloutShards;
+extern char *szRolloutShardCommand;
+
+extern int RolloutWorker(FILE * pfJob, FILE * pfResults);
+
 /* Quasi-random permutation array: the first index is the "generation" of the
  * permutation (0 permutes each set of 36 rolls, 1 permutes those sets of 36
  * into 1296, etc.); the second is the roll within the game (limited to QRLEN,
@@ -139,14 +144,17 @@ typedef struct {
     int nPermutationSeed;
 } perArray;
 
-EXP_LOCK_FUN(int, BasicCubefulRollout, unsigned int aanBoard[][2][25], float aarOutput[][NUM_ROLLOUT_OUTPUTS],
-             int iTurn, int iGame, const cubeinfo aci[], int afCubeDecTop[], unsigned int cci, rolloutcontext * prc,
-             rolloutstat aarsStatistics[][2], int nBasisCube, perArray * dicePerms, rngcontext * rngctxRollout,
-             FILE * logfp);
+extern int BasicCubefulRollout(unsigned int aanBoard[][2][25], float aarOutput[][NUM_ROLLOUT_OUTPUTS],
+                               int iTurn, int iGame, const cubeinfo aci[], int afCubeDecTop[], unsigned int cci, rolloutcontext * prc,
+                               rolloutstat aarsStatistics[][2], int nBasisCube, perArray * dicePerms, rngcontext * rngctxRollout,
+                               FILE * logfp);
 
 
 extern void log_cube(FILE * logfp, const char *action, int side);
 extern void log_move(FILE * logfp, const int *anMove, int side, int die0, int die1);
+extern FILE *log_game_start(const char *name, const cubeinfo * pci, int fCubeful, int fCrawfordRule,
+                            TanBoard anBoard);
+extern void log_game_over(FILE * logfp);
 extern int RolloutDice(int iTurn, int iGame, int fInitial, unsigned int anDice[2], rng * rngx, void *rngctx,
                        const int fRotate, const perArray * dicePerms);
 extern void ClosedBoard(int afClosedBoard[2], const TanBoard anBoard);
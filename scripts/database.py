@@ -19,10 +19,12 @@
 #
 
 connection = 0
+paramstyle = 'qmark'
 
 
 def PyMySQLConnect(database, user, password, hostname):
     global connection
+    global paramstyle
 
     try:
         import MySQLdb
@@ -31,6 +33,7 @@ def PyMySQLConnect(database, user, password, hostname):
         # Windows
         import pymysql as MySQLdb
 
+    paramstyle = 'format'
     hostport = hostname.strip().split(':')
     try:
         mysql_host = hostport[0]
@@ -73,8 +76,11 @@ def PyMySQLConnect(database, user, password, hostname):
 
 def PyPostgreConnect(database, user, password, hostname):
     global connection
+    global paramstyle
     import pgdb
 
+    paramstyle = 'format'
+
     postgres_host = hostname.strip()
     try:
         connection = pgdb.connect(
@@ -107,7 +113,10 @@ def PyPostgreConnect(database, user, password, hostname):
 
 def PySQLiteConnect(dbfile):
     global connection
+    global paramstyle
     from sqlite3 import dbapi2 as sqlite
+
+    paramstyle = 'qmark'
     connection = sqlite.connect(dbfile)
     return connection
 
@@ -153,3 +162,12 @@ def PyUpdateCommandReturn(stmt):
 def PyCommit():
     global connection
     connection.commit()
+
+
+def PyExecuteMany(stmt, rows):
+    global connection
+    # statements from gnubg use ? placeholders
+    if paramstyle != 'qmark':
+        stmt = stmt.replace('?', '%s')
+    cursor = connection.cursor()
+    cursor.executemany(stmt, rows)
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Headless self-play: the two players' evaluation settings play many
+ * independent money games or matches against each other on the worker
+ * threads, without touching the current match.
+ *
+ * Game (or match) i uses the rollout dice generator seeded with
+ * seed + (i << 8), so a run is reproducible whatever the number of
+ * threads.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "backgammon.h"
+#include "dice.h"
+#include "multithread.h"
+#include "rollout.h"
+
+typedef struct {
+    unsigned int cTrials;       /* money games or matches played */
+    unsigned int cGames;        /* games played */
+    double rSum;                /* sum of results for player 0 */
+    double rSumSquares;
+    unsigned int aacWins[2][4]; /* wins by drop, single, gammon, backgammon */
+} selfplayresult;
+
+typedef struct {
+    unsigned int cTrials;
+    int nMatchTo;               /* 0 for money games */
+    int fAutoCrawford;          /* the Crawford rule is in effect */
+    rng rngSelfPlay;
+    unsigned long nSeed;
+    const char *szLog;          /* prefix of SGF files, or NULL */
+    int iNext;                  /* next trial to start */
+    selfplayresult spr;         /* protected by MT_Exclusive() */
+} selfplaydata;
+
+static int
+DoublingDecision(const TanBoard anBoard, cubeinfo * pci, int fPlayer, cubedecision * pcd)
+{
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+    float arDouble[4];
+
+    if (GeneralCubeDecisionE(aarOutput, anBoard, pci, &ap[fPlayer].esCube.ec, NULL) < 0)
+        return -1;
+
+    *pcd = FindCubeDecision(arDouble, aarOutput, pci);
+
+    return 0;
+}
+
+/* Play one game from the opening roll.  On return *pfWinner is the
+ * winner, *pnPoints the points won and *pnType 0 for a dropped double,
+ * 1, 2 or 3 for a single game, gammon or backgammon. */
+
+static int
+PlayGame(selfplaydata * psp, rng * prng, rngcontext * rngctx, const int anScore[2], const int fCrawford,
+         const char *szLog, int *pfWinner, int *pnPoints, int *pnType)
+{
+    TanBoard anBoard;
+    unsigned int anDice[2];
+    int anMove[8];
+    int fMove, fCubeOwner = -1, nCube = 1, iTurn, n;
+    cubeinfo ci;
+    cubedecision cd;
+    evalcontext ec;
+    FILE *logfp = NULL;
+
+    InitBoard(anBoard, bgvDefault);
+
+    /* the opening roll decides who moves first */
+
+    do {
+        if (RollDice(anDice, prng, rngctx) < 0)
+            return -1;
+    } while (anDice[0] == anDice[1]);
+
+    fMove = anDice[1] > anDice[0];
+
+    for (iTurn = 0;; iTurn++) {
+
+        SetCubeInfo(&ci, nCube, fCubeOwner, fMove, psp->nMatchTo, anScore, fCrawford, fJacoby, FALSE, bgvDefault);
+
+        if (!iTurn && szLog)
+            logfp = log_game_start(szLog, &ci, fCubeUse, psp->fAutoCrawford, anBoard);
+
+        if (iTurn && fCubeUse && nCube < MAX_CUBE && GetDPEq(NULL, NULL, &ci)) {
+
+            if (DoublingDecision((ConstTanBoard) anBoard, &ci, fMove, &cd) < 0)
+                goto error;
+
+            if (cd == DOUBLE_TAKE || cd == REDOUBLE_TAKE || cd == DOUBLE_PASS ||
+                cd == REDOUBLE_PASS || cd == DOUBLE_BEAVER) {
+
+                log_cube(logfp, "double", fMove);
+
+                /* the opponent answers with its own settings */
+
+                if (DoublingDecision((ConstTanBoard) anBoard, &ci, !fMove, &cd) < 0)
+                    goto error;
+
+                if (cd == DOUBLE_PASS || cd == TOOGOOD_PASS || cd == REDOUBLE_PASS ||
+                    cd == TOOGOODRE_PASS || cd == OPTIONAL_DOUBLE_PASS || cd == OPTIONAL_REDOUBLE_PASS) {
+                    log_cube(logfp, "drop", !fMove);
+                    log_game_over(logfp);
+
+                    *pfWinner = fMove;
+                    *pnPoints = nCube;
+                    *pnType = 0;
+                    return 0;
+                }
+
+                log_cube(logfp, "take", !fMove);
+
+                nCube *= 2;
+                fCubeOwner = !fMove;
+                SetCubeInfo(&ci, nCube, fCubeOwner, fMove, psp->nMatchTo, anScore, fCrawford, fJacoby, FALSE,
+                            bgvDefault);
+            }
+        }
+
+        if (iTurn && RollDice(anDice, prng, rngctx) < 0)
+            goto error;
+
+        if (anDice[0] < anDice[1])
+            swap_us(anDice, anDice + 1);
+
+        memcpy(&ec, &ap[fMove].esChequer.ec, sizeof(ec));
+
+        if (FindBestMove(anMove, anDice[0], anDice[1], anBoard, &ci, &ec, ap[fMove].aamf) < 0)
+            goto error;
+
+        log_move(logfp, anMove, fMove, anDice[0], anDice[1]);
+
+        if ((n = GameStatus((ConstTanBoard) anBoard, bgvDefault))) {
+            log_game_over(logfp);
+
+            if (!psp->nMatchTo && fJacoby && fCubeOwner == -1)
+                /* gammons don't count with a centred cube */
+                *pnPoints = nCube;
+            else
+                *pnPoints = n * nCube;
+
+            *pfWinner = fMove;
+            *pnType = n;
+            return 0;
+        }
+
+        SwapSides(anBoard);
+        fMove = !fMove;
+
+        if (MT_SafeGet(&fInterrupt))
+            goto error;
+    }
+
+  error:
+    log_game_over(logfp);
+    return -1;
+}
+
+/* Play money game or match number iTrial; the result for player 0
+ * is added to *pspr. */
+
+static int
+PlayTrial(selfplaydata * psp, rng * prng, rngcontext * rngctx, unsigned int iTrial, selfplayresult * pspr)
+{
+    int anScore[2] = { 0, 0 };
+    int fCrawford = FALSE, fCrawfordPlayed = FALSE;
+    int fWinner, nPoints, nType;
+    unsigned int iGame;
+    char *szLog = NULL;
+
+    for (iGame = 0;; iGame++) {
+
+        if (psp->szLog)
+            szLog = psp->nMatchTo ? g_strdup_printf("%s-%7.7u-%2.2u.sgf", psp->szLog, iTrial, iGame) :
+                g_strdup_printf("%s-%7.7u.sgf", psp->szLog, iTrial);
+
+        if (PlayGame(psp, prng, rngctx, anScore, fCrawford, szLog, &fWinner, &nPoints, &nType) < 0) {
+            g_free(szLog);
+            return -1;
+        }
+
+        g_free(szLog);
+
+        pspr->cGames++;
+        pspr->aacWins[fWinner][nType]++;
+
+        if (!psp->nMatchTo) {
+            float r = fWinner ? -nPoints : nPoints;
+
+            pspr->rSum += r;
+            pspr->rSumSquares += r * r;
+            break;
+        }
+
+        anScore[fWinner] += nPoints;
+
+        if (anScore[fWinner] >= psp->nMatchTo) {
+            float r = fWinner ? -1.0f : 1.0f;
+
+            pspr->rSum += r;
+            pspr->rSumSquares += r * r;
+            break;
+        }
+
+        if (fCrawford)
+            fCrawfordPlayed = TRUE;
+
+        fCrawford = psp->fAutoCrawford && !fCrawfordPlayed && anScore[fWinner] == psp->nMatchTo - 1;
+    }
+
+    pspr->cTrials++;
+
+    return 0;
+}
+
+static void
+SelfPlayLoop(selfplaydata * psp)
+{
+    rngcontext *rngctx = CopyRNGContext(rngctxRollout);
+    rng rngx = psp->rngSelfPlay;
+    unsigned int i;
+
+    while ((i = (unsigned int) MT_SafeIncValue(&psp->iNext) - 1) < psp->cTrials) {
+        selfplayresult spr;
+        unsigned int j, k;
+
+        if (MT_SafeGet(&fInterrupt))
+            break;
+
+        memset(&spr, 0, sizeof(spr));
+
+        InitRNGSeed((unsigned int) (psp->nSeed + (i << 8)), rngx, rngctx);
+
+        if (PlayTrial(psp, &rngx, rngctx, i, &spr) < 0) {
+            if (!MT_SafeGet(&fInterrupt))
+                MT_SetResultFailed();
+            break;
+        }
+
+        MT_Exclusive();
+        psp->spr.cTrials += spr.cTrials;
+        psp->spr.cGames += spr.cGames;
+        psp->spr.rSum += spr.rSum;
+        psp->spr.rSumSquares += spr.rSumSquares;
+        for (j = 0; j < 2; j++)
+            for (k = 0; k < 4; k++)
+                psp->spr.aacWins[j][k] += spr.aacWins[j][k];
+        MT_Release();
+    }
+
+    g_free(rngctx);
+}
+
+/* mean and half width of the 95% confidence interval of the results */
+
+static void
+SelfPlayStatistics(const selfplayresult * pspr, float *prMean, float *prError)
+{
+    double rMean = pspr->rSum / pspr->cTrials;
+    double rVariance = 0.0;
+
+    if (pspr->cTrials > 1)
+        rVariance = (pspr->rSumSquares - pspr->cTrials * rMean * rMean) / (pspr->cTrials - 1);
+
+    *prMean = (float) rMean;
+    *prError = (float) (1.96 * sqrt(MAX(rVariance, 0.0) / pspr->cTrials));
+}
+
+static selfplaydata *pspProgress;
+
+static gboolean
+SelfPlayProgress(gpointer UNUSED(unused))
+{
+    float rMean, rError;
+
+    if (!fShowProgress || !pspProgress)
+        return TRUE;
+
+    MT_Exclusive();
+
+    if (pspProgress->spr.cTrials) {
+        SelfPlayStatistics(&pspProgress->spr, &rMean, &rError);
+        outputf("%u/%u: %+.4f +/- %.4f\r", pspProgress->spr.cTrials, pspProgress->cTrials, rMean, rError);
+        fflush(stdout);
+    }
+
+    MT_Release();
+
+    return TRUE;
+}
+
+static void
+ShowSelfPlayResult(const selfplaydata * psp)
+{
+    const selfplayresult *pspr = &psp->spr;
+    float rMean, rError;
+    int i;
+
+    if (psp->nMatchTo)
+        outputf(ngettext("%u %d-point match played (%u games).\n",
+                         "%u %d-point matches played (%u games).\n", pspr->cTrials),
+                pspr->cTrials, psp->nMatchTo, pspr->cGames);
+    else
+        outputf(ngettext("%u money game played.\n", "%u money games played.\n", pspr->cTrials), pspr->cTrials);
+
+    if (!pspr->cTrials)
+        return;
+
+    SelfPlayStatistics(pspr, &rMean, &rError);
+
+    if (psp->nMatchTo)
+        outputf(_("Matches won by %s: %.2f%% +/- %.2f%% (95%% confidence)\n"),
+                ap[0].szName, 50.0f * (1.0f + rMean), 50.0f * rError);
+    else
+        outputf(_("Equity per game for %s: %+.4f +/- %.4f (95%% confidence)\n"), ap[0].szName, rMean, rError);
+
+    outputl(_("Games won        Single  Gammon  Backgammon  Drop"));
+    for (i = 0; i < 2; i++)
+        outputf("%-16.16s %6u  %6u  %10u  %4u\n", ap[i].szName,
+                pspr->aacWins[i][1], pspr->aacWins[i][2], pspr->aacWins[i][3], pspr->aacWins[i][0]);
+}
+
+/* selfplay <games> [<match length> [<sgf prefix>]] */
+
+extern void
+CommandSelfPlay(char *sz)
+{
+    selfplaydata sp;
+    int n, nMatchTo = 0;
+    char *pch;
+
+    if ((n = ParseNumber(&sz)) < 1) {
+        outputl(_("You must specify how many games or matches to play (see `help selfplay')."));
+        return;
+    }
+
+    if (sz && *sz && (nMatchTo = ParseNumber(&sz)) < 0) {
+        outputl(_("You must specify a valid match length, or 0 for money games (see `help selfplay')."));
+        return;
+    }
+
+    if (rcRollout.rngRollout == RNG_MANUAL || rcRollout.rngRollout == RNG_FILE ||
+        rcRollout.rngRollout == RNG_RANDOM_DOT_ORG) {
+        outputl(_("Self-play needs a dice generator that can be seeded; change the rollout dice generator."));
+        return;
+    }
+
+    memset(&sp, 0, sizeof(sp));
+    sp.cTrials = (unsigned int) n;
+    sp.nMatchTo = nMatchTo;
+    sp.fAutoCrawford = fAutoCrawford;
+    sp.rngSelfPlay = rcRollout.rngRollout;
+    sp.nSeed = rcRollout.nSeed;
+    sp.szLog = (pch = NextToken(&sz)) ? pch : NULL;
+
+    pspProgress = &sp;
+    mt_add_tasks(MIN(MT_GetNumThreads(), sp.cTrials), (AsyncFun) SelfPlayLoop, &sp, NULL);
+    if (MT_WaitForTasks(SelfPlayProgress, 2000, FALSE) < 0)
+        outputl(_("Self-play failed."));
+    pspProgress = NULL;
+
+    if (fShowProgress) {
+        outputf("%79s\r", "");
+        fflush(stdout);
+    }
+
+    ShowSelfPlayResult(&sp);
+
+    ResetInterrupt();
+}
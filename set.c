@@ -75,6 +75,7 @@
 #include "drawboard.h"
 #include "format.h"
 #include "boarddim.h"
+#include "book.h"
 #include "sound.h"
 #include "openurl.h"
 
@@ -82,6 +83,8 @@
 #include "inc3d.h"
 #endif
 #include "multithread.h"
+#include "mttrace.h"
+#include "numa.h"
 
 static int iPlayerSet, iPlayerLateSet;
 
@@ -331,6 +334,14 @@ CommandSetAnalysisBackground(char *sz)
               _("Will run analysis in the background."), _("Will not run analysis in the background."));
 }
 
+extern void
+CommandSetAnalysisIncremental(char *sz)
+{
+    SetToggle("analysis incremental", &fAnalyseIncremental, sz,
+              _("Reanalysis will keep the stored luck of dice rolls."),
+              _("Reanalysis will recompute the luck of dice rolls."));
+}
+
 
 extern void
 CommandSetAnalysisCube(char *sz)
@@ -681,6 +692,24 @@ CommandSetCache(char *sz)
         outputerr(_("Evaluation cache allocation failed"));
 }
 
+extern void
+CommandSetEngineStatsLog(char *sz)
+{
+    int n = ParseNumber(&sz);
+
+    if (n < 0) {
+        outputl(_("You must specify the number of seconds between engine statistics lines (0 to disable)."));
+        return;
+    }
+
+    nEngineStatsLog = (unsigned int) n;
+
+    if (nEngineStatsLog)
+        outputf(_("Engine statistics will be logged every %u seconds.\n"), nEngineStatsLog);
+    else
+        outputl(_("Engine statistics will not be logged."));
+}
+
 #if defined(USE_MULTITHREAD)
 extern void
 CommandSetThreads(char *sz)
@@ -702,6 +731,43 @@ CommandSetThreads(char *sz)
     MT_SetNumThreads(n);
     outputf(_("The number of threads has been set to %d.\n"), n);
 }
+
+extern void
+CommandSetNuma(char *sz)
+{
+    int f = fNuma;
+
+    if (SetToggle("numa", &f, sz,
+                  _("Calculation threads will be pinned to NUMA nodes, with a copy of the neural nets on each node."),
+                  _("Calculation threads will not be pinned to NUMA nodes.")) < 0)
+        return;
+
+    MT_SetNuma(f);
+
+    if (f && NumaNodes() < 2)
+        outputl(_("Only one NUMA node was found; this has no effect on this machine."));
+}
+
+extern void
+CommandSetThreadTrace(char *sz)
+{
+    char *pch = NextToken(&sz);
+
+    if (!pch || !*pch) {
+        outputl(_("You must specify a file to write the thread trace to (or `off')."));
+        return;
+    }
+
+    if (!StrCaseCmp(pch, "off")) {
+        MTTraceSetFile(NULL);
+        outputl(_("Thread pool tracing disabled."));
+        return;
+    }
+
+    MTTraceSetFile(pch);
+    outputf(_("Thread pool activity will be traced and written to %s "
+              "at the end of each analysis or rollout.\n"), pch);
+}
 #endif
 
 extern void
@@ -724,6 +790,34 @@ CommandSetVsync3d(char *sz)
 #endif
 }
 
+extern void
+CommandSetBook(char *sz)
+{
+    char *pch = NextToken(&sz);
+    GError *error = NULL;
+    unsigned int cCube, cMove;
+
+    if (!pch || !*pch) {
+        outputl(_("You must specify a position book file (or `off')."));
+        return;
+    }
+
+    if (!StrCaseCmp(pch, "off")) {
+        BookClose();
+        outputl(_("The position book will not be used."));
+        return;
+    }
+
+    if (BookOpen(pch, &error) < 0) {
+        outputerrf("%s", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    BookCounts(&cCube, &cMove);
+    outputf(_("Using position book %s (%u cube decisions, %u move lists).\n"), pch, cCube, cMove);
+}
+
 extern void
 CommandSetBrowser(char *sz)
 {
@@ -1783,6 +1877,12 @@ CommandSetRNGMersenne(char *sz)
     SetRNG(rngSet, rngctxSet, RNG_MERSENNE, sz);
 }
 
+extern void
+CommandSetRNGPhilox(char *sz)
+{
+    SetRNG(rngSet, rngctxSet, RNG_PHILOX, sz);
+}
+
 extern void
 CommandSetRNGRandomDotOrg(char *sz)
 {
@@ -2234,6 +2334,39 @@ CommandSetRolloutInitial(char *sz)
     prcSet->fInitial = f;
 }
 
+extern void
+CommandSetRolloutShardCommand(char *sz)
+{
+    g_free(szRolloutShardCommand);
+
+    if (sz && *sz) {
+        szRolloutShardCommand = g_strdup(sz);
+        outputf(_("Rollout workers will be started with `%s'.\n"), sz);
+    } else {
+        szRolloutShardCommand = NULL;
+        outputl(_("Rollout workers will be copies of this program."));
+    }
+}
+
+extern void
+CommandSetRolloutShards(char *sz)
+{
+    int n = ParseNumber(&sz);
+
+    if (n < 0) {
+        outputl(_("You must specify how many worker processes to share rollouts between (see `help set rollout shards')."));
+        return;
+    }
+
+    nRolloutShards = (unsigned int) n;
+
+    if (n == 0)
+        outputl(_("Rollouts will be played in this process."));
+    else
+        outputf(ngettext("Rollouts will be shared between %d worker process.\n",
+                         "Rollouts will be shared between %d worker processes.\n", n), n);
+}
+
 extern void
 CommandSetRolloutSeed(char *sz)
 {
@@ -4549,6 +4682,14 @@ CommandSetSGFFolder(char *sz)
     SetFolder(&default_sgf_folder, NextToken(&sz));
 }
 
+extern void
+CommandSetSGFIndex(char *sz)
+{
+    SetToggle("sgf index", &fSGFIndex, sz,
+              _("SGF session files will be indexed when they are loaded."),
+              _("SGF session files will not be indexed when they are loaded."));
+}
+
 static int
 SetXGID(char *sz)
 {
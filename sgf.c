@@ -24,6 +24,7 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,7 @@
 #include "analysis.h"
 #include "positionid.h"
 #include "sgf.h"
+#include "multithread.h"
 
 static const char *szFile;
 static int fError;
@@ -53,50 +55,43 @@ ErrorHandler(const char *sz, int UNUSED(fParseError))
     }
 }
 
+/* Drop the game trees that are not backgammon games from a collection. */
 static void
-FreeList(listOLD * pl, int nLevel)
-{
-    /* Levels are:
-     *  0 - GameTreeSeq
-     *  1 - GameTree
-     *  2 - Sequence
-     *  3 - Node
-     *  4 - Property
-     */
+KeepBackgammonGames(listOLD * plCollection)
+{
+    listOLD *pl, *plRoot, *plProp;
 
-    if (nLevel == 1) {
-        FreeList(pl->plNext->p, 2);     /* initial sequence */
-        ListDelete(pl->plNext);
-        nLevel = 0;             /* remainder of list is more GameTreeSeqs */
-    }
+    pl = plCollection->plNext;
+    while (pl != plCollection) {
+        int fBackgammon = FALSE;
 
-    while (pl->plNext != pl) {
-        if (nLevel == 3) {
-            FreeList(((property *) pl->plNext->p)->pl, 4);
-            free(pl->plNext->p);
-        } else if (nLevel == 4)
-            free(pl->plNext->p);
-        else
-            FreeList(pl->plNext->p, nLevel + 1);
+        plRoot = ((listOLD *) ((listOLD *) pl->p)->plNext->p)->plNext->p;
 
-        ListDelete(pl->plNext);
-    }
+        for (plProp = plRoot->plNext; plProp != plRoot; plProp = plProp->plNext) {
+            property *pp = plProp->p;
 
-    free(pl);
-}
+            if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *)
+                                                                                    pp->pl->plNext->p) == 6) {
+                fBackgammon = TRUE;
+                break;
+            }
+        }
 
-static void
-FreeGameTreeSeq(listOLD * pl)
-{
+        pl = pl->plNext;
 
-    FreeList(pl, 0);
+        if (!fBackgammon) {
+            /* the tree itself is freed with the collection */
+            pl->plPrev = pl->plPrev->plPrev;
+            pl->plPrev->plNext = pl;
+        }
+    }
 }
 
 static listOLD *
 LoadCollection(char *sz)
 {
 
-    listOLD *plCollection, *pl, *plRoot, *plProp;
+    listOLD *plCollection;
     FILE *pf;
 
     fError = FALSE;
@@ -121,33 +116,11 @@ LoadCollection(char *sz)
 
     /* Traverse collection, looking for backgammon games. */
     if (plCollection) {
-        pl = plCollection->plNext;
-        while (pl != plCollection) {
-            int fBackgammon = FALSE;
-
-            plRoot = ((listOLD *) ((listOLD *) pl->p)->plNext->p)->plNext->p;
-
-            for (plProp = plRoot->plNext; plProp != plRoot; plProp = plProp->plNext) {
-                property *pp = plProp->p;
-
-                if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *)
-                                                                                        pp->pl->plNext->p) == 6) {
-                    fBackgammon = TRUE;
-                    break;
-                }
-            }
-
-            pl = pl->plNext;
-
-            if (!fBackgammon) {
-                FreeList(pl->plPrev->p, 1);
-                ListDelete(pl->plPrev);
-            }
-        }
+        KeepBackgammonGames(plCollection);
 
         if (ListEmpty(plCollection)) {
             ErrorHandler(_("warning: no backgammon games in SGF file"), TRUE);
-            free(plCollection);
+            SGFFree(plCollection);
             plCollection = NULL;
         }
     }
@@ -671,13 +644,16 @@ static void
 RestoreRollout(move * pm, const char *sz)
 {
     unsigned int n;
+    evalsetup es;
 
-    pm->esMove.et = EVAL_ROLLOUT;
+    memset(&es, 0, sizeof(evalsetup));
+    es.et = EVAL_ROLLOUT;
     RestoreRolloutScore(pm, sz);
     RestoreRolloutTrials(&n, sz);
     RestoreRolloutOutput(pm->arEvalMove, sz, "Output");
     RestoreRolloutOutput(pm->arEvalStdDev, sz, "StdDev");
-    RestoreRolloutRolloutContext(&pm->esMove.rc, sz);
+    RestoreRolloutRolloutContext(&es.rc, sz);
+    SetMoveEvalSetup(&pm->esMove, &es);
 
 }
 
@@ -838,11 +814,12 @@ static void
 RestoreExtendedRollout(move * pm, char *sz)
 {
 
-    evalsetup *pes = &pm->esMove;
+    evalsetup es, *pes = &es;
 
     /* we assume new versions will still begin with Score 2 floats
      * Trials int 
      */
+    memset(&es, 0, sizeof(evalsetup));
     pes->et = EVAL_ROLLOUT;
     RestoreRolloutScore(pm, sz);
     RestoreRolloutTrials(&pes->rc.nGamesDone, sz);
@@ -852,6 +829,7 @@ RestoreExtendedRollout(move * pm, char *sz)
         RestoreRolloutInternals(pes, sz);
         RestoreExtendedRolloutContext(&pes->rc, sz);
     }
+    SetMoveEvalSetup(&pm->esMove, pes);
 }
 
 static void
@@ -955,6 +933,7 @@ RestoreMoveAnalysis(property * pp, int fPlayer,
     int i;
     int fUsePrune = 0;
     TanBoard anBoardMove;
+    moveevalsetup mesChequer;
     int ver;
     *piMove = atoi(pl->p);
 
@@ -972,7 +951,8 @@ RestoreMoveAnalysis(property * pp, int fPlayer,
 
     pm = pml->amMoves = g_malloc0(pml->cMoves * sizeof(move));
 
-    pesChequer->et = EVAL_NONE;
+    pesChequer->et = mesChequer.et = EVAL_NONE;
+    mesChequer.nBook = 0;
 
     for (pl = pp->pl->plNext->plNext; pl->p; pl = pl->plNext, pm++) {
         char *pc, *pch, ch;
@@ -1065,8 +1045,10 @@ RestoreMoveAnalysis(property * pp, int fPlayer,
 
         /* save "largest" evalsetup */
 
-        if (cmp_evalsetup(pesChequer, &pm->esMove) < 0)
-            memcpy(pesChequer, &pm->esMove, sizeof(evalsetup));
+        if (cmp_moveevalsetup(&mesChequer, &pm->esMove) < 0) {
+            mesChequer = pm->esMove;
+            GetMoveEvalSetup(pesChequer, &pm->esMove);
+        }
 
     }
 }
@@ -1441,7 +1423,7 @@ CommandLoadGame(char *sz)
 
         RestoreGame(pl->plNext->p);
 
-        FreeGameTreeSeq(pl);
+        SGFFree(pl);
 
         UpdateSettings();
 
@@ -1496,7 +1478,7 @@ CommandLoadPosition(char *sz)
 
         RestoreGame(pl->plNext->p);
 
-        FreeGameTreeSeq(pl);
+        SGFFree(pl);
 
         UpdateSettings();
 
@@ -1516,6 +1498,81 @@ CommandLoadPosition(char *sz)
 }
 
 
+/* Replace the current match with the games about to be restored. */
+static int
+BeginLoadMatch(void)
+{
+    /* FIXME make sure the root nodes have MI properties; if not,
+     * we're loading a session. */
+    if (!get_input_discard())
+        return FALSE;
+#if USE_GTK
+    if (fX) {                   /* Clear record to avoid ugly updates */
+        GTKClearMoveRecord();
+        GTKFreeze();
+    }
+#endif
+
+    FreeMatch();
+    ClearMatch();
+
+    return TRUE;
+}
+
+static void
+EndLoadMatch(char *sz, int nGames)
+{
+    listOLD *pl;
+    int nMoves = 0;
+
+    UpdateSettings();
+
+#if USE_GTK
+    if (fX) {
+        GTKThaw();
+        GTKSet(ap);
+    }
+#endif
+
+    setDefaultFileName(sz);
+    if (fUseKeyNames)
+        SmartSit();
+
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
+        moverecord *pmr = pl->p;
+
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+        case MOVE_DOUBLE:
+        case MOVE_TAKE:
+        case MOVE_DROP:
+            nMoves++;
+            break;
+        default:
+            /* do not count the other pseudo-moves */
+            break;
+        }
+    }
+
+    if (nGames == 1 && nMoves == 1) {
+        moverecord *pmr;
+
+        CommandFirstMove(NULL);
+        pl = plGame->plNext;
+        pmr = pl->p;
+        while (pmr->mt != MOVE_NORMAL && pmr->mt != MOVE_DOUBLE) {
+            CommandNext(NULL);
+            pl = pl->plNext;
+            pmr = pl->p;
+        }
+        CommandPrevious(NULL);
+    } else if (fGotoFirstGame)
+        CommandFirstGame(NULL);
+}
+
+static GArray *GetIndex(const char *szSGF);
+static void FreeIndex(GArray * pa);
+
 extern void
 CommandLoadMatch(char *sz)
 {
@@ -1529,74 +1586,626 @@ CommandLoadMatch(char *sz)
     }
 
     if ((pl = LoadCollection(sz))) {
-        int nGames = 0, nMoves = 0;
+        int nGames = 0;
 
-        /* FIXME make sure the root nodes have MI properties; if not,
-         * we're loading a session. */
-        if (!get_input_discard())
+        if (!BeginLoadMatch()) {
+            SGFFree(pl);
             return;
-#if USE_GTK
-        if (fX) {               /* Clear record to avoid ugly updates */
-            GTKClearMoveRecord();
-            GTKFreeze();
         }
-#endif
-
-        FreeMatch();
-        ClearMatch();
 
         for (pl = pl->plNext; pl->p; pl = pl->plNext) {
             RestoreGame(pl->p);
             nGames++;
         }
 
-        FreeGameTreeSeq(pl);
+        SGFFree(pl);
 
-        UpdateSettings();
+        EndLoadMatch(sz, nGames);
 
-#if USE_GTK
-        if (fX) {
-            GTKThaw();
-            GTKSet(ap);
+        /* write the index of a session file the first time it is loaded */
+        if (fSGFIndex && nGames > 1 && strcmp(sz, "-")) {
+            GArray *pa = GetIndex(sz);
+
+            if (pa)
+                FreeIndex(pa);
         }
-#endif
+    }
+}
 
-        setDefaultFileName(sz);
-        if (fUseKeyNames)
-            SmartSit();
+/* Load each file in turn as "load match" does, timing the parse of the
+ * file and the restoring of its games separately.  The last file stays
+ * loaded. */
+extern void
+CommandLoadBenchmark(char *sz)
+{
+    char *szSGF;
+    int cFiles = 0;
+    unsigned int cGames = 0;
+    gint64 cbTotal = 0, usParse = 0, usRestore = 0, usTotal;
 
-        for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
-            moverecord *pmr = pl->p;
+    if (!sz || !*sz) {
+        outputl(_("You must specify the files to load (see `help load benchmark')."));
+        return;
+    }
 
-            switch (pmr->mt) {
-            case MOVE_NORMAL:
-            case MOVE_DOUBLE:
-            case MOVE_TAKE:
-            case MOVE_DROP:
-                nMoves++;
-                break;
-            default:
-                /* do not count the other pseudo-moves */
+    while (!fInterrupt && (szSGF = NextToken(&sz))) {
+        GStatBuf st;
+        listOLD *plCollection, *pl;
+        gint64 usStart;
+        int nGames = 0;
+
+        if (g_stat(szSGF, &st) < 0) {
+            outputerr(szSGF);
+            continue;
+        }
+
+        usStart = g_get_monotonic_time();
+        plCollection = LoadCollection(szSGF);
+        usParse += g_get_monotonic_time() - usStart;
+
+        if (!plCollection)
+            continue;
+
+        if (!BeginLoadMatch()) {
+            SGFFree(plCollection);
+            break;
+        }
+
+        usStart = g_get_monotonic_time();
+        for (pl = plCollection->plNext; pl->p; pl = pl->plNext) {
+            RestoreGame(pl->p);
+            nGames++;
+        }
+        usRestore += g_get_monotonic_time() - usStart;
+
+        SGFFree(plCollection);
+        EndLoadMatch(szSGF, nGames);
+
+        cFiles++;
+        cGames += (unsigned int) nGames;
+        cbTotal += (gint64) st.st_size;
+    }
+
+    usTotal = usParse + usRestore;
+
+    outputf(_("%d files, %u games, %.1f MB\n"), cFiles, cGames, cbTotal / 1e6);
+    outputf("%-10s : %8.3f s\n", _("Parse"), usParse / 1e6);
+    outputf("%-10s : %8.3f s\n", _("Restore"), usRestore / 1e6);
+    outputf("%-10s : %8.3f s (%.1f MB/s, %.0f games/s)\n", _("Total"), usTotal / 1e6,
+            usTotal ? cbTotal / (double) usTotal : 0.0, usTotal ? cGames * 1e6 / usTotal : 0.0);
+}
+
+struct _sgfstream {
+    FILE *pf;
+    char *szFile;
+    GString *gsTree;            /* text of the game tree being parsed */
+    listOLD *plCollection;      /* parsed game waiting to be restored */
+    char *szError;              /* first parse error in that game */
+    int fPending;               /* a worker is parsing the next game */
+};
+
+static void
+StreamErrorHandler(const char *sz, int UNUSED(fParseError), void *p)
+{
+    sgfstream *pss = p;
+
+    if (!pss->szError)
+        pss->szError = g_strdup(sz);
+}
+
+/* Read the text of the next top level game tree, skipping anything
+ * between trees.  Brackets inside property values do not count. */
+static int
+ReadTreeText(FILE * pf, GString * gs)
+{
+    int ch, nDepth = 0, fValue = FALSE;
+
+    g_string_truncate(gs, 0);
+
+    while ((ch = getc(pf)) != EOF) {
+        if (!nDepth && ch != '(')
+            continue;
+
+        g_string_append_c(gs, (char) ch);
+
+        if (fValue) {
+            if (ch == '\\') {
+                if ((ch = getc(pf)) == EOF)
+                    break;
+                g_string_append_c(gs, (char) ch);
+            } else if (ch == ']')
+                fValue = FALSE;
+        } else if (ch == '[')
+            fValue = TRUE;
+        else if (ch == '(')
+            nDepth++;
+        else if (ch == ')' && !--nDepth)
+            return TRUE;
+    }
+
+    /* let the parser report a truncated tree */
+    return gs->len > 0;
+}
+
+static void
+StreamParseTree(sgfstream * pss)
+{
+    listOLD *pl;
+
+    while (ReadTreeText(pss->pf, pss->gsTree)) {
+        if (!(pl = SGFParseBufferFull(pss->gsTree->str, pss->gsTree->len, StreamErrorHandler, pss)))
+            continue;
+
+        KeepBackgammonGames(pl);
+
+        if (!ListEmpty(pl)) {
+            pss->plCollection = pl;
+            return;
+        }
+
+        SGFFree(pl);
+    }
+}
+
+static void
+StreamWait(sgfstream * pss)
+{
+    if (pss->fPending) {
+        MT_WaitForTasks(NULL, 10, FALSE);
+        pss->fPending = FALSE;
+    }
+}
+
+extern sgfstream *
+SGFStreamOpen(const char *szFile)
+{
+    sgfstream *pss;
+    FILE *pf;
+
+    if (!(pf = g_fopen(szFile, "r"))) {
+        outputerr(szFile);
+        return NULL;
+    }
+
+    pss = g_new0(sgfstream, 1);
+    pss->pf = pf;
+    pss->szFile = g_strdup(szFile);
+    pss->gsTree = g_string_new(NULL);
+
+    mt_add_tasks(1, (AsyncFun) StreamParseTree, pss, NULL);
+    pss->fPending = TRUE;
+
+    return pss;
+}
+
+extern int
+SGFStreamNextGame(sgfstream * pss)
+{
+    listOLD *pl, *plCollection;
+
+    StreamWait(pss);
+
+    if (pss->szError) {
+        outputerrf("%s: %s", pss->szFile, pss->szError);
+        g_free(pss->szError);
+        pss->szError = NULL;
+    }
+
+    if (!(plCollection = pss->plCollection))
+        return FALSE;
+
+    pss->plCollection = NULL;
+
+    /* pss belongs to the worker until StreamWait */
+    mt_add_tasks(1, (AsyncFun) StreamParseTree, pss, NULL);
+    pss->fPending = TRUE;
+
+    FreeMatch();
+    ClearMatch();
+
+    for (pl = plCollection->plNext; pl->p; pl = pl->plNext)
+        RestoreGame(pl->p);
+
+    SGFFree(plCollection);
+
+    return TRUE;
+}
+
+extern void
+SGFStreamClose(sgfstream * pss)
+{
+    StreamWait(pss);
+
+    if (pss->plCollection)
+        SGFFree(pss->plCollection);
+
+    fclose(pss->pf);
+    g_string_free(pss->gsTree, TRUE);
+    g_free(pss->szError);
+    g_free(pss->szFile);
+    g_free(pss);
+}
+
+/* The index of an SGF file foo.sgf is kept in foo.sgf.idx.  After a
+ * header recording the size and time of the SGF file it indexes, it
+ * has one line per backgammon game with the offset and length of its
+ * game tree and the match information, result and players from its
+ * root node, separated by tabs. */
+#define SGF_INDEX_HEADER "# GNU Backgammon SGF index 1"
+
+typedef struct {
+    long iOffset, cch;
+    int nMatchTo, anScore[2];
+    char *szResult;
+    char *aszPlayer[2];
+} sgfindexentry;
+
+static char *
+IndexText(const char *sz)
+{
+    char *pch, *szText = g_strdup(sz ? sz : "");
+
+    for (pch = szText; *pch; pch++)
+        if (*pch == '\t' || *pch == '\n' || *pch == '\r')
+            *pch = ' ';
+
+    return szText;
+}
+
+static void
+IndexRootNode(sgfindexentry * pie, listOLD * plTree)
+{
+    listOLD *pl, *plRoot = ((listOLD *) ((listOLD *) plTree->plNext->p)->plNext->p);
+    const char *szResult = NULL, *aszPlayer[2] = { NULL, NULL };
+
+    pie->nMatchTo = pie->anScore[0] = pie->anScore[1] = 0;
+
+    for (pl = plRoot->plNext; pl != plRoot; pl = pl->plNext) {
+        property *pp = pl->p;
+        listOLD *plValue;
+
+        if (!pp->pl->plNext->p)
+            continue;
+
+        if (pp->ach[0] == 'P' && pp->ach[1] == 'W')
+            aszPlayer[0] = pp->pl->plNext->p;
+        else if (pp->ach[0] == 'P' && pp->ach[1] == 'B')
+            aszPlayer[1] = pp->pl->plNext->p;
+        else if (pp->ach[0] == 'R' && pp->ach[1] == 'E')
+            szResult = pp->pl->plNext->p;
+        else if (pp->ach[0] == 'M' && pp->ach[1] == 'I')
+            for (plValue = pp->pl->plNext; plValue->p; plValue = plValue->plNext) {
+                const char *pch = plValue->p;
+
+                if (!strncmp(pch, "length:", 7))
+                    pie->nMatchTo = atoi(pch + 7);
+                else if (!strncmp(pch, "ws:", 3))
+                    pie->anScore[0] = atoi(pch + 3);
+                else if (!strncmp(pch, "bs:", 3))
+                    pie->anScore[1] = atoi(pch + 3);
+            }
+    }
+
+    pie->szResult = IndexText(szResult);
+    pie->aszPlayer[0] = IndexText(aszPlayer[0]);
+    pie->aszPlayer[1] = IndexText(aszPlayer[1]);
+}
+
+static void
+FreeIndex(GArray * pa)
+{
+    guint i;
+
+    for (i = 0; i < pa->len; i++) {
+        sgfindexentry *pie = &g_array_index(pa, sgfindexentry, i);
+
+        g_free(pie->szResult);
+        g_free(pie->aszPlayer[0]);
+        g_free(pie->aszPlayer[1]);
+    }
+
+    g_array_free(pa, TRUE);
+}
+
+/* Read the index of szSGF, or return NULL if there is none or it is out
+ * of date. */
+static GArray *
+ReadIndex(const char *szSGF)
+{
+    GStatBuf st;
+    GArray *pa = NULL;
+    char *szIndex, *pchContents, **aszLines;
+    gint64 nSize, nTime;
+    int i;
+
+    if (g_stat(szSGF, &st) < 0)
+        return NULL;
+
+    szIndex = g_strconcat(szSGF, ".idx", NULL);
+
+    if (!g_file_get_contents(szIndex, &pchContents, NULL, NULL)) {
+        g_free(szIndex);
+        return NULL;
+    }
+
+    aszLines = g_strsplit(pchContents, "\n", -1);
+
+    if (aszLines[0] && !strcmp(aszLines[0], SGF_INDEX_HEADER) && aszLines[1] &&
+        sscanf(aszLines[1], "%" G_GINT64_FORMAT " %" G_GINT64_FORMAT, &nSize, &nTime) == 2 &&
+        nSize == (gint64) st.st_size && nTime == (gint64) st.st_mtime) {
+        pa = g_array_new(FALSE, FALSE, sizeof(sgfindexentry));
+
+        for (i = 2; aszLines[i]; i++) {
+            char **asz;
+            sgfindexentry ie;
+
+            if (!*aszLines[i])
+                continue;
+
+            asz = g_strsplit(aszLines[i], "\t", 8);
+
+            if (g_strv_length(asz) != 8) {
+                /* damaged; build it again */
+                g_strfreev(asz);
+                FreeIndex(pa);
+                pa = NULL;
                 break;
             }
+
+            ie.iOffset = strtol(asz[0], NULL, 10);
+            ie.cch = strtol(asz[1], NULL, 10);
+            ie.nMatchTo = atoi(asz[2]);
+            ie.anScore[0] = atoi(asz[3]);
+            ie.anScore[1] = atoi(asz[4]);
+            ie.szResult = g_strdup(asz[5]);
+            ie.aszPlayer[0] = g_strdup(asz[6]);
+            ie.aszPlayer[1] = g_strdup(asz[7]);
+            g_array_append_val(pa, ie);
+
+            g_strfreev(asz);
         }
+    }
 
-        if (nGames == 1 && nMoves == 1) {
-            moverecord *pmr;
+    g_strfreev(aszLines);
+    g_free(pchContents);
+    g_free(szIndex);
 
-            CommandFirstMove(NULL);
-            pl = plGame->plNext;
-            pmr = pl->p;
-            while (pmr->mt != MOVE_NORMAL && pmr->mt != MOVE_DOUBLE) {
-                CommandNext(NULL);
-                pl = pl->plNext;
-                pmr = pl->p;
-            }
-            CommandPrevious(NULL);
-        } else if (fGotoFirstGame)
-            CommandFirstGame(NULL);
+    return pa;
+}
+
+static void
+WriteIndex(const char *szSGF, GArray * pa)
+{
+    GStatBuf st;
+    FILE *pf;
+    char *szIndex;
+    guint i;
+
+    if (g_stat(szSGF, &st) < 0)
+        return;
+
+    szIndex = g_strconcat(szSGF, ".idx", NULL);
+
+    if (!(pf = g_fopen(szIndex, "w"))) {
+        /* the index is only a cache; a read-only folder is not an error */
+        g_free(szIndex);
+        return;
+    }
+
+    fprintf(pf, "%s\n%" G_GINT64_FORMAT " %" G_GINT64_FORMAT "\n", SGF_INDEX_HEADER,
+            (gint64) st.st_size, (gint64) st.st_mtime);
+
+    for (i = 0; i < pa->len; i++) {
+        sgfindexentry *pie = &g_array_index(pa, sgfindexentry, i);
+
+        fprintf(pf, "%ld\t%ld\t%d\t%d\t%d\t%s\t%s\t%s\n", pie->iOffset, pie->cch,
+                pie->nMatchTo, pie->anScore[0], pie->anScore[1],
+                pie->szResult, pie->aszPlayer[0], pie->aszPlayer[1]);
+    }
+
+    if (fclose(pf))
+        outputerr(szIndex);
+
+    g_free(szIndex);
+}
+
+/* Scan szSGF a game tree at a time and write its index. */
+static GArray *
+BuildIndex(const char *szSGF)
+{
+    FILE *pf;
+    GString *gs;
+    GArray *pa;
+    listOLD *plCollection;
+
+    if (!(pf = g_fopen(szSGF, "rb"))) {
+        outputerr(szSGF);
+        return NULL;
+    }
+
+    fError = FALSE;
+    szFile = szSGF;
+    SGFErrorHandler = ErrorHandler;
+
+    pa = g_array_new(FALSE, FALSE, sizeof(sgfindexentry));
+    gs = g_string_new(NULL);
 
+    while (ReadTreeText(pf, gs)) {
+        long iEnd = ftell(pf);
+
+        if (!(plCollection = SGFParseBuffer(gs->str, gs->len)))
+            continue;
+
+        KeepBackgammonGames(plCollection);
+
+        if (!ListEmpty(plCollection)) {
+            sgfindexentry ie;
+
+            IndexRootNode(&ie, plCollection->plNext->p);
+            /* the tree text runs from its opening bracket to iEnd */
+            ie.iOffset = iEnd - (long) gs->len;
+            ie.cch = (long) gs->len;
+            g_array_append_val(pa, ie);
+        }
+
+        SGFFree(plCollection);
+    }
+
+    fclose(pf);
+    g_string_free(gs, TRUE);
+
+    WriteIndex(szSGF, pa);
+
+    return pa;
+}
+
+static GArray *
+GetIndex(const char *szSGF)
+{
+    GArray *pa;
+
+    if ((pa = ReadIndex(szSGF)))
+        return pa;
+
+    outputf(_("Indexing %s...\n"), szSGF);
+    return BuildIndex(szSGF);
+}
+
+extern void
+CommandLoadGames(char *sz)
+{
+    char *szSGF;
+    int iFirst, iLast, i, nGames = 0, fReadError = FALSE;
+    GArray *pa;
+    GPtrArray *pCollections;
+    GString *gs;
+    FILE *pf;
+
+    if (!(szSGF = NextToken(&sz)) || !*szSGF) {
+        outputl(_("You must specify a file to load from (see `help load games')."));
+        return;
+    }
+
+    if ((iFirst = ParseNumber(&sz)) < 1) {
+        outputl(_("You must specify the number of the first game to load (see `help load games')."));
+        return;
+    }
+
+    if ((iLast = ParseNumber(&sz)) == INT_MIN)
+        iLast = iFirst;
+    else if (iLast < iFirst) {
+        outputl(_("The last game to load must not come before the first."));
+        return;
+    }
+
+    if (!(pa = GetIndex(szSGF)))
+        return;
+
+    if ((guint) iFirst > pa->len) {
+        outputf(_("%s only holds %u games.\n"), szSGF, pa->len);
+        FreeIndex(pa);
+        return;
+    }
+
+    if ((guint) iLast > pa->len)
+        iLast = (int) pa->len;
+
+    if (!(pf = g_fopen(szSGF, "rb"))) {
+        outputerr(szSGF);
+        FreeIndex(pa);
+        return;
+    }
+
+    fError = FALSE;
+    szFile = szSGF;
+    SGFErrorHandler = ErrorHandler;
+
+    /* read and parse every game before touching the current match, so
+     * that a read error or unusable games leave it as it was */
+    gs = g_string_new(NULL);
+    pCollections = g_ptr_array_new();
+
+    for (i = iFirst - 1; i < iLast; i++) {
+        sgfindexentry *pie = &g_array_index(pa, sgfindexentry, i);
+        listOLD *plCollection, *pl;
+
+        g_string_set_size(gs, (gsize) pie->cch);
+
+        if (fseek(pf, pie->iOffset, SEEK_SET) || fread(gs->str, 1, gs->len, pf) != gs->len) {
+            outputerr(szSGF);
+            fReadError = TRUE;
+            break;
+        }
+
+        if (!(plCollection = SGFParseBuffer(gs->str, gs->len)))
+            continue;
+
+        KeepBackgammonGames(plCollection);
+
+        for (pl = plCollection->plNext; pl->p; pl = pl->plNext)
+            nGames++;
+
+        g_ptr_array_add(pCollections, plCollection);
+    }
+
+    g_string_free(gs, TRUE);
+    fclose(pf);
+    FreeIndex(pa);
+
+    if (fReadError || !nGames || !BeginLoadMatch()) {
+        if (!fReadError && !nGames)
+            outputf(_("No games could be loaded from %s.\n"), szSGF);
+        for (i = 0; i < (int) pCollections->len; i++)
+            SGFFree(g_ptr_array_index(pCollections, i));
+        g_ptr_array_free(pCollections, TRUE);
+        return;
+    }
+
+    for (i = 0; i < (int) pCollections->len; i++) {
+        listOLD *plCollection = g_ptr_array_index(pCollections, i), *pl;
+
+        for (pl = plCollection->plNext; pl->p; pl = pl->plNext)
+            RestoreGame(pl->p);
+
+        SGFFree(plCollection);
     }
+    g_ptr_array_free(pCollections, TRUE);
+
+    EndLoadMatch(szSGF, nGames);
+}
+
+extern void
+CommandShowGames(char *sz)
+{
+    char *szSGF;
+    GArray *pa;
+    guint i;
+
+    if (!(szSGF = NextToken(&sz)) || !*szSGF) {
+        outputl(_("You must specify an SGF file (see `help show games')."));
+        return;
+    }
+
+    if (!(pa = GetIndex(szSGF)))
+        return;
+
+    outputf("%5s  %6s  %7s  %-10s  %s\n", _("Game"), _("Length"), _("Score"), _("Result"), _("Players"));
+
+    for (i = 0; i < pa->len; i++) {
+        sgfindexentry *pie = &g_array_index(pa, sgfindexentry, i);
+        char szScore[32];
+
+        sprintf(szScore, "%d-%d", pie->anScore[0], pie->anScore[1]);
+
+        if (pie->nMatchTo)
+            outputf("%5u  %6d  %7s  %-10s  %s - %s\n", i + 1, pie->nMatchTo, szScore,
+                    pie->szResult, pie->aszPlayer[0], pie->aszPlayer[1]);
+        else
+            outputf("%5u  %6s  %7s  %-10s  %s - %s\n", i + 1, _("money"), szScore,
+                    pie->szResult, pie->aszPlayer[0], pie->aszPlayer[1]);
+    }
+
+    FreeIndex(pa);
 }
 
 static void
@@ -1868,12 +2477,15 @@ WriteMoveAnalysis(FILE * pf, int fPlayer, movelist * pml, unsigned int iMove)
                     pml->amMoves[i].esMove.ec.fDeterministic, buffer, pml->amMoves[i].esMove.ec.fUsePrune);
             break;
 
-        case EVAL_ROLLOUT:
-            WriteRolloutAnalysis(pf, 1, pml->amMoves[i].rScore,
-                                 pml->amMoves[i].rScore2,
-                                 pml->amMoves[i].arEvalMove, 0,
-                                 pml->amMoves[i].arEvalStdDev, 0, &pml->amMoves[i].esMove);
-            break;
+        case EVAL_ROLLOUT:{
+                evalsetup es;
+
+                WriteRolloutAnalysis(pf, 1, pml->amMoves[i].rScore,
+                                     pml->amMoves[i].rScore2,
+                                     pml->amMoves[i].arEvalMove, 0,
+                                     pml->amMoves[i].arEvalStdDev, 0, GetMoveEvalSetup(&es, &pml->amMoves[i].esMove));
+                break;
+            }
 
 
 
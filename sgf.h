@@ -43,6 +43,30 @@ extern void (*SGFErrorHandler) (const char *szMessage, int fParseError);
  * (if set), or complains to stderr (otherwise). */
 extern listOLD *SGFParse(FILE * pf);
 
+/* As SGFParse, for SGF text held in memory. */
+extern listOLD *SGFParseBuffer(const char *pch, size_t cch);
+
+/* As SGFParseBuffer, but errors go to pfError (with pErrorData) instead
+ * of SGFErrorHandler, so that it may be called from any thread. */
+typedef void (*sgferrorfunc) (const char *szMessage, int fParseError, void *pErrorData);
+
+extern listOLD *SGFParseBufferFull(const char *pch, size_t cch, sgferrorfunc pfError, void *pErrorData);
+
+/* Free a collection returned by SGFParse or SGFParseBuffer.  All the
+ * lists, properties and values in it share the collection's memory, so
+ * they must not be freed or unlinked with ListDelete individually. */
+extern void SGFFree(listOLD * plCollection);
+
+/* Read the backgammon games of an SGF file one at a time, so that only
+ * one game is ever held in memory.  SGFStreamNextGame replaces the
+ * current match with the next game and returns FALSE when there are no
+ * more; the following game is parsed by a worker thread meanwhile. */
+typedef struct _sgfstream sgfstream;
+
+extern sgfstream *SGFStreamOpen(const char *szFile);
+extern int SGFStreamNextGame(sgfstream * pss);
+extern void SGFStreamClose(sgfstream * pss);
+
 /* The following properties are defined for GNU Backgammon SGF files:
  * 
  * A  (M)  - analysis (gnubg private)
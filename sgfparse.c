@@ -0,0 +1,556 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SGF reader.  The whole collection is parsed in one pass over the text
+ * into the list structure described in sgf.h.  Every list cell, property
+ * and value string of a collection is carved out of a few large blocks
+ * owned by the collection, so loading an analysed match costs a handful
+ * of allocations instead of one per token and SGFFree releases it all
+ * at once.
+ *
+ * Lexically this accepts what the old flex scanner did: property
+ * identifiers may contain lower case letters (only the upper case ones
+ * count), words of lower case letters alone are ignored, and inside a
+ * value "\]" stands for "]", a backslash before a newline removes both,
+ * any other backslash is kept for the caller to interpret and NUL bytes
+ * are dropped.
+ */
+
+#include "config.h"
+#include "common.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "list.h"
+#include "sgf.h"
+
+#define SGF_BLOCK 65536
+#define SGF_ALIGN 16
+#define SGF_MAX_DEPTH 1000
+
+typedef struct _sgfblock {
+    struct _sgfblock *pbNext;
+} sgfblock;
+
+typedef struct {
+    listOLD lCollection;        /* must come first; see SGFFree() */
+    sgfblock *pbBlocks;
+    char *pchFree;
+    size_t cbFree;
+} sgfcollection;
+
+typedef struct {
+    const char *pch, *pchEnd;
+    sgfcollection *psc;
+    int nLine;
+    int nDepth;
+    sgferrorfunc pfError;       /* NULL to use SGFErrorHandler */
+    void *pErrorData;
+} sgfreader;
+
+void (*SGFErrorHandler) (const char *, int) = NULL;
+
+static void
+ReaderError(sgfreader * pr, const char *sz, int fParseError)
+{
+    char *szMessage = g_strdup_printf(_("line %d: %s"), pr->nLine, sz);
+
+    if (pr->pfError)
+        pr->pfError(szMessage, fParseError, pr->pErrorData);
+    else if (SGFErrorHandler)
+        SGFErrorHandler(szMessage, fParseError);
+    else
+        fprintf(stderr, "%s\n", szMessage);
+
+    g_free(szMessage);
+}
+
+static void *
+ArenaAlloc(sgfcollection * psc, size_t cb)
+{
+    void *p;
+
+    cb = (cb + SGF_ALIGN - 1) & ~(size_t) (SGF_ALIGN - 1);
+
+    if (cb > psc->cbFree) {
+        size_t cbBlock = MAX(cb, SGF_BLOCK);
+        sgfblock *pb = g_malloc(SGF_ALIGN + cbBlock);
+
+        pb->pbNext = psc->pbBlocks;
+        psc->pbBlocks = pb;
+        psc->pchFree = (char *) pb + SGF_ALIGN;
+        psc->cbFree = cbBlock;
+    }
+
+    p = psc->pchFree;
+    psc->pchFree += cb;
+    psc->cbFree -= cb;
+
+    return p;
+}
+
+/* Give back the unused tail of the most recent allocation. */
+static void
+ArenaShrink(sgfcollection * psc, void *p, size_t cbOld, size_t cbNew)
+{
+    cbOld = (cbOld + SGF_ALIGN - 1) & ~(size_t) (SGF_ALIGN - 1);
+    cbNew = (cbNew + SGF_ALIGN - 1) & ~(size_t) (SGF_ALIGN - 1);
+
+    if ((char *) p + cbOld == psc->pchFree) {
+        psc->pchFree -= cbOld - cbNew;
+        psc->cbFree += cbOld - cbNew;
+    }
+}
+
+static listOLD *
+NewList(sgfcollection * psc)
+{
+    listOLD *pl = ArenaAlloc(psc, sizeof(listOLD));
+
+    pl->plPrev = pl->plNext = pl;
+    pl->p = NULL;
+
+    return pl;
+}
+
+static void
+Append(sgfcollection * psc, listOLD * pl, void *p)
+{
+    listOLD *plNew = ArenaAlloc(psc, sizeof(listOLD));
+
+    plNew->p = p;
+    plNew->plNext = pl;
+    plNew->plPrev = pl->plPrev;
+    pl->plPrev->plNext = plNew;
+    pl->plPrev = plNew;
+}
+
+/* Skip white space and words of lower case letters; return the next
+ * significant character or EOF. */
+static int
+Peek(sgfreader * pr)
+{
+    while (pr->pch < pr->pchEnd) {
+        char ch = *pr->pch;
+
+        if (ch == '\n')
+            pr->nLine++;
+        else if (!g_ascii_isspace(ch)) {
+            const char *pch;
+
+            if (!g_ascii_islower(ch))
+                return (unsigned char) ch;
+
+            for (pch = pr->pch; pch < pr->pchEnd && g_ascii_islower(*pch); pch++);
+
+            if (pch < pr->pchEnd && g_ascii_isupper(*pch))
+                return (unsigned char) ch;      /* start of an identifier */
+
+            pr->pch = pch;
+            continue;
+        }
+
+        pr->pch++;
+    }
+
+    return EOF;
+}
+
+static int
+IsIdentifier(int ch)
+{
+    return ch != EOF && (g_ascii_isupper(ch) || g_ascii_islower(ch));
+}
+
+/* Read a value after its opening bracket. */
+static char *
+ReadValue(sgfreader * pr)
+{
+    const char *pch, *pchClose;
+    char *sz, *pchDest;
+    size_t cch;
+
+    for (pch = pr->pch; pch < pr->pchEnd && *pch != ']'; pch++)
+        if (*pch == '\\' && pch + 1 < pr->pchEnd)
+            pch++;
+
+    pchClose = pch;
+    cch = (size_t) (pchClose - pr->pch);
+    pchDest = sz = ArenaAlloc(pr->psc, cch + 1);
+
+    for (pch = pr->pch; pch < pchClose; pch++) {
+        if (*pch == '\\' && pch + 1 < pchClose) {
+            if (*++pch == '\n') {
+                pr->nLine++;
+                continue;
+            }
+            if (*pch != ']')
+                *pchDest++ = '\\';
+        } else if (*pch == '\n')
+            pr->nLine++;
+
+        if (*pch)
+            *pchDest++ = *pch;
+    }
+    *pchDest = 0;
+
+    ArenaShrink(pr->psc, sz, cch + 1, (size_t) (pchDest - sz) + 1);
+
+    if (pchClose < pr->pchEnd)
+        pr->pch = pchClose + 1;
+    else {
+        pr->pch = pr->pchEnd;
+        ReaderError(pr, _("unexpected end of file in property value"), 1);
+    }
+
+    return sz;
+}
+
+static property *
+ReadProperty(sgfreader * pr)
+{
+    property *pp;
+    listOLD *plValues;
+    char ach[2] = { 0, 0 };
+    int i;
+
+    /* one or two upper case letters, with any lower case ones around them */
+    for (i = 0; i < 2; i++) {
+        while (pr->pch < pr->pchEnd && g_ascii_islower(*pr->pch))
+            pr->pch++;
+        if (pr->pch == pr->pchEnd || !g_ascii_isupper(*pr->pch))
+            break;
+        ach[i] = *pr->pch++;
+    }
+    while (pr->pch < pr->pchEnd && g_ascii_islower(*pr->pch))
+        pr->pch++;
+
+    plValues = NewList(pr->psc);
+
+    while (Peek(pr) == '[') {
+        pr->pch++;
+        Append(pr->psc, plValues, ReadValue(pr));
+    }
+
+    if (ListEmpty(plValues)) {
+        ReaderError(pr, _("property without a value"), 1);
+        return NULL;
+    }
+
+    pp = ArenaAlloc(pr->psc, sizeof(property));
+    pp->ach[0] = ach[0];
+    pp->ach[1] = ach[1];
+    pp->pl = plValues;
+
+    return pp;
+}
+
+/* Read the properties of a node after its semicolon. */
+static listOLD *
+ReadNode(sgfreader * pr)
+{
+    listOLD *pl = NewList(pr->psc);
+    int ch;
+
+    while ((ch = Peek(pr)) != EOF && ch != ';' && ch != '(' && ch != ')') {
+        property *pp;
+
+        if (!IsIdentifier(ch)) {
+            ReaderError(pr, ch == '[' ? _("property value without an identifier") :
+                        _("illegal character in SGF file"), ch == '[');
+            pr->pch++;
+            if (ch == '[')
+                (void) ReadValue(pr);
+            continue;
+        }
+
+        if ((pp = ReadProperty(pr)))
+            Append(pr->psc, pl, pp);
+    }
+
+    return pl;
+}
+
+/* Skip the rest of a malformed game tree. */
+static void
+SkipGameTree(sgfreader * pr)
+{
+    int nDepth = 1;
+
+    while (pr->pch < pr->pchEnd) {
+        char ch = *pr->pch++;
+
+        if (ch == '\n')
+            pr->nLine++;
+        else if (ch == '[')
+            (void) ReadValue(pr);
+        else if (ch == '(')
+            nDepth++;
+        else if (ch == ')' && !--nDepth)
+            return;
+    }
+}
+
+/* Read a game tree after its opening parenthesis: the list holds the
+ * sequence of nodes followed by the variations. */
+static listOLD *
+ReadGameTree(sgfreader * pr)
+{
+    listOLD *plTree, *plSequence;
+    int ch;
+
+    if (++pr->nDepth > SGF_MAX_DEPTH) {
+        ReaderError(pr, _("variations nested too deeply"), 1);
+        SkipGameTree(pr);
+        pr->nDepth--;
+        return NULL;
+    }
+
+    plSequence = NewList(pr->psc);
+
+    while (Peek(pr) == ';') {
+        pr->pch++;
+        Append(pr->psc, plSequence, ReadNode(pr));
+    }
+
+    if (ListEmpty(plSequence)) {
+        ReaderError(pr, _("game tree without nodes"), 1);
+        SkipGameTree(pr);
+        pr->nDepth--;
+        return NULL;
+    }
+
+    plTree = NewList(pr->psc);
+    Append(pr->psc, plTree, plSequence);
+
+    while ((ch = Peek(pr)) != ')') {
+        if (ch == EOF) {
+            ReaderError(pr, _("unexpected end of file in game tree"), 1);
+            break;
+        }
+
+        pr->pch++;
+
+        if (ch == '(') {
+            listOLD *plVariation = ReadGameTree(pr);
+
+            if (plVariation)
+                Append(pr->psc, plTree, plVariation);
+        } else {
+            ReaderError(pr, _("illegal character in SGF file"), 0);
+            if (ch == '[')
+                (void) ReadValue(pr);
+        }
+    }
+
+    if (ch == ')')
+        pr->pch++;
+
+    pr->nDepth--;
+
+    return plTree;
+}
+
+extern listOLD *
+SGFParseBufferFull(const char *pch, size_t cch, sgferrorfunc pfError, void *pErrorData)
+{
+    sgfcollection *psc = g_new0(sgfcollection, 1);
+    sgfreader r;
+    int ch;
+
+    ListCreate(&psc->lCollection);
+
+    r.pch = pch;
+    r.pchEnd = pch + cch;
+    r.psc = psc;
+    r.nLine = 1;
+    r.nDepth = 0;
+    r.pfError = pfError;
+    r.pErrorData = pErrorData;
+
+    /* The specification says empty collections are illegal, but
+     * we'll try to be accommodating. */
+    while ((ch = Peek(&r)) != EOF) {
+        r.pch++;
+
+        if (ch == '(') {
+            listOLD *plTree = ReadGameTree(&r);
+
+            if (plTree)
+                Append(psc, &psc->lCollection, plTree);
+        } else {
+            ReaderError(&r, _("illegal character in SGF file"), 0);
+            if (ch == '[')
+                (void) ReadValue(&r);
+        }
+    }
+
+    return &psc->lCollection;
+}
+
+extern listOLD *
+SGFParseBuffer(const char *pch, size_t cch)
+{
+    return SGFParseBufferFull(pch, cch, NULL, NULL);
+}
+
+extern listOLD *
+SGFParse(FILE * pf)
+{
+    listOLD *pl;
+    char *pch = NULL;
+    size_t cch = 0, cchAlloc = 0, cchRead;
+
+    do {
+        if (cch == cchAlloc) {
+            cchAlloc = cchAlloc ? 2 * cchAlloc : SGF_BLOCK;
+            pch = g_realloc(pch, cchAlloc);
+        }
+        cch += (cchRead = fread(pch + cch, 1, cchAlloc - cch, pf));
+    } while (cchRead);
+
+    if (ferror(pf)) {
+        g_free(pch);
+        return NULL;
+    }
+
+    pl = SGFParseBuffer(pch, cch);
+
+    g_free(pch);
+
+    return pl;
+}
+
+extern void
+SGFFree(listOLD * plCollection)
+{
+    sgfcollection *psc = (sgfcollection *) plCollection;
+    sgfblock *pb;
+
+    while ((pb = psc->pbBlocks)) {
+        psc->pbBlocks = pb->pbNext;
+        g_free(pb);
+    }
+
+    g_free(psc);
+}
+
+#if defined(SGFTEST)
+
+/*
+ * Stand alone reader for testing: "sgftest file.sgf" prints the syntax
+ * tree.  The "load benchmark" command times loading whole matches.
+ */
+
+static void
+Indent(int n)
+{
+    while (n--)
+        putchar(' ');
+}
+
+static void
+PrintProperty(property * pp, int n)
+{
+    listOLD *pl;
+
+    Indent(n);
+    putchar(pp->ach[0]);
+    if (pp->ach[1])
+        putchar(pp->ach[1]);
+
+    for (pl = pp->pl->plNext; pl->p; pl = pl->plNext)
+        printf("[%s]", (char *) pl->p);
+
+    putchar('\n');
+}
+
+static void
+PrintNode(listOLD * pl, int n)
+{
+    for (pl = pl->plNext; pl->p; pl = pl->plNext)
+        PrintProperty(pl->p, n);
+
+    Indent(n);
+    puts("-");
+}
+
+static void
+PrintSequence(listOLD * pl, int n)
+{
+    for (pl = pl->plNext; pl->p; pl = pl->plNext)
+        PrintNode(pl->p, n);
+}
+
+static void PrintGameTreeSeq(listOLD * pl, int n);
+
+static void
+PrintGameTree(listOLD * pl, int n)
+{
+    pl = pl->plNext;
+
+    Indent(n);
+    puts("<<<<<");
+    PrintSequence(pl->p, n);
+    PrintGameTreeSeq(pl, n + 1);
+    Indent(n);
+    puts(">>>>>");
+}
+
+static void
+PrintGameTreeSeq(listOLD * pl, int n)
+{
+    for (pl = pl->plNext; pl->p; pl = pl->plNext)
+        PrintGameTree(pl->p, n);
+}
+
+static void
+Error(const char *s, int UNUSED(f))
+{
+    fprintf(stderr, _("sgf error: %s\n"), s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    FILE *pf = stdin;
+    listOLD *pl;
+
+    SGFErrorHandler = Error;
+
+    if (argc > 1 && !(pf = fopen(argv[1], "r"))) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (!(pl = SGFParse(pf))) {
+        puts(_("Fatal error; can't print collection."));
+        fclose(pf);
+        return 2;
+    }
+
+    PrintGameTreeSeq(pl, 0);
+    SGFFree(pl);
+
+    fclose(pf);
+    return 0;
+}
+#endif
@@ -40,10 +40,13 @@
 #include "osr.h"
 #include "positionid.h"
 #include "boarddim.h"
+#include "book.h"
 #include "credits.h"
 #include "util.h"
 #include "openurl.h"
 #include "multithread.h"
+#include "mttrace.h"
+#include "numa.h"
 
 #if defined(USE_GTK)
 #include "gtkboard.h"
@@ -373,6 +376,9 @@ CommandShowAnalysis(char *UNUSED(sz))
 
     outputl(fAnalyseDice ? _("Dice rolls will be analysed.") : _("Dice rolls will not be analysed."));
 
+    outputl(fAnalyseIncremental ? _("Reanalysis will keep the stored luck of dice rolls.") :
+            _("Reanalysis will recompute the luck of dice rolls."));
+
     if (fAnalyseMove) {
         outputl(_("Chequer play will be analysed."));
     } else
@@ -705,10 +711,24 @@ CommandShowDisplay(char *UNUSED(sz))
 }
 
 extern void
-CommandShowEngine(char *UNUSED(sz))
+CommandShowEngine(char *sz)
 {
 
     char szBuffer[4096];
+    char *pch = NextToken(&sz);
+
+    if (pch && !StrNCaseCmp(pch, "statistics", strlen(pch))) {
+        enginestats es;
+        char *szStats;
+
+        EngineStatsSum(&es);
+        szStats = EngineStatsFormat(&es);
+        output(szStats);
+        g_free(szStats);
+        if (nEngineStatsLog)
+            outputf(_("Engine statistics are logged every %u seconds.\n"), nEngineStatsLog);
+        return;
+    }
 
     EvalStatus(szBuffer);
 
@@ -929,6 +949,21 @@ CommandShowSeed(char *UNUSED(sz))
     PrintRNGCounter(rngCurrent, rngctxCurrent);
 }
 
+extern void
+CommandShowStartup(char *UNUSED(sz))
+{
+    unsigned int i, c;
+    const startupphase *asp = StartupPhases(&c);
+    gint64 usTotal = 0;
+
+    for (i = 0; i < c; i++) {
+        outputf("%-30s : %8.1f ms\n", gettext(asp[i].szPhase), asp[i].usTime / 1000.0);
+        usTotal += asp[i].usTime;
+    }
+
+    outputf("%-30s : %8.1f ms\n", _("Total"), usTotal / 1000.0);
+}
+
 extern void
 CommandShowTurn(char *UNUSED(sz))
 {
@@ -968,6 +1003,22 @@ ShowAuthors(const credEntry ace[], const char *title)
 
 }
 
+extern void
+CommandShowBook(char *UNUSED(sz))
+{
+    unsigned int cCube, cMove;
+
+    if (!fBook) {
+        outputl(_("No position book is used."));
+        return;
+    }
+
+    BookCounts(&cCube, &cMove);
+    outputf(_("Position book: %s\n"), BookGetFile());
+    outputf(_("%u cube decisions and %u move lists.\n"), cCube, cMove);
+    outputl(_("See `show engine statistics' for the number of book hits."));
+}
+
 extern void
 CommandShowBrowser(char *UNUSED(sz))
 {
@@ -1143,6 +1194,17 @@ CommandShowThreads(char *UNUSED(sz))
 {
     int c = MT_GetNumThreads();
     outputf(ngettext("%d calculation thread.\n", "%d calculation threads.\n", c), c);
+    if (fMTTrace)
+        outputf(_("Thread pool activity is traced to %s.\n"), MTTraceGetFile());
+}
+
+extern void
+CommandShowNuma(char *UNUSED(sz))
+{
+    char *szNuma = NumaFormat();
+
+    output(szNuma);
+    g_free(szNuma);
 }
 #endif
 
@@ -2236,12 +2298,14 @@ show_bearoff(TanBoard an, char *szTemp)
     case VARIATION_HYPERGAMMON_1:
     case VARIATION_HYPERGAMMON_2:
     case VARIATION_HYPERGAMMON_3:
+        {
+            bearoffcontext *pbc = HyperDatabase(ms.bgv - VARIATION_HYPERGAMMON_1);
 
-        if (isBearoff(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an)) {
-            BearoffDump(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an, szTemp);
-            outputl(szTemp);
+            if (isBearoff(pbc, (ConstTanBoard) an)) {
+                BearoffDump(pbc, (ConstTanBoard) an, szTemp);
+                outputl(szTemp);
+            }
         }
-
         break;
 
     default:
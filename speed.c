@@ -1,6 +1,6 @@
 /*
  * Copyright (C) 2003 Gary Wong <gtw@gnu.org>
- * Copyright (C) 2004-2018 the AUTHORS
+ * Copyright (C) 2004-2026 the AUTHORS
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -28,6 +28,8 @@
 #ifndef WIN32
 #include <stdlib.h>
 #endif
+#include <ctype.h>
+#include <string.h>
 
 #include "lib/isaac.h"
 #include "lib/simd.h"
@@ -37,36 +39,42 @@
 static randctx rc;
 static double timeTaken;
 
+/* Generate a random board.  Don't allow chequers on the bar or borne
+ * off, so we can trivially guarantee the position is legal. */
+static void
+RandomBoard(int anBoard[2][25])
+{
+    int j, k;
+
+    for (j = 0; j < 25; j++)
+        anBoard[0][j] = anBoard[1][j] = 0;
+
+    for (j = 0; j < 15; j++) {
+        do {
+            k = irand(&rc) % 24;
+        } while (anBoard[1][23 - k]);
+        anBoard[0][k]++;
+
+        do {
+            k = irand(&rc) % 24;
+        } while (anBoard[0][23 - k]);
+        anBoard[1][k]++;
+    }
+}
+
 static void
 RunEvals(void *UNUSED(notused))
 {
     int aanBoard[EVALS_PER_ITERATION][2][25];
-    int i, j, k;
+    int i;
     double t;
     SSE_ALIGN(float ar[NUM_OUTPUTS]);
 
 #if defined(USE_MULTITHREAD)
     MT_Exclusive();
 #endif
-    for (i = 0; i < EVALS_PER_ITERATION; i++) {
-        /* Generate a random board.  Don't allow chequers on the bar
-         * or borne off, so we can trivially guarantee the position
-         * is legal. */
-        for (j = 0; j < 25; j++)
-            aanBoard[i][0][j] = aanBoard[i][1][j] = 0;
-
-        for (j = 0; j < 15; j++) {
-            do {
-                k = irand(&rc) % 24;
-            } while (aanBoard[i][1][23 - k]);
-            aanBoard[i][0][k]++;
-
-            do {
-                k = irand(&rc) % 24;
-            } while (aanBoard[i][0][23 - k]);
-            aanBoard[i][1][k]++;
-        }
-    }
+    for (i = 0; i < EVALS_PER_ITERATION; i++)
+        RandomBoard(aanBoard[i]);
 
 #if defined(USE_MULTITHREAD)
     MT_Release();
@@ -87,6 +95,41 @@ RunEvals(void *UNUSED(notused))
 #endif
 }
 
+/* Time the neural net input encoding alone, over nIter batches of
+ * random contact positions, on the calling thread. */
+static void
+CalibrateInputs(int nIter)
+{
+    int aanBoard[EVALS_PER_ITERATION][2][25];
+    positionclass apc[EVALS_PER_ITERATION];
+    SSE_ALIGN(float arInput[512]);      /* more than any of the nets has */
+    double t, rTime = 0.0;
+    int i, iIter;
+
+    for (iIter = 0; iIter < nIter; iIter++) {
+        if (MT_SafeGet(&fInterrupt))
+            break;
+
+        for (i = 0; i < EVALS_PER_ITERATION; i++) {
+            RandomBoard(aanBoard[i]);
+            apc[i] = ClassifyPosition((ConstTanBoard) aanBoard[i], VARIATION_STANDARD);
+        }
+
+        t = get_time();
+
+        for (i = 0; i < EVALS_PER_ITERATION; i++)
+            (void) NetInputs((ConstTanBoard) aanBoard[i], apc[i], FALSE, arInput);
+
+        rTime += get_time() - t;
+    }
+
+    if (iIter > 0 && rTime > 0.0)
+        outputf(_("Calibration result: %.0f input encodings/second (%d positions).\n"),
+                iIter * (EVALS_PER_ITERATION * 1000 / rTime), iIter * EVALS_PER_ITERATION);
+    else
+        outputl(_("Calibration incomplete."));
+}
+
 extern void
 CommandCalibrate(char *sz)
 {
@@ -96,6 +139,30 @@ CommandCalibrate(char *sz)
     void *pcc = NULL;
 #endif
 
+    if (sz && *sz && !isdigit((unsigned char) *sz)) {
+        char *pch = NextToken(&sz);
+
+        if (StrNCaseCmp(pch, "inputs", strlen(pch))) {
+            outputerrf(_("Unknown keyword `%s'.\n"), pch);
+            return;
+        }
+
+        n = (sz && *sz) ? ParseNumber(&sz) : 1000;
+
+        if (n < 1) {
+            outputl(_("If you specify a parameter to `calibrate inputs', " "it must be a number of iterations to run."));
+            return;
+        }
+
+        rc.randrsl[0] = (ub4) time(NULL);
+        for (i = 0; i < RANDSIZ; i++)
+            rc.randrsl[i] = rc.randrsl[0];
+        irandinit(&rc, TRUE);
+
+        CalibrateInputs(n);
+        return;
+    }
+
     iCacheSize = GetEvalCacheEntries();
     EvalCacheResize(0);
 
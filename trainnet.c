@@ -0,0 +1,494 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Train one of the nets of a weights file by mini-batch backpropagation.
+ *
+ * The training files hold one position per line: its position ID and
+ * the five target outputs (win, win gammon, win backgammon, lose gammon,
+ * lose backgammon) for the player on roll, separated by white space.
+ * Empty lines and lines starting with `#' are skipped, as are positions
+ * that the net being trained would not evaluate.
+ *
+ * The files are read a chunk at a time, so they can be much larger than
+ * memory.  Each chunk is shuffled and cut into batches; the positions of
+ * a batch are shared out between the threads, which sum their gradients
+ * separately before the weights are moved.
+ *
+ * The result is written as a text weights file, which EvalInitialise
+ * loads as it is and makeweights turns into gnubg.wd.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eval.h"
+#include "positionid.h"
+#include "glib-ext.h"
+#include "multithread.h"
+#include "lib/simd.h"
+
+/* positions read, shuffled and trained on at a time */
+#define TRAIN_CHUNK 65536
+
+void
+MT_CloseThreads(void)
+{
+    return;
+}
+
+static const char *aszNet[] = {
+    "contact", "race", "crashed", "prune-contact", "prune-crashed", "prune-race"
+};
+
+static const positionclass apcNet[] = {
+    CLASS_CONTACT, CLASS_RACE, CLASS_CRASHED, CLASS_CONTACT, CLASS_CRASHED, CLASS_RACE
+};
+
+#define N_NETS G_N_ELEMENTS(aszNet)
+
+typedef struct {
+    positionkey key;
+    float arTarget[NUM_OUTPUTS];
+} trainposition;
+
+typedef struct {
+    FILE *pf;
+    char **aszFiles;
+    int iFile;
+    const char *szFile;
+    unsigned int iLine;
+    positionclass pc;
+    unsigned int cSkipped;
+} trainreader;
+
+typedef struct {
+    neuralnet *pnn;
+    positionclass pc;
+    int fPrune;
+    nngradient ng;
+    float *arInput;
+    const trainposition *atp;
+    unsigned int c;
+    double rError;
+    unsigned long cPositions;
+} trainworker;
+
+typedef struct {
+    GMutex mutex;
+    GCond cond;
+    unsigned int cPending;
+} trainbatch;
+
+static trainbatch tb;
+
+static int
+OpenNextFile(trainreader * ptr)
+{
+    if (ptr->pf) {
+        fclose(ptr->pf);
+        ptr->pf = NULL;
+    }
+
+    while (ptr->aszFiles[ptr->iFile]) {
+        ptr->szFile = ptr->aszFiles[ptr->iFile++];
+        ptr->iLine = 0;
+
+        if ((ptr->pf = g_fopen(ptr->szFile, "r")))
+            return TRUE;
+
+        g_printerr("%s: %s\n", ptr->szFile, g_strerror(errno));
+    }
+
+    return FALSE;
+}
+
+static int
+ParseTrainingLine(trainreader * ptr, char *sz, trainposition * ptp)
+{
+    TanBoard anBoard;
+    char *pch, *szID;
+    int i;
+
+    if (!(szID = strtok(sz, " \t\r\n")) || *szID == '#')
+        return FALSE;
+
+    if (!PositionFromID(anBoard, szID)) {
+        g_printerr(_("%s:%u: invalid position ID %s\n"), ptr->szFile, ptr->iLine, szID);
+        return FALSE;
+    }
+
+    for (i = 0; i < NUM_OUTPUTS; i++) {
+        if (!(pch = strtok(NULL, " \t\r\n"))) {
+            g_printerr(_("%s:%u: expected %d outputs\n"), ptr->szFile, ptr->iLine, NUM_OUTPUTS);
+            return FALSE;
+        }
+        ptp->arTarget[i] = (float) g_ascii_strtod(pch, NULL);
+    }
+
+    if (ClassifyPosition((ConstTanBoard) anBoard, VARIATION_STANDARD) != ptr->pc) {
+        ptr->cSkipped++;
+        return FALSE;
+    }
+
+    PositionKey((ConstTanBoard) anBoard, &ptp->key);
+
+    return TRUE;
+}
+
+/* Read up to TRAIN_CHUNK positions, moving on to the next file at the
+ * end of each one.  Returns the number read, 0 once all are used up. */
+static unsigned int
+ReadChunk(trainreader * ptr, trainposition * atp)
+{
+    char sz[256];
+    unsigned int c = 0;
+
+    if (!ptr->pf && !OpenNextFile(ptr))
+        return 0;
+
+    while (c < TRAIN_CHUNK) {
+        if (!fgets(sz, sizeof(sz), ptr->pf)) {
+            if (!OpenNextFile(ptr))
+                break;
+            continue;
+        }
+
+        ptr->iLine++;
+
+        if (ParseTrainingLine(ptr, sz, atp + c))
+            c++;
+    }
+
+    return c;
+}
+
+static void
+ShuffleChunk(GRand * pr, trainposition * atp, unsigned int c)
+{
+    unsigned int i, j;
+
+    for (i = c; i > 1; i--) {
+        trainposition tp;
+
+        j = (unsigned int) g_rand_int_range(pr, 0, (gint32) i);
+        tp = atp[i - 1];
+        atp[i - 1] = atp[j];
+        atp[j] = tp;
+    }
+}
+
+static void
+TrainSlice(trainworker * ptw, gpointer UNUSED(user_data))
+{
+    unsigned int i;
+
+    for (i = 0; i < ptw->c; i++) {
+        TanBoard anBoard;
+
+        PositionFromKey(anBoard, &ptw->atp[i].key);
+        NetInputs((ConstTanBoard) anBoard, ptw->pc, ptw->fPrune, ptw->arInput);
+        NeuralNetBackprop(ptw->pnn, ptw->arInput, ptw->atp[i].arTarget, &ptw->ng);
+    }
+
+    g_mutex_lock(&tb.mutex);
+    if (!--tb.cPending)
+        g_cond_signal(&tb.cond);
+    g_mutex_unlock(&tb.mutex);
+}
+
+/* Train on one batch: each worker sums the gradient over its share of
+ * the positions, then the weights take a step against the total. */
+static void
+TrainBatch(GThreadPool * pool, trainworker * atw, unsigned int cWorkers,
+           neuralnet * pnn, const trainposition * atp, unsigned int c, float rAlpha)
+{
+    unsigned int i, iFirst = 0;
+
+    tb.cPending = cWorkers;
+
+    for (i = 0; i < cWorkers; i++) {
+        atw[i].atp = atp + iFirst;
+        atw[i].c = (c * (i + 1)) / cWorkers - iFirst;
+        iFirst += atw[i].c;
+        g_thread_pool_push(pool, atw + i, NULL);
+    }
+
+    g_mutex_lock(&tb.mutex);
+    while (tb.cPending)
+        g_cond_wait(&tb.cond, &tb.mutex);
+    g_mutex_unlock(&tb.mutex);
+
+    for (i = 0; i < cWorkers; i++) {
+        NeuralNetApplyGradient(pnn, &atw[i].ng, rAlpha / (float) c);
+        atw[i].rError += atw[i].ng.rError;
+        atw[i].cPositions += atw[i].ng.cPositions;
+        NeuralNetGradientClear(&atw[i].ng);
+    }
+}
+
+static int
+CheckInputs(const neuralnet * pnn, positionclass pc, int fPrune)
+{
+    SSE_ALIGN(float arInput[512]);      /* more than any of the nets has */
+    TanBoard anBoard;
+
+    PositionFromID(anBoard, "4HPwATDgc/ABMA");  /* the starting position */
+
+    return NetInputs((ConstTanBoard) anBoard, pc, fPrune, arInput) == pnn->cInput;
+}
+
+static int
+LoadWeights(const char *szWeights, neuralnet ann[N_NETS])
+{
+    FILE *pf;
+    char szFileVersion[16];
+    unsigned int i;
+
+    if (!(pf = g_fopen(szWeights, "r"))) {
+        g_printerr("%s: %s\n", szWeights, g_strerror(errno));
+        return -1;
+    }
+
+    if (fscanf(pf, "GNU Backgammon %15s\n", szFileVersion) != 1 || strcmp(szFileVersion, WEIGHTS_VERSION)) {
+        g_printerr(_("%s: not a text weights file of version %s\n"), szWeights, WEIGHTS_VERSION);
+        fclose(pf);
+        return -1;
+    }
+
+    for (i = 0; i < N_NETS; i++)
+        if (NeuralNetLoad(ann + i, pf)) {
+            g_printerr(_("%s: failed to load the %s net\n"), szWeights, aszNet[i]);
+            fclose(pf);
+            return -1;
+        }
+
+    fclose(pf);
+    return 0;
+}
+
+static int
+SaveWeights(const char *szOutput, neuralnet ann[N_NETS])
+{
+    FILE *pf;
+    unsigned int i;
+
+    if (!(pf = g_fopen(szOutput, "w"))) {
+        g_printerr("%s: %s\n", szOutput, g_strerror(errno));
+        return -1;
+    }
+
+    fprintf(pf, "GNU Backgammon %s\n", WEIGHTS_VERSION);
+
+    for (i = 0; i < N_NETS; i++)
+        if (NeuralNetSave(ann + i, pf))
+            break;
+
+    if (fclose(pf) || i < N_NETS) {
+        g_printerr(_("%s: failed to write the weights\n"), szOutput);
+        return -1;
+    }
+
+    return 0;
+}
+
+extern int
+main(int argc, char **argv)
+{
+    char *szWeights = NULL, *szOutput = NULL, *szNet = NULL, *szAlpha = NULL;
+    char **aszFiles = NULL;
+    int nEpochs = 1, nBatch = 128, nThreads = 0, nSeed = 1;
+    neuralnet ann[N_NETS];
+    neuralnet *pnn;
+    trainworker *atw;
+    trainposition *atp;
+    GThreadPool *pool;
+    GRand *pr;
+    float rAlpha = 0.1f;
+    unsigned int iNet, i;
+    int iEpoch;
+
+    GOptionEntry ao[] = {
+        {"weights", 'w', 0, G_OPTION_ARG_FILENAME, &szWeights,
+         N_("Text weights file to start from (required)"), "filename"},
+        {"outfile", 'f', 0, G_OPTION_ARG_FILENAME, &szOutput,
+         N_("Text weights file to write (required)"), "filename"},
+        {"net", 'n', 0, G_OPTION_ARG_STRING, &szNet,
+         N_("Net to train: contact, race, crashed, prune-contact, prune-crashed or prune-race. Default is contact"),
+         "net"},
+        {"epochs", 'e', 0, G_OPTION_ARG_INT, &nEpochs,
+         N_("Number of passes over the training files. Default is 1"), "N"},
+        {"batch", 'b', 0, G_OPTION_ARG_INT, &nBatch,
+         N_("Number of positions per weight update. Default is 128"), "N"},
+        {"alpha", 'a', 0, G_OPTION_ARG_STRING, &szAlpha,
+         N_("Learning rate. Default is 0.1"), "A"},
+        {"threads", 't', 0, G_OPTION_ARG_INT, &nThreads,
+         N_("Number of threads. Default is the number of processors"), "N"},
+        {"seed", 's', 0, G_OPTION_ARG_INT, &nSeed,
+         N_("Seed for shuffling the positions. Default is 1"), "N"},
+        {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &aszFiles, NULL, NULL},
+        {NULL, 0, 0, (GOptionArg) 0, NULL, NULL, NULL}
+    };
+
+    GError *error = NULL;
+    GOptionContext *context;
+
+    /* i18n */
+
+    glib_ext_init();
+    MT_InitThreads();
+    setlocale(LC_ALL, "");
+    /* the weights files are read and written with the C locale */
+    setlocale(LC_NUMERIC, "C");
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+
+    g_set_print_handler(print_utf8_to_locale);
+    g_set_printerr_handler(print_utf8_to_locale);
+
+    context = g_option_context_new(_("training-file..."));
+    g_option_context_add_main_entries(context, ao, PACKAGE);
+    g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+
+    if (error) {
+        g_printerr("%s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+
+    /* parse options */
+
+    if (!szWeights || !szOutput || !aszFiles || !*aszFiles) {
+        g_printerr(_("Illegal options. Try `trainnet --help' for usage information\n"));
+        exit(EXIT_FAILURE);
+    }
+
+    for (iNet = 0; szNet && iNet < N_NETS && strcmp(szNet, aszNet[iNet]); iNet++);
+    if (iNet == N_NETS) {
+        g_printerr(_("Unknown net %s\n"), szNet);
+        exit(EXIT_FAILURE);
+    }
+
+    if (szAlpha)
+        rAlpha = (float) g_ascii_strtod(szAlpha, NULL);
+
+    if (nEpochs < 1 || nBatch < 1 || rAlpha <= 0.0f || nThreads < 0) {
+        g_printerr(_("Illegal options. Try `trainnet --help' for usage information\n"));
+        exit(EXIT_FAILURE);
+    }
+
+    if (!nThreads)
+        nThreads = (int) g_get_num_processors();
+
+    if (LoadWeights(szWeights, ann))
+        exit(EXIT_FAILURE);
+
+    pnn = ann + iNet;
+
+    if (!CheckInputs(pnn, apcNet[iNet], iNet >= 3)) {
+        g_printerr(_("%s: the %s net does not have the expected number of inputs\n"), szWeights, aszNet[iNet]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* start training */
+
+    pool = g_thread_pool_new((GFunc) TrainSlice, NULL, nThreads, TRUE, NULL);
+    atw = g_new0(trainworker, nThreads);
+    for (i = 0; i < (unsigned int) nThreads; i++) {
+        atw[i].pnn = pnn;
+        atw[i].pc = apcNet[iNet];
+        atw[i].fPrune = iNet >= 3;
+        atw[i].arInput = sse_malloc(pnn->cInput * sizeof(float));
+        if (NeuralNetGradientCreate(&atw[i].ng, pnn)) {
+            g_printerr(_("Failed to allocate the gradients\n"));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    atp = g_new(trainposition, TRAIN_CHUNK);
+    pr = g_rand_new_with_seed((guint32) nSeed);
+
+    g_print("%-20s: %s\n", _("Net"), aszNet[iNet]);
+    g_print("%-20s: %u-%u-%u\n", _("Size"), pnn->cInput, pnn->cHidden, pnn->cOutput);
+    g_print("%-20s: %d\n", _("Batch size"), nBatch);
+    g_print("%-20s: %g\n", _("Learning rate"), rAlpha);
+    g_print("%-20s: %d\n", _("Threads"), nThreads);
+
+    for (iEpoch = 1; iEpoch <= nEpochs; iEpoch++) {
+        trainreader tr;
+        unsigned int c, iFirst;
+        double rError = 0.0;
+        unsigned long cPositions = 0;
+
+        memset(&tr, 0, sizeof(tr));
+        tr.aszFiles = aszFiles;
+        tr.pc = apcNet[iNet];
+
+        while ((c = ReadChunk(&tr, atp))) {
+            ShuffleChunk(pr, atp, c);
+
+            for (iFirst = 0; iFirst < c; iFirst += (unsigned int) nBatch)
+                TrainBatch(pool, atw, (unsigned int) nThreads, pnn, atp + iFirst,
+                           MIN((unsigned int) nBatch, c - iFirst), rAlpha);
+        }
+
+        for (i = 0; i < (unsigned int) nThreads; i++) {
+            rError += atw[i].rError;
+            cPositions += atw[i].cPositions;
+            atw[i].rError = 0.0;
+            atw[i].cPositions = 0;
+        }
+
+        if (!cPositions) {
+            g_printerr(_("No %s positions in the training files\n"), aszNet[iNet]);
+            exit(EXIT_FAILURE);
+        }
+
+        pnn->nTrained += (int) cPositions;
+
+        g_print(_("Epoch %d: %lu positions (%u skipped), rms error %.6f\n"), iEpoch, cPositions,
+                tr.cSkipped, sqrt(rError / ((double) cPositions * pnn->cOutput)));
+    }
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    if (SaveWeights(szOutput, ann))
+        exit(EXIT_FAILURE);
+
+    for (i = 0; i < (unsigned int) nThreads; i++) {
+        NeuralNetGradientDestroy(&atw[i].ng);
+        sse_free(atw[i].arInput);
+    }
+    for (i = 0; i < N_NETS; i++)
+        NeuralNetDestroy(ann + i);
+
+    g_free(atw);
+    g_free(atp);
+    g_rand_free(pr);
+    g_strfreev(aszFiles);
+
+    return EXIT_SUCCESS;
+}
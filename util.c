@@ -152,3 +152,27 @@ GetTemporaryFile(const char *nameTemplate, char **retName)
 
     return pf;
 }
+
+static startupphase aStartup[MAX_STARTUP_PHASES];
+static unsigned int cStartup = 0;
+
+/* Record that the phase szPhase, begun at the monotonic time usStart,
+ * has just finished. Only called from the main thread during start-up. */
+
+extern void
+StartupPhase(const char *szPhase, gint64 usStart)
+{
+    if (cStartup == MAX_STARTUP_PHASES)
+        return;
+
+    aStartup[cStartup].szPhase = szPhase;
+    aStartup[cStartup].usTime = g_get_monotonic_time() - usStart;
+    cStartup++;
+}
+
+extern const startupphase *
+StartupPhases(unsigned int *pcPhases)
+{
+    *pcPhases = cStartup;
+    return aStartup;
+}
@@ -39,4 +39,16 @@ extern void PrintSystemError(const char *message);
 extern void PrintError(const char *message);
 extern FILE *GetTemporaryFile(const char *nameTemplate, char **retName);
 
+/* wall time spent in each phase of start-up */
+
+#define MAX_STARTUP_PHASES 16
+
+typedef struct {
+    const char *szPhase;        /* untranslated (N_) description */
+    gint64 usTime;              /* microseconds */
+} startupphase;
+
+extern void StartupPhase(const char *szPhase, gint64 usStart);
+extern const startupphase *StartupPhases(unsigned int *pcPhases);
+
 #endif